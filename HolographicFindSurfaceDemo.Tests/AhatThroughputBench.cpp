@@ -0,0 +1,100 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/FlyingPixelFilter.h"
+#include "Sensor/PointGridIndex.h"
+#include "Sensor/PointProbe.h"
+#include "Sensor/PointQuantization.h"
+#include "Sensor/WorkStealingPool.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+static constexpr double AHAT_FRAME_BUDGET_MS = 1000.0 / 45.0; // 45 fps
+static constexpr uint32_t BANDS_PER_THREAD = 4; // as SensorManager
+
+// The sensor thread stages of SensorManager::onProcessFrame() per AHAT frame, with every optional stage enabled:
+// flying pixel filter, (banded) unprojection, pixel index map, spatial index, quantization and the SoA copy.
+// Each stage cycles through the frames of `stream`, on the output of the previous stage for that frame.
+void HolographicFindSurfaceDemo::BenchAhatThroughput(const ReplayedFrames& stream)
+{
+	const size_t pixelCount = stream.unitPlane.size();
+	const size_t frameCount = stream.frames.size();
+	const uint32_t threads = (std::max)(1u, std::thread::hardware_concurrency());
+
+	FlyingPixelFilter filter;
+	WorkStealingPool pool(threads - 1);
+	std::vector<size_t> bandPointCounts;
+	std::vector<XMFLOAT3> points(pixelCount);
+	std::vector<BYTE> validMask((pixelCount + 7) / 8);
+	std::vector<UINT32> pixelToIndex(pixelCount);
+	std::vector<QuantizedPoint> quantized(pixelCount);
+	std::vector<float> pointsX(pixelCount), pointsY(pixelCount), pointsZ(pixelCount);
+	PointGridIndex gridIndex;
+
+	// Filtered depth, points and their quantized copy of each frame
+	std::vector<std::vector<UINT16>> filteredDepth(frameCount);
+	std::vector<DepthFrame> sources(frameCount);
+	std::vector<std::vector<XMFLOAT3>> framePoints(frameCount);
+	std::vector<std::vector<QuantizedPoint>> frameQuantized(frameCount);
+	size_t pointCount = 0;
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		const UINT16* pFiltered = filter.apply(stream.frames[i]);
+		filteredDepth[i].assign(pFiltered, pFiltered + pixelCount);
+
+		sources[i] = stream.frames[i];
+		sources[i].pDepth = filteredDepth[i].data();
+		sources[i].pSigma = nullptr;
+		sources[i].maxValidDepth = DEPTH_MAX_VALID_ANY;
+
+		framePoints[i].resize(pixelCount);
+		framePoints[i].resize(UnprojectDepth(framePoints[i].data(), sources[i].pDepth, nullptr, stream.unitPlane.data(), pixelCount, sources[i].maxValidDepth));
+		frameQuantized[i].resize(framePoints[i].size());
+		QuantizePoints(frameQuantized[i].data(), framePoints[i].data(), framePoints[i].size());
+		pointCount += framePoints[i].size();
+	}
+	pointCount /= frameCount;
+
+	constexpr int ITERATIONS = 50;
+	size_t next = 0;
+	struct Stage { const char* name; double ms; };
+	const Stage stages[] = {
+		{ "flying pixel filter", MeasureMilliseconds([&] { filter.apply(stream.frames[next++ % frameCount]); }, ITERATIONS) / ITERATIONS },
+		{ "unprojection (1 thread)", MeasureMilliseconds([&] {
+			const DepthFrame& source = sources[next++ % frameCount];
+			UnprojectDepth(points.data(), source.pDepth, nullptr, stream.unitPlane.data(), pixelCount, source.maxValidDepth);
+		}, ITERATIONS) / ITERATIONS },
+		{ "pixel index map", MeasureMilliseconds([&] {
+			const DepthFrame& source = sources[next++ % frameCount];
+			BuildPixelIndexMap(validMask.data(), pixelToIndex.data(), source.pDepth, nullptr, pixelCount, source.maxValidDepth);
+		}, ITERATIONS) / ITERATIONS },
+		{ "spatial index", MeasureMilliseconds([&] {
+			const std::vector<XMFLOAT3>& frame = framePoints[next++ % frameCount];
+			gridIndex.build(frame.data(), frame.size());
+		}, ITERATIONS) / ITERATIONS },
+		{ "quantization", MeasureMilliseconds([&] {
+			const std::vector<XMFLOAT3>& frame = framePoints[next++ % frameCount];
+			QuantizePoints(quantized.data(), frame.data(), frame.size());
+		}, ITERATIONS) / ITERATIONS },
+		{ "SoA copy", MeasureMilliseconds([&] {
+			const std::vector<QuantizedPoint>& frame = frameQuantized[next++ % frameCount];
+			SplitPoints(pointsX.data(), pointsY.data(), pointsZ.data(), frame.data(), frame.size());
+		}, ITERATIONS) / ITERATIONS },
+	};
+	const double parallelMs = MeasureMilliseconds([&] {
+		UnprojectDepthParallel(pool, points.data(), sources[next++ % frameCount], stream.unitPlane.data(), threads * BANDS_PER_THREAD, bandPointCounts);
+	}, ITERATIONS) / ITERATIONS;
+
+	double totalMs = 0.0;
+	printf("AHAT %s %ux%u pipeline (%zu frames), %zu points on average, budget %.1f ms per frame (45 fps):\n",
+		stream.name.c_str(), stream.width(), stream.height(), frameCount, pointCount, AHAT_FRAME_BUDGET_MS);
+	for (const Stage& stage : stages)
+	{
+		printf("  %-26s %7.3f ms\n", stage.name, stage.ms);
+		totalMs += stage.ms;
+	}
+	const double totalParallelMs = totalMs - stages[1].ms + parallelMs;
+	printf("  %-26s %7.3f ms\n", "unprojection (N threads)", parallelMs);
+	printf("  total, 1 thread:  %.3f ms (%.0f%% of budget, %.0f fps)\n", totalMs, 100.0 * totalMs / AHAT_FRAME_BUDGET_MS, 1000.0 / totalMs);
+	printf("  total, %u threads: %.3f ms (%.0f%% of budget, %.0f fps)\n", threads, totalParallelMs, 100.0 * totalParallelMs / AHAT_FRAME_BUDGET_MS, 1000.0 / totalParallelMs);
+}
@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/DepthRecordingFile.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Rig pose of the recorded frame `index`, none for every third frame (rig not located)
+static bool _getRigPose(size_t index, XMFLOAT4X4& rigPose)
+{
+	if (index % 3 == 1) { return false; }
+	XMStoreFloat4x4(&rigPose, XMMatrixMultiply(XMMatrixRotationY(0.1f * index), XMMatrixTranslation(0.02f * index, 1.6f, -0.01f * index)));
+	return true;
+}
+
+// Writes `recording` to `path`, maps it back and replays it: everything comes back bit for bit
+static bool _testRoundTrip(const InMemoryDepthRecording& recording, bool hasSigma, const std::wstring& path)
+{
+	const size_t pixelCount = static_cast<size_t>(recording.width()) * recording.height();
+	DepthFrame frame;
+	recording.getFrame(0, frame);
+	const UINT16 maxValidDepth = frame.maxValidDepth;
+
+	{
+		DepthRecordingWriter writer(path, recording.width(), recording.height(), hasSigma, maxValidDepth, recording.extrinsics(), recording.unitPlane());
+		for (size_t i = 0; i < recording.frameCount(); i++)
+		{
+			XMFLOAT4X4 rigPose;
+			recording.getFrame(i, frame);
+			writer.writeFrame(frame, _getRigPose(i, rigPose) ? &rigPose : nullptr);
+		}
+		writer.finish();
+		if (!Check(writer.frameCount() == recording.frameCount(), "writer lost frames")) { return false; }
+	}
+
+	bool passed = true;
+	auto pMapped = std::make_shared<MappedDepthRecording>(path);
+	passed &= Check(pMapped->width() == recording.width() && pMapped->height() == recording.height() && pMapped->frameCount() == recording.frameCount(),
+		"mapped resolution or frame count differs");
+	passed &= Check(memcmp(pMapped->unitPlane(), recording.unitPlane(), pixelCount * sizeof(XMFLOAT2)) == 0, "mapped unit plane differs");
+	passed &= Check(memcmp(&pMapped->extrinsics(), &recording.extrinsics(), sizeof(XMFLOAT4X4)) == 0, "mapped extrinsics differ");
+	if (!passed) { return false; }
+
+	DepthReplaySource source(pMapped, DepthReplaySource::PACING_AS_FAST_AS_POSSIBLE);
+	source.open();
+	for (size_t i = 0; i < recording.frameCount(); i++)
+	{
+		DepthFrame recorded, replayed;
+		recording.getFrame(i, recorded);
+		if (!Check(source.acquireFrame(replayed), "replay of the mapped recording ended early")) { return false; }
+
+		passed &= Check(replayed.width == recorded.width && replayed.height == recorded.height, "replayed resolution differs");
+		passed &= Check(replayed.hostTicks == recorded.hostTicks, "replayed ticks differ");
+		passed &= Check(replayed.maxValidDepth == recorded.maxValidDepth, "replayed maxValidDepth differs");
+		passed &= Check(memcmp(replayed.pDepth, recorded.pDepth, pixelCount * sizeof(UINT16)) == 0, "replayed depth differs");
+		passed &= Check(hasSigma ? (replayed.pSigma && memcmp(replayed.pSigma, recorded.pSigma, pixelCount) == 0) : !replayed.pSigma, "replayed sigma differs");
+
+		XMFLOAT4X4 rigPose;
+		const bool hasRigPose = _getRigPose(i, rigPose);
+		passed &= Check(hasRigPose ? (replayed.pRigPose && memcmp(replayed.pRigPose, &rigPose, sizeof(XMFLOAT4X4)) == 0) : !replayed.pRigPose, "replayed rig pose differs");
+		source.releaseFrame();
+	}
+	DepthFrame extra;
+	passed &= Check(!source.acquireFrame(extra) && source.isEndOfStream(), "replay of the mapped recording did not end");
+	source.close();
+	return passed;
+}
+
+bool HolographicFindSurfaceDemo::TestDepthRecording()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::wstring longThrowPath = (directory / L"DepthRecordingTest_LongThrow.bin").wstring();
+	const std::wstring ahatPath = (directory / L"DepthRecordingTest_Ahat.bin").wstring();
+
+	bool passed = true;
+	try
+	{
+		passed &= _testRoundTrip(*MakeSyntheticRecording(SyntheticDepth::LongThrow, 4, 2'000'000), true, longThrowPath); // with sigma
+		passed &= _testRoundTrip(*MakeSyntheticRecording(SyntheticDepth::Ahat, 4, 222'222), false, ahatPath);          // DEPTH_AHAT_MAX_VALID
+	}
+	catch (const winrt::hresult_error&)
+	{
+		passed = Check(false, "recording file could not be written or mapped");
+	}
+	catch (const std::exception& e)
+	{
+		passed = Check(false, e.what());
+	}
+
+	std::error_code ec;
+	std::filesystem::remove(longThrowPath, ec);
+	std::filesystem::remove(ahatPath, ec);
+	return passed;
+}
@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/DepthReplaySource.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// The replayed frame is frame `index` of the recording, buffers included
+static bool _isRecordedFrame(const DepthFrame& frame, const DepthRecording& recording, size_t index)
+{
+	DepthFrame recorded;
+	return recording.getFrame(index, recorded)
+		&& frame.width == recorded.width && frame.height == recorded.height && frame.hostTicks == recorded.hostTicks
+		&& frame.pDepth == recorded.pDepth && frame.pSigma == recorded.pSigma && frame.maxValidDepth == recorded.maxValidDepth;
+}
+
+bool HolographicFindSurfaceDemo::TestDepthReplay()
+{
+	constexpr size_t FRAME_COUNT = 4;
+	const std::shared_ptr<const DepthRecording> pRecording = MakeSyntheticRecording(SyntheticDepth::LongThrow, FRAME_COUNT, 2'000'000); // 5 fps
+	const SyntheticDepth first = SyntheticDepth::LongThrow(1);
+
+	bool passed = true;
+	DepthFrame frame;
+
+	// As fast as possible: every frame in recorded order, then the end of the stream
+	{
+		DepthReplaySource source(pRecording, DepthReplaySource::PACING_AS_FAST_AS_POSSIBLE);
+		passed &= Check(source.open(), "open() failed");
+		for (size_t i = 0; i < FRAME_COUNT; i++)
+		{
+			frame = DepthFrame();
+			passed &= Check(source.acquireFrame(frame) && _isRecordedFrame(frame, *pRecording, i), "frame replayed out of order");
+			source.releaseFrame();
+		}
+		passed &= Check(!source.acquireFrame(frame) && source.isEndOfStream(), "replay did not end after the last frame");
+
+		// Reopened, the replay starts over
+		passed &= Check(source.open() && !source.isEndOfStream() && source.acquireFrame(frame) && _isRecordedFrame(frame, *pRecording, 0), "reopened replay did not start over");
+		source.close();
+
+		// The recorded buffers are the ones of the synthetic frame
+		passed &= Check(memcmp(frame.pDepth, first.depth.data(), first.depth.size() * sizeof(UINT16)) == 0
+			&& memcmp(frame.pSigma, first.sigma.data(), first.sigma.size()) == 0, "recorded depth or sigma differs");
+	}
+
+	// Looped: the first frame follows the last one
+	{
+		DepthReplaySource source(pRecording, DepthReplaySource::PACING_AS_FAST_AS_POSSIBLE);
+		source.setLoop(true);
+		source.open();
+		bool inOrder = true;
+		for (size_t i = 0; i < 2 * FRAME_COUNT + 1; i++) {
+			inOrder &= source.acquireFrame(frame) && _isRecordedFrame(frame, *pRecording, i % FRAME_COUNT);
+		}
+		passed &= Check(inOrder && !source.isEndOfStream(), "looped replay out of order");
+		source.close();
+	}
+
+	// Stepped: an interrupted wait delivers the same frame next time, one frame per step
+	{
+		DepthReplaySource source(pRecording, DepthReplaySource::PACING_STEPPED);
+		source.open();
+		source.interrupt();
+		passed &= Check(!source.acquireFrame(frame) && !source.isEndOfStream(), "interrupted acquireFrame() returned a frame");
+
+		std::thread stepper([&source] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			source.step(2);
+		});
+		const bool isFirst = source.acquireFrame(frame) && _isRecordedFrame(frame, *pRecording, 0);
+		const bool isSecond = source.acquireFrame(frame) && _isRecordedFrame(frame, *pRecording, 1);
+		stepper.join();
+		passed &= Check(isFirst && isSecond, "stepped replay skipped a frame");
+		source.close();
+	}
+
+	// Calibration comes from the recording
+	{
+		DepthReplaySource source(pRecording);
+		const float uv[2] = { 17.0f, 203.0f };
+		float xy[2] = {};
+		const XMFLOAT4& unit = first.unitPlane[203 * first.width + 17];
+		passed &= Check(source.mapImagePointToCameraUnitPlane(uv, xy) && xy[0] == unit.x && xy[1] == unit.y, "unit plane differs from the recording");
+
+		const float outside[2] = { static_cast<float>(first.width), 0.0f };
+		passed &= Check(!source.mapImagePointToCameraUnitPlane(outside, xy), "mapped a pixel outside the image");
+
+		XMFLOAT4X4 extrinsic;
+		source.getCameraExtrinsics(&extrinsic);
+		passed &= Check(memcmp(&extrinsic, &pRecording->extrinsics(), sizeof(XMFLOAT4X4)) == 0, "extrinsics differ from the recording");
+	}
+	return passed;
+}
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/FlyingPixelFilter.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+static bool _isFilterEqual(FlyingPixelFilter& filter, const DepthFrame& frame)
+{
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+	std::vector<UINT16> reference(pixelCount);
+	filter.applyReference(reference.data(), frame);
+	const UINT16* pFiltered = filter.apply(frame);
+	return memcmp(pFiltered, reference.data(), pixelCount * sizeof(UINT16)) == 0;
+}
+
+bool HolographicFindSurfaceDemo::TestFlyingPixelFilter()
+{
+	bool passed = true;
+	for (const SyntheticDepth& data : { SyntheticDepth::LongThrow(6), SyntheticDepth::Ahat(7) })
+	{
+		// Default, tight and loose thresholds (the relative term is rounded to 0.16 fixed point)
+		const std::pair<UINT16, float> thresholds[] = { { 25, 0.02f }, { 0, 0.0f }, { 5, 0.001f }, { 200, 0.3f }, { 0xFFFF, 0.99f } };
+		for (const auto& threshold : thresholds)
+		{
+			FlyingPixelFilter filter(threshold.first, threshold.second);
+			passed &= Check(_isFilterEqual(filter, data.frame()), "apply() differs from applyReference()");
+		}
+	}
+
+	// Widths that are not a multiple of the vector width, and images of one row or column
+	for (const auto& size : { std::make_pair(1u, 1u), std::make_pair(7u, 3u), std::make_pair(1u, 33u), std::make_pair(33u, 1u), std::make_pair(37u, 29u) })
+	{
+		const SyntheticDepth data = SyntheticDepth::Make(size.first, size.second, 20.0f, 0xFFFF, true, 8);
+		FlyingPixelFilter filter;
+		passed &= Check(_isFilterEqual(filter, data.frame()), "apply() differs from applyReference() on a small image");
+	}
+	return passed;
+}
@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/ImageSpacePicker.h"
+#include "Sensor/PointQuantization.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Organized frame as SensorManager keeps it: packed points, quantized copy, pixel map and the projection of the unit plane
+struct OrganizedFrame
+{
+	UINT32 width = 0;
+	UINT32 height = 0;
+	std::vector<XMFLOAT3> points;
+	std::vector<QuantizedPoint> quantized;
+	std::vector<BYTE> validMask;
+	std::vector<UINT32> pixelToIndex;
+	std::shared_ptr<const DepthImageProjection> projection;
+
+	explicit OrganizedFrame(SyntheticDepth data)
+	{
+		width = data.width;
+		height = data.height;
+
+		// Barrel distortion of a wide angle lens, the projection must not assume a pinhole
+		for (XMFLOAT4& p : data.unitPlane)
+		{
+			const float rSq = p.x * p.x + p.y * p.y;
+			const float scale = 1.0f + 0.12f * rSq + 0.03f * rSq * rSq;
+			p.x *= scale;
+			p.y *= scale;
+			p.z = sqrtf(1.0f + p.x * p.x + p.y * p.y);
+			p.w = 1.0f / p.z;
+		}
+
+		const size_t pixelCount = data.depth.size();
+		points.resize(pixelCount);
+		points.resize(UnprojectDepth(points.data(), data.depth.data(), data.sigma.empty() ? nullptr : data.sigma.data(), data.unitPlane.data(), pixelCount, data.maxValidDepth));
+		quantized.resize(points.size());
+		QuantizePoints(quantized.data(), points.data(), points.size());
+
+		validMask.resize((pixelCount + 7) / 8);
+		pixelToIndex.resize(pixelCount);
+		BuildPixelIndexMap(validMask.data(), pixelToIndex.data(), data.depth.data(), data.sigma.empty() ? nullptr : data.sigma.data(), pixelCount, data.maxValidDepth);
+		projection = DepthImageProjection::Build(data.unitPlane.data(), width, height);
+	}
+};
+
+// pick() and pickCoherent() pick a point only if pickPoint() picks it inside the probe radius, then they pick the same one
+template <typename TPoint>
+static bool _isPickEqual(bool isPicked, int picked, const XMFLOAT3& origin, const XMFLOAT3& direction, const std::vector<TPoint>& points, XMMATRIX model)
+{
+	const int expected = PickPointReference(origin, direction, points.data(), points.size(), model);
+	const bool isInside = expected >= 0 && IsInsideProbeReference(origin, direction, points[expected], model);
+	return isPicked ? (isInside && picked == expected) : (!isInside && picked == -1);
+}
+
+// Gaze over the frame: fixations with jitter and slow drift, a saccade every 40 picks and now and then a look at the sky.
+// `coherentPicker` keeps its last hit from the previous sequence (other points, maybe another resolution).
+template <typename TPoint>
+static bool _testGazeSequence(const OrganizedFrame& frame, const std::vector<TPoint>& points, XMMATRIX model, uint32_t seed, int pickCount,
+	ImageSpacePicker& coherentPicker, int& insideCount)
+{
+	std::mt19937 rng(seed);
+	std::normal_distribution<float> jitter(0.0f, 0.003f); // ~0.2 degree
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_int_distribution<size_t> pointIdx(0, points.size() - 1);
+
+	ImageSpacePicker picker;
+	bool passed = true;
+
+	XMVECTOR target = XMVector3TransformCoord(LoadPickPointReference(points[pointIdx(rng)]), model);
+	XMVECTOR drift = XMVectorZero();
+	for (int i = 0; i < pickCount; i++)
+	{
+		if (i % 40 == 39)
+		{
+			target = XMVector3TransformCoord(LoadPickPointReference(points[pointIdx(rng)]), model);
+			drift = XMVectorScale(XMVectorSet(unit(rng), unit(rng), unit(rng), 0.0f), 0.004f);
+		}
+		target = XMVectorAdd(target, drift);
+
+		// Head moves a little around the camera
+		const XMVECTOR origin = XMVector3TransformCoord(XMVectorSet(0.02f * unit(rng), 0.02f * unit(rng), 0.02f * unit(rng), 0.0f), model);
+		XMVECTOR direction = XMVector3Normalize(XMVectorSubtract(target, origin));
+		direction = XMVectorAdd(direction, XMVectorSet(jitter(rng), jitter(rng), jitter(rng), 0.0f));
+		if (i % 97 == 50) { direction = XMVector3TransformNormal(XMVectorSet(0.0f, -1.0f, 0.1f, 0.0f), model); } // above the frame
+
+		XMFLOAT3 o, d;
+		XMStoreFloat3(&o, origin);
+		XMStoreFloat3(&d, XMVector3Normalize(direction));
+
+		int picked = -2;
+		bool isPicked = picker.pick(*frame.projection, frame.pixelToIndex.data(), o, d, points.data(), points.size(), model, picked);
+		passed &= Check(_isPickEqual(isPicked, picked, o, d, points, model), "pick() differs from pickPoint()");
+		if (isPicked) { insideCount++; }
+
+		isPicked = coherentPicker.pickCoherent(*frame.projection, frame.pixelToIndex.data(), o, d, points.data(), points.size(), model, picked);
+		passed &= Check(_isPickEqual(isPicked, picked, o, d, points, model), "pickCoherent() differs from pickPoint()");
+	}
+	return passed;
+}
+
+bool HolographicFindSurfaceDemo::TestImageSpacePicker()
+{
+	// Camera 1.6 m above the floor of the stationary frame, turned a little
+	const XMMATRIX model = XMMatrixMultiply(XMMatrixMultiply(XMMatrixRotationX(0.15f), XMMatrixRotationY(-0.5f)), XMMatrixTranslation(0.3f, 1.6f, -0.2f));
+
+	bool passed = true;
+	int insideCount = 0;
+	uint32_t seed = 20;
+	ImageSpacePicker coherentPicker; // across both sensors, as when the depth sensor is switched at runtime
+	for (const SyntheticDepth& data : { SyntheticDepth::LongThrow(12), SyntheticDepth::Ahat(13) })
+	{
+		const OrganizedFrame frame(data);
+		if (!Check(frame.projection != nullptr, "DepthImageProjection::Build() failed")) { return false; }
+
+		passed &= _testGazeSequence(frame, frame.points, model, seed++, 150, coherentPicker, insideCount);
+		passed &= _testGazeSequence(frame, frame.quantized, model, seed++, 150, coherentPicker, insideCount);
+
+		// A pixel map of other points is refused
+		ImageSpacePicker picker;
+		int picked = 0;
+		const XMFLOAT3 o(0.0f, 0.0f, 0.0f), d(0.0f, 0.0f, 1.0f);
+		passed &= Check(!picker.pick(*frame.projection, frame.pixelToIndex.data(), o, d, frame.points.data(), 1, XMMatrixIdentity(), picked) && picked == -1,
+			"pick() accepted the pixel map of other points");
+	}
+	passed &= Check(insideCount > 100, "too few gaze rays hit the frame");
+	return passed;
+}
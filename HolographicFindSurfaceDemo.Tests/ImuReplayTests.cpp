@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/ImuPoseInterpolator.h"
+#include "Sensor/ImuReplaySource.h"
+#include "Sensor/ImuStream.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+bool HolographicFindSurfaceDemo::TestImuReplay()
+{
+	constexpr UINT64 START_TICKS = 133'000'000'000'000'000ull; // host clock of a recent date
+	constexpr UINT64 SAMPLE_TICKS = 10'000;                    // 1 kHz
+	constexpr size_t SAMPLE_COUNT = 1000;
+	constexpr float TICKS_TO_SECOND = 1e-7f;
+
+	// Head turning at a constant rate, in the gyroscope frame
+	const XMFLOAT3 omega(0.4f, -1.5f, 0.7f);
+	auto pSamples = std::make_shared<std::vector<ImuSample>>(SAMPLE_COUNT);
+	for (size_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		(*pSamples)[i].hostTicks = START_TICKS + i * SAMPLE_TICKS;
+		(*pSamples)[i].value = omega;
+	}
+
+	XMFLOAT4X4 extrinsic;
+	XMStoreFloat4x4(&extrinsic, XMMatrixIdentity());
+
+	// Replayed through the acquisition thread into the ring, as the live gyroscope
+	bool passed = true;
+	ImuStream stream(std::make_unique<ImuReplaySource>(pSamples, extrinsic, ImuReplaySource::PACING_AS_FAST_AS_POSSIBLE, 32));
+	stream.start();
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (stream.gyro().latestTicks() < pSamples->back().hostTicks && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	stream.stop();
+	if (!Check(stream.gyro().size() == SAMPLE_COUNT, "ImuStream did not replay every sample")) { return false; }
+
+	// Gyroscope mounted turned against the camera, the translation is ignored
+	const XMMATRIX imuToCamera = XMMatrixMultiply(XMMatrixMultiply(XMMatrixRotationX(0.3f), XMMatrixRotationY(-0.8f)), XMMatrixTranslation(0.05f, 0.0f, 0.02f));
+	XMFLOAT4X4 imuToCameraF;
+	XMStoreFloat4x4(&imuToCameraF, imuToCamera);
+	ImuPoseInterpolator interpolator;
+	interpolator.setTargetFrame(imuToCameraF);
+
+	const XMVECTOR axis = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&omega), imuToCamera));
+	const float speed = XMVectorGetX(XMVector3Length(XMLoadFloat3(&omega)));
+	const XMVECTOR probe = XMVector3Normalize(XMVectorSet(0.3f, 0.5f, 0.8f, 0.0f));
+
+	// Rows of a readout between the samples, the reference timestamp before, among and after the rows
+	const UINT64 firstTicks = START_TICKS + 200 * SAMPLE_TICKS + 3'333;
+	const UINT64 stepTicks = 1'234;
+	const size_t count = 288;
+	const UINT64 lastTicks = firstTicks + stepTicks * (count - 1);
+
+	float maxError = 0.0f;
+	std::vector<XMFLOAT4> rotations(count);
+	for (UINT64 referenceTicks : { firstTicks - 50'000, firstTicks + 150'077, lastTicks + 420'000 })
+	{
+		if (!Check(interpolator.getRotations(stream.gyro(), referenceTicks, firstTicks, stepTicks, count, rotations.data()), "getRotations() failed inside the ring")) {
+			passed = false;
+			continue;
+		}
+
+		// Directions observed at `ticks` are seen turned by the head rotation since the reference timestamp
+		for (size_t i = 0; i < count; i++)
+		{
+			const INT64 elapsed = static_cast<INT64>(firstTicks + stepTicks * i) - static_cast<INT64>(referenceTicks);
+			const XMVECTOR expected = XMQuaternionRotationNormal(axis, speed * static_cast<float>(elapsed) * TICKS_TO_SECOND);
+			const XMVECTOR error = XMVectorSubtract(XMVector3Rotate(probe, XMLoadFloat4(&rotations[i])), XMVector3Rotate(probe, expected));
+			maxError = (std::max)(maxError, XMVectorGetX(XMVector3Length(error)));
+		}
+	}
+	passed &= Check(maxError < 1e-4f, "getRotations() differs from the constant rate rotation");
+
+	// Timestamps the ring does not cover
+	XMFLOAT4 rotation;
+	passed &= Check(!interpolator.getRotation(stream.gyro(), firstTicks, START_TICKS - 1, rotation), "getRotation() before the first sample");
+	passed &= Check(!interpolator.getRotation(stream.gyro(), firstTicks, pSamples->back().hostTicks + 1, rotation), "getRotation() after the latest sample");
+	return passed;
+}
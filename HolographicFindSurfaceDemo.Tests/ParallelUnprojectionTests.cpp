@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/WorkStealingPool.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+static constexpr uint32_t BANDS_PER_THREAD = 4; // as SensorManager
+
+bool HolographicFindSurfaceDemo::TestParallelUnprojection()
+{
+	bool passed = true;
+	const uint32_t maxThreads = (std::max)(4u, std::thread::hardware_concurrency());
+	for (const SyntheticDepth& data : { SyntheticDepth::LongThrow(3), SyntheticDepth::Ahat(4) })
+	{
+		const DepthFrame frame = data.frame();
+		const size_t pixelCount = data.depth.size();
+
+		std::vector<XMFLOAT3> single(pixelCount);
+		const size_t singleCount = UnprojectDepth(single.data(), frame.pDepth, frame.pSigma, data.unitPlane.data(), pixelCount, frame.maxValidDepth);
+
+		std::vector<XMFLOAT3> banded(pixelCount);
+		std::vector<size_t> bandPointCounts;
+		for (uint32_t threads = 1; threads <= maxThreads; threads++)
+		{
+			WorkStealingPool pool(threads - 1);
+			const size_t bandedCount = UnprojectDepthParallel(pool, banded.data(), frame, data.unitPlane.data(), threads * BANDS_PER_THREAD, bandPointCounts);
+			passed &= Check(bandedCount == singleCount && memcmp(banded.data(), single.data(), singleCount * sizeof(XMFLOAT3)) == 0, "banded output differs from UnprojectDepth()");
+		}
+	}
+	return passed;
+}
+
+void HolographicFindSurfaceDemo::BenchParallelUnprojection(const ReplayedFrames& stream)
+{
+	const uint32_t maxThreads = (std::max)(1u, std::thread::hardware_concurrency());
+	std::vector<XMFLOAT3> points(stream.unitPlane.size());
+	std::vector<size_t> bandPointCounts;
+
+	constexpr int ITERATIONS = 100;
+	size_t next = 0;
+	double singleMs = 0.0;
+	for (uint32_t threads = 1; threads <= maxThreads; threads++)
+	{
+		WorkStealingPool pool(threads - 1);
+		const double ms = MeasureMilliseconds([&] {
+			const DepthFrame& frame = stream.frames[next++ % stream.frames.size()];
+			UnprojectDepthParallel(pool, points.data(), frame, stream.unitPlane.data(), threads * BANDS_PER_THREAD, bandPointCounts);
+		}, ITERATIONS) / ITERATIONS;
+		if (threads == 1) { singleMs = ms; }
+
+		printf("UnprojectDepthParallel %s %ux%u, %u threads: %.3f ms (speedup x%.2f, efficiency %.0f%%)\n",
+			stream.name.c_str(), stream.width(), stream.height(), threads, ms, singleMs / ms, 100.0 * singleMs / (ms * threads));
+	}
+}
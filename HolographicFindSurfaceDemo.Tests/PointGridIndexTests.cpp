@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/PointGridIndex.h"
+#include "Sensor/PointQuantization.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+bool HolographicFindSurfaceDemo::TestPointGridIndex()
+{
+	const SyntheticDepth data = SyntheticDepth::LongThrow(10);
+	std::vector<XMFLOAT3> points(data.depth.size());
+	points.resize(UnprojectDepth(points.data(), data.depth.data(), nullptr, data.unitPlane.data(), data.depth.size(), data.maxValidDepth));
+	std::vector<QuantizedPoint> quantized(points.size());
+	QuantizePoints(quantized.data(), points.data(), points.size());
+	std::vector<XMFLOAT3> decoded(points.size());
+	DequantizePoints(decoded.data(), quantized.data(), quantized.size());
+
+	// Camera 1.6 m above the floor of the stationary frame, turned a little
+	const XMMATRIX model = XMMatrixMultiply(XMMatrixMultiply(XMMatrixRotationX(-0.2f), XMMatrixRotationY(0.7f)), XMMatrixTranslation(-0.4f, 1.6f, 0.5f));
+
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_int_distribution<size_t> pointIdx(0, points.size() - 1);
+
+	bool passed = true;
+	int insideCount = 0, outsideCount = 0, missCount = 0;
+	for (float cellSize : { PointGridIndex::DEFAULT_CELL_SIZE, 0.02f, 0.3f })
+	{
+		PointGridIndex index;
+		index.build(points.data(), points.size(), cellSize);
+		PointGridIndex quantizedIndex; // the frame has saturated points beyond 32.767 m
+		quantizedIndex.build(quantized.data(), quantized.size(), cellSize);
+
+		for (int r = 0; r < 200; r++)
+		{
+			// Towards a point (inside the probe), near it (a few degrees off), any direction, and away from the cloud
+			const XMVECTOR origin = XMVector3TransformCoord(XMVectorSet(offset(rng), offset(rng), offset(rng), 0.0f), model);
+			XMVECTOR direction = XMVectorSubtract(XMVector3TransformCoord(XMLoadFloat3(&points[pointIdx(rng)]), model), origin);
+			switch (r % 4)
+			{
+			case 1: direction = XMVectorAdd(XMVector3Normalize(direction), XMVectorScale(XMVectorSet(unit(rng), unit(rng), unit(rng), 0.0f), 0.1f)); break;
+			case 2: direction = XMVectorSet(unit(rng), unit(rng), unit(rng), 0.0f); break;
+			case 3: direction = XMVectorNegate(direction); break;
+			}
+			if (XMVectorGetX(XMVector3LengthSq(direction)) < 1e-6f) { continue; }
+
+			XMFLOAT3 o, d;
+			XMStoreFloat3(&o, origin);
+			XMStoreFloat3(&d, XMVector3Normalize(direction));
+
+			const int expected = PickPointReference(o, d, points.data(), points.size(), model);
+			int picked = -2;
+			passed &= Check(index.pick(o, d, points.data(), points.size(), model, picked) && picked == expected, "pick() differs from pickPoint()");
+
+			const int expectedQuantized = PickPointReference(o, d, quantized.data(), quantized.size(), model);
+			passed &= Check(quantizedIndex.pick(o, d, quantized.data(), quantized.size(), model, picked) && picked == expectedQuantized, "pick() on quantized points differs from pickPoint()");
+			passed &= Check(quantizedIndex.pick(o, d, decoded.data(), decoded.size(), model, picked) && picked == expectedQuantized, "pick() on decoded points differs from pickPoint()");
+
+			if (expected < 0) { missCount++; }
+			else if (IsInsideProbeReference(o, d, points[expected], model)) { insideCount++; }
+			else { outsideCount++; }
+		}
+
+		// The index does not apply to other points
+		int picked = 0;
+		const XMFLOAT3 o(0.0f, 0.0f, 0.0f), d(0.0f, 0.0f, 1.0f);
+		passed &= Check(!index.pick(o, d, points.data(), points.size() - 1, model, picked) && picked == -1, "pick() accepted a different point count");
+	}
+
+	// Every branch of pickPoint() is covered: inside the probe, the smallest angle outside of it, and nothing in front of the ray
+	passed &= Check(insideCount > 0 && outsideCount > 0 && missCount > 0, "rays do not cover every pick case");
+
+	// An empty index picks nothing
+	PointGridIndex empty;
+	empty.build(points.data(), 0);
+	int picked = 0;
+	const XMFLOAT3 o(0.0f, 0.0f, 0.0f), d(0.0f, 0.0f, 1.0f);
+	passed &= Check(!empty.pick(o, d, points.data(), 0, model, picked) && picked == -1, "empty index picked a point");
+	return passed;
+}
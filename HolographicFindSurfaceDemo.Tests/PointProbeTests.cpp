@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/PointProbe.h"
+#include "Sensor/PointQuantization.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Points of a synthetic AHAT frame, as SensorManager keeps them (interleaved, quantized and structure of arrays)
+struct PickData
+{
+	std::vector<XMFLOAT3> points;
+	std::vector<QuantizedPoint> quantized;
+	std::vector<float> x, y, z;   // of `points`
+	std::vector<float> qx, qy, qz; // of `quantized`
+	XMFLOAT4X4 model;
+
+	PickData()
+	{
+		const SyntheticDepth data = SyntheticDepth::Ahat(9);
+		points.resize(data.depth.size());
+		points.resize(UnprojectDepth(points.data(), data.depth.data(), nullptr, data.unitPlane.data(), data.depth.size(), data.maxValidDepth));
+
+		quantized.resize(points.size());
+		QuantizePoints(quantized.data(), points.data(), points.size());
+
+		x.resize(points.size()); y.resize(points.size()); z.resize(points.size());
+		SplitPoints(x.data(), y.data(), z.data(), points.data(), points.size());
+		qx.resize(points.size()); qy.resize(points.size()); qz.resize(points.size());
+		SplitPoints(qx.data(), qy.data(), qz.data(), quantized.data(), quantized.size());
+
+		// Camera 1.6 m above the floor of the stationary frame, turned a little
+		XMStoreFloat4x4(&model, XMMatrixMultiply(XMMatrixMultiply(XMMatrixRotationX(0.1f), XMMatrixRotationY(0.4f)), XMMatrixTranslation(0.2f, 1.6f, -0.3f)));
+	}
+};
+
+// Gaze rays from around the camera: towards points of the cloud (eye, hand, head) and some away from it
+static void _makeRays(XMFLOAT3* pOrigins, XMFLOAT3* pDirections, size_t rayCount, const PickData& data, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+	std::uniform_int_distribution<size_t> pointIdx(0, data.points.size() - 1);
+	std::uniform_int_distribution<int> percent(0, 99);
+	const XMMATRIX model = XMLoadFloat4x4(&data.model);
+
+	for (size_t k = 0; k < rayCount; k++)
+	{
+		const XMVECTOR origin = XMVector3TransformCoord(XMVectorSet(offset(rng), offset(rng), offset(rng), 0.0f), model);
+		XMVECTOR target = XMVector3TransformCoord(XMLoadFloat3(&data.points[pointIdx(rng)]), model);
+		if (percent(rng) < 10) { target = XMVectorSubtract(origin, XMVectorSubtract(target, origin)); } // behind
+		XMStoreFloat3(&pOrigins[k], origin);
+		XMStoreFloat3(&pDirections[k], XMVector3Normalize(XMVectorSubtract(target, origin)));
+	}
+}
+
+// pickPoint() per ray, the results every picker must match bit for bit
+template <typename TPoint>
+static void _pickEachRay(int* pPickIdx, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount, const std::vector<TPoint>& points, XMMATRIX model)
+{
+	for (size_t k = 0; k < rayCount; k++) {
+		pPickIdx[k] = PickPointReference(pOrigins[k], pDirections[k], points.data(), points.size(), model);
+	}
+}
+
+// PickPointSoA() per ray
+static void _pickEachRaySoA(int* pPickIdx, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount,
+	const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z, XMMATRIX model)
+{
+	for (size_t k = 0; k < rayCount; k++) {
+		pPickIdx[k] = PickPointSoA(pOrigins[k], pDirections[k], x.data(), y.data(), z.data(), x.size(), model);
+	}
+}
+
+bool HolographicFindSurfaceDemo::TestPickPoints()
+{
+	const PickData data;
+	const XMMATRIX model = XMLoadFloat4x4(&data.model);
+	std::mt19937 rng(3);
+
+	bool passed = true;
+	constexpr int BATCH_COUNT = 200;
+	for (int batch = 0; batch < BATCH_COUNT; batch++)
+	{
+		const size_t rayCount = 1 + batch % MAX_PICK_RAY_COUNT;
+		XMFLOAT3 origins[MAX_PICK_RAY_COUNT];
+		XMFLOAT3 directions[MAX_PICK_RAY_COUNT];
+		_makeRays(origins, directions, rayCount, data, rng);
+
+		int expected[MAX_PICK_RAY_COUNT];
+		int expectedQuantized[MAX_PICK_RAY_COUNT];
+		int picked[MAX_PICK_RAY_COUNT];
+		_pickEachRay(expected, origins, directions, rayCount, data.points, model);
+		_pickEachRay(expectedQuantized, origins, directions, rayCount, data.quantized, model);
+
+		_pickEachRaySoA(picked, origins, directions, rayCount, data.x, data.y, data.z, model);
+		passed &= Check(std::equal(picked, picked + rayCount, expected), "PickPointSoA() differs from pickPoint()");
+
+		_pickEachRaySoA(picked, origins, directions, rayCount, data.qx, data.qy, data.qz, model);
+		passed &= Check(std::equal(picked, picked + rayCount, expectedQuantized), "PickPointSoA() on quantized points differs from pickPoint()");
+
+		PickPointsSoA(picked, origins, directions, rayCount, data.x.data(), data.y.data(), data.z.data(), data.points.size(), model);
+		passed &= Check(std::equal(picked, picked + rayCount, expected), "PickPointsSoA() differs from pickPoint() per ray");
+
+		PickPoints(picked, origins, directions, rayCount, data.points.data(), data.points.size(), model);
+		passed &= Check(std::equal(picked, picked + rayCount, expected), "PickPoints() differs from pickPoint() per ray");
+
+		PickPoints(picked, origins, directions, rayCount, data.quantized.data(), data.quantized.size(), model);
+		passed &= Check(std::equal(picked, picked + rayCount, expectedQuantized), "PickPoints() on quantized points differs from pickPoint() per ray");
+	}
+
+	// Fewer points than a block, and none
+	XMFLOAT3 origins[MAX_PICK_RAY_COUNT];
+	XMFLOAT3 directions[MAX_PICK_RAY_COUNT];
+	_makeRays(origins, directions, MAX_PICK_RAY_COUNT, data, rng);
+	for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(37) })
+	{
+		int expected[MAX_PICK_RAY_COUNT];
+		int picked[MAX_PICK_RAY_COUNT];
+		for (size_t k = 0; k < MAX_PICK_RAY_COUNT; k++) {
+			expected[k] = PickPointReference(origins[k], directions[k], data.points.data(), count, model);
+		}
+		PickPoints(picked, origins, directions, MAX_PICK_RAY_COUNT, data.points.data(), count, model);
+		passed &= Check(std::equal(picked, picked + MAX_PICK_RAY_COUNT, expected), "PickPoints() differs from pickPoint() on a few points");
+		PickPointsSoA(picked, origins, directions, MAX_PICK_RAY_COUNT, data.x.data(), data.y.data(), data.z.data(), count, model);
+		passed &= Check(std::equal(picked, picked + MAX_PICK_RAY_COUNT, expected), "PickPointsSoA() differs from pickPoint() on a few points");
+	}
+	return passed;
+}
+
+// Eye gaze, two hands and head: pickPoint() and PickPointSoA() per ray against one pass for all of them
+void HolographicFindSurfaceDemo::BenchPickPoints()
+{
+	const PickData data;
+	const XMMATRIX model = XMLoadFloat4x4(&data.model);
+	std::mt19937 rng(4);
+
+	constexpr size_t RAY_COUNT = 4;
+	XMFLOAT3 origins[RAY_COUNT];
+	XMFLOAT3 directions[RAY_COUNT];
+	_makeRays(origins, directions, RAY_COUNT, data, rng);
+	int picked[RAY_COUNT];
+
+	constexpr int ITERATIONS = 20;
+	const double referenceMs = MeasureMilliseconds([&] {
+		_pickEachRay(picked, origins, directions, RAY_COUNT, data.points, model);
+	}, ITERATIONS) / ITERATIONS;
+	const double eachRayMs = MeasureMilliseconds([&] {
+		_pickEachRaySoA(picked, origins, directions, RAY_COUNT, data.x, data.y, data.z, model);
+	}, ITERATIONS) / ITERATIONS;
+	const double pointsMs = MeasureMilliseconds([&] {
+		PickPoints(picked, origins, directions, RAY_COUNT, data.points.data(), data.points.size(), model);
+	}, ITERATIONS) / ITERATIONS;
+	const double quantizedMs = MeasureMilliseconds([&] {
+		PickPoints(picked, origins, directions, RAY_COUNT, data.quantized.data(), data.quantized.size(), model);
+	}, ITERATIONS) / ITERATIONS;
+	const double soaMs = MeasureMilliseconds([&] {
+		PickPointsSoA(picked, origins, directions, RAY_COUNT, data.x.data(), data.y.data(), data.z.data(), data.points.size(), model);
+	}, ITERATIONS) / ITERATIONS;
+
+	printf("Picking %zu rays on %zu points:\n", RAY_COUNT, data.points.size());
+	printf("  %-26s %7.3f ms\n", "pickPoint() per ray", referenceMs);
+	printf("  %-26s %7.3f ms\n", "PickPointSoA() per ray", eachRayMs);
+	printf("  %-26s %7.3f ms\n", "PickPoints()", pointsMs);
+	printf("  %-26s %7.3f ms\n", "PickPoints() quantized", quantizedMs);
+	printf("  %-26s %7.3f ms\n", "PickPointsSoA()", soaMs);
+}
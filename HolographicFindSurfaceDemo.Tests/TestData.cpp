@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "TestData.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+SyntheticDepth SyntheticDepth::LongThrow(uint32_t seed)
+{
+	return Make(320, 288, 220.0f, 0xFFFF, true, seed);
+}
+
+SyntheticDepth SyntheticDepth::Ahat(uint32_t seed)
+{
+	return Make(512, 512, 210.0f, DEPTH_AHAT_MAX_VALID, false, seed);
+}
+
+SyntheticDepth SyntheticDepth::Make(UINT32 width, UINT32 height, float focalPixels, UINT16 maxValidDepth, bool hasSigma, uint32_t seed)
+{
+	SyntheticDepth out;
+	out.width = width;
+	out.height = height;
+	out.maxValidDepth = maxValidDepth;
+
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+	out.depth.resize(pixelCount);
+	out.unitPlane.resize(pixelCount);
+	if (hasSigma) { out.sigma.resize(pixelCount); }
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> noise(-3.0f, 3.0f);
+	std::uniform_int_distribution<int> percent(0, 99);
+
+	const float cx = 0.5f * (width - 1), cy = 0.5f * (height - 1);
+	for (UINT32 v = 0; v < height; v++)
+	{
+		for (UINT32 u = 0; u < width; u++)
+		{
+			const size_t i = static_cast<size_t>(v) * width + u;
+			const float x = (u - cx) / focalPixels;
+			const float y = (v - cy) / focalPixels;
+			const float r = sqrtf(1.0f + x * x + y * y);
+			out.unitPlane[i] = XMFLOAT4(x, y, r, 1.0f / r);
+
+			// Wall at 2.5 m, floor below the center row, two boxes in front of the wall (millimeter, along the ray)
+			float z = 2500.0f;
+			if (y > 0.05f) { z = (std::min)(z, 1200.0f / y); }
+			if (fabsf(x + 0.3f) < 0.15f && fabsf(y) < 0.2f) { z = 1100.0f; }
+			if (fabsf(x - 0.35f) < 0.1f && fabsf(y + 0.1f) < 0.1f) { z = 700.0f + 400.0f * (x - 0.25f); }
+			float depth = z * r + noise(rng);
+
+			const int p = percent(rng);
+			if (p < 3) { depth = 0.0f; }                                           // hole
+			else if (p < 5) { depth = static_cast<float>(maxValidDepth) + 1.0f; }  // beyond maxValidDepth (saturates to 0xFFFF for Long Throw)
+			out.depth[i] = static_cast<UINT16>((std::min)((std::max)(depth, 0.0f), 65535.0f));
+
+			if (hasSigma) { out.sigma[i] = p >= 95 ? DEPTH_SIGMA_INVALID_MASK : static_cast<BYTE>(p); }
+		}
+	}
+	return out;
+}
+
+DepthFrame SyntheticDepth::frame() const
+{
+	DepthFrame frame;
+	frame.width = width;
+	frame.height = height;
+	frame.pDepth = depth.data();
+	frame.pSigma = sigma.empty() ? nullptr : sigma.data();
+	frame.maxValidDepth = maxValidDepth;
+	return frame;
+}
+
+std::shared_ptr<InMemoryDepthRecording> HolographicFindSurfaceDemo::MakeSyntheticRecording(SyntheticDepth(*make)(uint32_t), size_t frameCount, UINT64 periodTicks)
+{
+	constexpr UINT64 START_TICKS = 133'000'000'000'000'000ull; // host clock of a recent date
+
+	std::shared_ptr<InMemoryDepthRecording> pRecording;
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		SyntheticDepth data = make(static_cast<uint32_t>(i + 1));
+		if (!pRecording)
+		{
+			std::vector<XMFLOAT2> unitPlane;
+			unitPlane.reserve(data.unitPlane.size());
+			for (const XMFLOAT4& unit : data.unitPlane) { unitPlane.emplace_back(unit.x, unit.y); }
+
+			XMFLOAT4X4 extrinsic;
+			XMStoreFloat4x4(&extrinsic, XMMatrixTranslation(0.01f, -0.02f, 0.05f));
+			pRecording = std::make_shared<InMemoryDepthRecording>(data.width, data.height, std::move(unitPlane), extrinsic);
+			pRecording->setMaxValidDepth(data.maxValidDepth);
+		}
+		pRecording->addFrame(START_TICKS + i * periodTicks, std::move(data.depth), std::move(data.sigma));
+	}
+	return pRecording;
+}
+
+ReplayedFrames::ReplayedFrames(std::string name, std::shared_ptr<const DepthRecording> pRecording)
+	: name(std::move(name)), pRecording(pRecording)
+{
+	DepthReplaySource source(pRecording, DepthReplaySource::PACING_AS_FAST_AS_POSSIBLE);
+	if (source.open())
+	{
+		DepthFrame frame;
+		while (frames.size() < MAX_FRAMES && source.acquireFrame(frame))
+		{
+			frames.push_back(frame);
+			source.releaseFrame();
+		}
+		source.close();
+	}
+	if (frames.empty()) {
+		throw std::invalid_argument("ReplayedFrames: recording has no frame");
+	}
+	UnitPlaneCache::Build(source, width(), height(), unitPlane);
+}
+
+double HolographicFindSurfaceDemo::MeasureMilliseconds(const std::function<void()>& fn, int iterations, int repeats)
+{
+	double best = 1e300;
+	for (int r = 0; r < repeats; r++)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) { fn(); }
+		const auto end = std::chrono::steady_clock::now();
+		best = (std::min)(best, std::chrono::duration<double, std::milli>(end - begin).count());
+	}
+	return best;
+}
+
+bool HolographicFindSurfaceDemo::Check(bool condition, const char* what)
+{
+	if (!condition) { printf("  FAILED: %s\n", what); }
+	return condition;
+}
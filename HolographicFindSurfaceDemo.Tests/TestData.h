@@ -0,0 +1,131 @@
+#pragma once
+
+#ifndef _TEST_DATA_H_
+#define _TEST_DATA_H_
+
+#include "Sensor/DepthFrameSource.h"
+#include "Sensor/DepthReplaySource.h"
+#include "Sensor/DepthUnprojection.h"
+#include "Sensor/UnitPlaneCache.h"
+#include "Sensor/PointQuantization.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Synthetic depth frame: a tilted floor, a wall and boxes in front of it (depth steps for FlyingPixelFilter),
+	// with holes (0), values above maxValidDepth and, for Long Throw, pixels the sigma buffer invalidates.
+	struct SyntheticDepth
+	{
+		UINT32 width = 0;
+		UINT32 height = 0;
+		UINT16 maxValidDepth = 0xFFFF;
+		std::vector<UINT16> depth;
+		std::vector<BYTE> sigma;               // empty if the frame has no sigma buffer
+		std::vector<DirectX::XMFLOAT4> unitPlane; // see UnprojectDepth()
+
+		static SyntheticDepth LongThrow(uint32_t seed = 1);  // 320 x 288, with sigma
+		static SyntheticDepth Ahat(uint32_t seed = 1);       // 512 x 512, maxValidDepth = DEPTH_AHAT_MAX_VALID
+		static SyntheticDepth Make(UINT32 width, UINT32 height, float focalPixels, UINT16 maxValidDepth, bool hasSigma, uint32_t seed);
+
+		DepthFrame frame() const;
+	};
+
+	// `frameCount` frames of `make` (seeds 1, 2, ...) recorded every `periodTicks`, as DepthReplaySource replays them.
+	std::shared_ptr<InMemoryDepthRecording> MakeSyntheticRecording(SyntheticDepth(*make)(uint32_t), size_t frameCount, UINT64 periodTicks);
+
+	// Frames of a recording as the sensor thread receives them: replayed through DepthReplaySource (as fast as possible),
+	// with the unit plane SensorManager builds from the source (UnitPlaneCache::Build()). The benchmarks cycle through them.
+	struct ReplayedFrames
+	{
+		static constexpr size_t MAX_FRAMES = 30; // bounds the per-frame buffers of the benchmarks
+
+		std::string name;
+		std::shared_ptr<const DepthRecording> pRecording;
+		std::vector<DepthFrame> frames;           // buffers owned by pRecording
+		std::vector<DirectX::XMFLOAT4> unitPlane; // see UnprojectDepth()
+
+		// Keeps the first MAX_FRAMES frames. Throws std::invalid_argument if the recording has no frame.
+		ReplayedFrames(std::string name, std::shared_ptr<const DepthRecording> pRecording);
+
+		inline UINT32 width() const { return frames[0].width; }
+		inline UINT32 height() const { return frames[0].height; }
+		inline bool isAhat() const { return frames[0].maxValidDepth == DEPTH_AHAT_MAX_VALID; }
+	};
+
+	// Copy of pickPoint() (Helper.h, which needs the WinRT float3), the reference of every picker.
+	inline DirectX::XMVECTOR LoadPickPointReference(const DirectX::XMFLOAT3& point) { return DirectX::XMLoadFloat3(&point); }
+	inline DirectX::XMVECTOR LoadPickPointReference(const QuantizedPoint& point) { return LoadQuantizedPoint(point); }
+
+	template <typename TPoint>
+	int PickPointReference(const DirectX::XMFLOAT3& gazeOrigin, const DirectX::XMFLOAT3& gazeDirection, const TPoint* pPtList, size_t count, DirectX::XMMATRIX pointCloudModel)
+	{
+		constexpr float PROBE_RADIUS_ON_METER = 0.015f; // 1.5 cm
+		constexpr float PR_SQ_PLUS_ONE = 1.0f + (PROBE_RADIUS_ON_METER * PROBE_RADIUS_ON_METER);
+
+		DirectX::XMVECTOR det = DirectX::XMMatrixDeterminant(pointCloudModel);
+		pointCloudModel = DirectX::XMMatrixInverse(&det, pointCloudModel);
+
+		DirectX::XMVECTOR pos = DirectX::XMLoadFloat3(&gazeOrigin);
+		DirectX::XMVECTOR dir = DirectX::XMLoadFloat3(&gazeDirection);
+		pos = DirectX::XMVector3TransformCoord(pos, pointCloudModel);
+		dir = DirectX::XMVector3TransformNormal(dir, pointCloudModel);
+
+		int pickIdx = -1;
+		int pickIdxExt = -1;
+		float minLen = FLT_MAX;
+		float maxCos = -FLT_MAX;
+		for (size_t i = 0; i < count; i++)
+		{
+			DirectX::XMVECTOR v = LoadPickPointReference(pPtList[i]);
+			v = DirectX::XMVectorSubtract(v, pos);
+
+			float len1 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, dir));
+			if (len1 < FLT_EPSILON) { continue; }
+
+			v = DirectX::XMVector3LengthSq(v);
+			float len1Sq = len1 * len1;
+			float distSq = DirectX::XMVectorGetX(v);
+			if (distSq < (PR_SQ_PLUS_ONE * len1Sq))
+			{
+				float len2Sq = distSq - len1Sq;
+				if (len2Sq < minLen) {
+					minLen = len2Sq;
+					pickIdx = static_cast<int>(i);
+				}
+			}
+			else
+			{
+				v = DirectX::XMVectorSqrt(v);
+				float c = len1 / DirectX::XMVectorGetX(v);
+				if (c > maxCos) {
+					maxCos = c;
+					pickIdxExt = static_cast<int>(i);
+				}
+			}
+		}
+		return pickIdx < 0 ? pickIdxExt : pickIdx;
+	}
+
+	// True if `point` is inside the probe cone of pickPoint() (false for the point of the least angle it falls back to).
+	template <typename TPoint>
+	bool IsInsideProbeReference(const DirectX::XMFLOAT3& gazeOrigin, const DirectX::XMFLOAT3& gazeDirection, const TPoint& point, DirectX::XMMATRIX pointCloudModel)
+	{
+		constexpr float PR_SQ_PLUS_ONE = 1.0f + (0.015f * 0.015f);
+
+		DirectX::XMVECTOR det = DirectX::XMMatrixDeterminant(pointCloudModel);
+		pointCloudModel = DirectX::XMMatrixInverse(&det, pointCloudModel);
+		const DirectX::XMVECTOR pos = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&gazeOrigin), pointCloudModel);
+		const DirectX::XMVECTOR dir = DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&gazeDirection), pointCloudModel);
+
+		const DirectX::XMVECTOR v = DirectX::XMVectorSubtract(LoadPickPointReference(point), pos);
+		const float len1 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, dir));
+		return len1 >= FLT_EPSILON && DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(v)) < PR_SQ_PLUS_ONE * len1 * len1;
+	}
+
+	// Wall clock milliseconds of `iterations` calls of `fn`, the fastest of `repeats` runs.
+	double MeasureMilliseconds(const std::function<void()>& fn, int iterations, int repeats = 5);
+
+	// Reports a failed check, returns `condition`.
+	bool Check(bool condition, const char* what);
+};
+
+#endif
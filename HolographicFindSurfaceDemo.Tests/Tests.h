@@ -0,0 +1,31 @@
+#pragma once
+
+#ifndef _TESTS_H_
+#define _TESTS_H_
+
+#include "TestData.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Equivalence tests, return false on mismatch
+	bool TestUnprojection();
+	bool TestParallelUnprojection();
+	bool TestFlyingPixelFilter();
+	bool TestPickPoints();
+	bool TestPointGridIndex();
+	bool TestImageSpacePicker();
+	bool TestImuReplay();
+	bool TestDepthReplay();
+	bool TestDepthRecording();
+
+	// Benchmarks, print their timings. Recorded or synthetic frames are replayed as ReplayedFrames.
+	void BenchUnprojection(const ReplayedFrames& stream);
+	// 1 .. hardware_concurrency() threads
+	void BenchParallelUnprojection(const ReplayedFrames& stream);
+	// Sensor thread stages of AHAT frames against the 45 fps frame period
+	void BenchAhatThroughput(const ReplayedFrames& stream);
+	// 4 gaze rays (eye, two hands, head) picked one by one (pickPoint(), PickPointSoA()) and in one batch
+	void BenchPickPoints();
+};
+
+#endif
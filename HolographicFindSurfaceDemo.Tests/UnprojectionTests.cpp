@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "Tests.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+static bool _isUnprojectionEqual(const SyntheticDepth& data, size_t begin, size_t count, bool useSigma)
+{
+	const BYTE* pSigma = useSigma && !data.sigma.empty() ? data.sigma.data() + begin : nullptr;
+
+	std::vector<XMFLOAT3> vector(count), reference(count);
+	const size_t vectorCount = UnprojectDepth(vector.data(), data.depth.data() + begin, pSigma, data.unitPlane.data() + begin, count, data.maxValidDepth);
+	const size_t referenceCount = UnprojectDepthReference(reference.data(), data.depth.data() + begin, pSigma, data.unitPlane.data() + begin, count, data.maxValidDepth);
+
+	return vectorCount == referenceCount && memcmp(vector.data(), reference.data(), vectorCount * sizeof(XMFLOAT3)) == 0;
+}
+
+bool HolographicFindSurfaceDemo::TestUnprojection()
+{
+	bool passed = true;
+	for (const SyntheticDepth& data : { SyntheticDepth::LongThrow(1), SyntheticDepth::Ahat(2) })
+	{
+		const size_t pixelCount = data.depth.size();
+		passed &= Check(_isUnprojectionEqual(data, 0, pixelCount, true), "whole frame");
+		passed &= Check(_isUnprojectionEqual(data, 0, pixelCount, false), "whole frame without sigma");
+
+		// Unaligned starts and tails shorter than a vector
+		for (size_t begin : { 1, 3, 7 }) {
+			for (size_t count : { 0, 1, 5, 13, 1001 }) {
+				passed &= Check(_isUnprojectionEqual(data, begin, count, true), "partial range");
+			}
+		}
+	}
+	return passed;
+}
+
+void HolographicFindSurfaceDemo::BenchUnprojection(const ReplayedFrames& stream)
+{
+	const size_t pixelCount = stream.unitPlane.size();
+	std::vector<XMFLOAT3> points(pixelCount);
+
+	constexpr int ITERATIONS = 100;
+	size_t next = 0;
+	const double vectorMs = MeasureMilliseconds([&] {
+		const DepthFrame& frame = stream.frames[next++ % stream.frames.size()];
+		UnprojectDepth(points.data(), frame.pDepth, frame.pSigma, stream.unitPlane.data(), pixelCount, frame.maxValidDepth);
+	}, ITERATIONS) / ITERATIONS;
+	const double referenceMs = MeasureMilliseconds([&] {
+		const DepthFrame& frame = stream.frames[next++ % stream.frames.size()];
+		UnprojectDepthReference(points.data(), frame.pDepth, frame.pSigma, stream.unitPlane.data(), pixelCount, frame.maxValidDepth);
+	}, ITERATIONS) / ITERATIONS;
+
+	printf("UnprojectDepth %s %ux%u (%zu frames): %.3f ms, reference %.3f ms (x%.2f)\n",
+		stream.name.c_str(), stream.width(), stream.height(), stream.frames.size(), vectorMs, referenceMs, referenceMs / vectorMs);
+}
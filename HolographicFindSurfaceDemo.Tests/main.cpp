@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Sensor/DepthRecordingFile.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+// Checks the vectorized sensor kernels against their scalar references (bit for bit) on synthetic frames,
+// and with --bench measures them on the given depth recordings (e.g. DepthRecording.bin of the app's local folder),
+// or on synthetic Long Throw and AHAT frames. Returns the number of failed tests.
+//   HolographicFindSurfaceDemo.Tests.exe [--bench [recording ...]]
+int main(int argc, char** argv)
+{
+	bool isBench = false;
+	std::vector<std::filesystem::path> recordingPaths;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bench") == 0) { isBench = true; }
+		else if (isBench) { recordingPaths.emplace_back(argv[i]); }
+	}
+
+	struct { const char* name; bool(*run)(); } tests[] = {
+		{ "UnprojectDepth == UnprojectDepthReference", TestUnprojection },
+		{ "UnprojectDepthParallel == UnprojectDepth", TestParallelUnprojection },
+		{ "FlyingPixelFilter::apply == applyReference", TestFlyingPixelFilter },
+		{ "PickPoints / PickPointsSoA == pickPoint per ray", TestPickPoints },
+		{ "PointGridIndex::pick == pickPoint", TestPointGridIndex },
+		{ "ImageSpacePicker::pick / pickCoherent == pickPoint", TestImageSpacePicker },
+		{ "ImuStream replay, ImuPoseInterpolator::getRotations == constant rate rotation", TestImuReplay },
+		{ "DepthReplaySource replays every frame in recorded order", TestDepthReplay },
+		{ "DepthRecordingWriter -> MappedDepthRecording -> DepthReplaySource round trip", TestDepthRecording },
+	};
+
+	int failedCount = 0;
+	for (const auto& test : tests)
+	{
+		const bool passed = test.run();
+		printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.name);
+		if (!passed) { failedCount++; }
+	}
+
+	if (isBench)
+	{
+		std::vector<ReplayedFrames> streams;
+		for (const std::filesystem::path& path : recordingPaths)
+		{
+			try {
+				streams.emplace_back(path.filename().string(), std::make_shared<MappedDepthRecording>(path.wstring()));
+			}
+			catch (...) {
+				printf("Cannot replay %s, skipped\n", path.string().c_str());
+			}
+		}
+		if (streams.empty())
+		{
+			streams.emplace_back("synthetic Long Throw", MakeSyntheticRecording(SyntheticDepth::LongThrow, 8, 2'000'000)); // 5 fps
+			streams.emplace_back("synthetic AHAT", MakeSyntheticRecording(SyntheticDepth::Ahat, 8, 222'222));              // 45 fps
+		}
+
+		bool hasAhat = false;
+		for (const ReplayedFrames& stream : streams)
+		{
+			BenchUnprojection(stream);
+			BenchParallelUnprojection(stream);
+			if (stream.isAhat())
+			{
+				BenchAhatThroughput(stream);
+				hasAhat = true;
+			}
+		}
+		if (!hasAhat) {
+			BenchAhatThroughput(ReplayedFrames("synthetic AHAT", MakeSyntheticRecording(SyntheticDepth::Ahat, 8, 222'222)));
+		}
+		BenchPickPoints();
+	}
+	return failedCount;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Desktop console build of the platform independent sensor code (Sensor/*), see main.cpp.
+#include <windows.h>
+#include <DirectXMath.h>
+#include <winrt/base.h> // winrt::file_handle (Sensor/DepthRecordingFile.h)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
@@ -0,0 +1,4 @@
+// Same as PCRVertexShader.hlsl, over quantized points (see PointCloudRenderer::UpdatePointCloudBuffer()).
+#define QUANTIZED_POINTS
+
+#include "PCRVertexShader.hlsl"
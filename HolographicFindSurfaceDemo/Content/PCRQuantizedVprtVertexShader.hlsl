@@ -0,0 +1,4 @@
+// Same as PCRVprtVertexShader.hlsl, over quantized points (see PointCloudRenderer::UpdatePointCloudBuffer()).
+#define QUANTIZED_POINTS
+
+#include "PCRVprtVertexShader.hlsl"
@@ -11,6 +11,29 @@ cbuffer ViewProjectionConstantBuffer : register(b1)
     float4x4 viewMatrix[2];
 };
 
+#ifdef QUANTIZED_POINTS
+// Quantized points (3 x int16 each, 6 bytes), fetched by vertex ID without an input layout.
+// The millimeter to meter scale is part of the model transform.
+ByteAddressBuffer quantizedPoints : register(t0);
+
+struct VertexShaderInput
+{
+    uint   vertId  : SV_VertexID;
+    uint   instId  : SV_InstanceID;
+};
+
+float3 LoadPosition(VertexShaderInput input)
+{
+    // A point starts on a 2 byte boundary, the 8 bytes of the 4 byte aligned words around it hold all of it.
+    uint byteOffset = input.vertId * 6;
+    uint2 words = quantizedPoints.Load2(byteOffset & ~3u);
+    uint xy = (byteOffset & 2) ? ((words.x >> 16) | (words.y << 16)) : words.x;
+    uint z  = (byteOffset & 2) ? (words.y >> 16) : words.y;
+
+    // Sign extension of the 16 bit halves
+    return float3(int3(xy << 16, xy, z << 16) >> 16);
+}
+#else
 // Per-vertex data used as input to the vertex shader.
 struct VertexShaderInput
 {
@@ -18,11 +41,17 @@ struct VertexShaderInput
     uint   instId  : SV_InstanceID;
 };
 
+float3 LoadPosition(VertexShaderInput input)
+{
+    return input.pos;
+}
+#endif
+
 // Simple shader to do vertex processing on the GPU.
 VertexShaderOutput main(VertexShaderInput input)
 {
     VertexShaderOutput output;
-    float4 pos = float4(input.pos, 1.0f);
+    float4 pos = float4(LoadPosition(input), 1.0f);
 
     // Note which view this vertex has been sent to. Used for matrix lookup.
     // Taking the modulo of the instance ID allows geometry instancing to be used
@@ -52,6 +52,50 @@ void PointCloudRenderer::UpdatePointCloudBuffer(const DirectX::XMFLOAT3* pBuffer
     );
 
     m_vertexCount = static_cast<uint32_t>(count);
+    m_isQuantized = false;
+}
+
+void PointCloudRenderer::UpdatePointCloudBuffer(const QuantizedPoint* pBuffer, size_t count, DirectX::XMMATRIX model, bool isTransposed)
+{
+    if (!m_loadingComplete || pBuffer == nullptr || count < 1 || count > static_cast<size_t>(MAX_POINT_CLOUD_COUNT)) { return; }
+    if (isTransposed) { model = XMMatrixTranspose(model); }
+
+    // Millimeter to meter ahead of the model transform
+    model = XMMatrixTranspose(XMMatrixMultiply(XMMatrixScaling(POINT_DEQUANTIZATION_SCALE, POINT_DEQUANTIZATION_SCALE, POINT_DEQUANTIZATION_SCALE), model));
+
+    const auto context = m_deviceResources->GetD3DDeviceContext();
+
+    XMFLOAT4X4 modelConstant;
+    XMStoreFloat4x4(&modelConstant, model);
+
+    context->UpdateSubresource(
+        m_modelConstantBuffer.Get(),
+        0,
+        nullptr,
+        &modelConstant,
+        0,
+        0
+    );
+
+    D3D11_BOX dstBox;
+    dstBox.left = 0;
+    dstBox.right = static_cast<UINT>(sizeof(QuantizedPoint) * count);
+    dstBox.top = 0;
+    dstBox.bottom = 1;
+    dstBox.front = 0;
+    dstBox.back = 1;
+
+    context->UpdateSubresource(
+        m_quantizedPointCloudBuffer.Get(),
+        0,
+        &dstBox,
+        pBuffer,
+        0,
+        0
+    );
+
+    m_vertexCount = static_cast<uint32_t>(count);
+    m_isQuantized = true;
 }
 
 // Renders one frame using the vertex and pixel shaders.
@@ -69,22 +113,34 @@ void PointCloudRenderer::Render()
 
     const auto context = m_deviceResources->GetD3DDeviceContext();
 
-    // Each vertex is one instance of the XMFLOAT3 struct.
-    const UINT stride = sizeof(XMFLOAT3);
-    const UINT offset = 0;
-    context->IASetVertexBuffers(
-        0,
-        1,
-        m_pointCloudBuffer.GetAddressOf(),
-        &stride,
-        &offset
-    );
+    if (m_isQuantized)
+    {
+        // The vertex shader fetches the points by SV_VertexID.
+        ID3D11Buffer* nullBuffer = nullptr;
+        const UINT zero = 0;
+        context->IASetVertexBuffers(0, 1, &nullBuffer, &zero, &zero);
+        context->IASetInputLayout(nullptr);
+        context->VSSetShaderResources(0, 1, m_quantizedPointCloudView.GetAddressOf());
+    }
+    else
+    {
+        // Each vertex is one instance of the XMFLOAT3 struct.
+        const UINT stride = sizeof(XMFLOAT3);
+        const UINT offset = 0;
+        context->IASetVertexBuffers(
+            0,
+            1,
+            m_pointCloudBuffer.GetAddressOf(),
+            &stride,
+            &offset
+        );
+        context->IASetInputLayout(m_inputLayout.Get());
+    }
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-    context->IASetInputLayout(m_inputLayout.Get());
 
     // Attach the vertex shader.
     context->VSSetShader(
-        m_vertexShader.Get(),
+        m_isQuantized ? m_quantizedVertexShader.Get() : m_vertexShader.Get(),
         nullptr,
         0
     );
@@ -161,6 +217,15 @@ std::future<void> PointCloudRenderer::CreateDeviceDependentResources()
             &m_inputLayout
         ));
 
+    std::vector<byte> quantizedVertexShaderFileData = co_await DX::ReadDataAsync(m_usingVprtShaders ? L"ms-appx:///PCRQuantizedVprtVertexShader.cso" : L"ms-appx:///PCRQuantizedVertexShader.cso");
+    winrt::check_hresult(
+        m_deviceResources->GetD3DDevice()->CreateVertexShader(
+            quantizedVertexShaderFileData.data(),
+            quantizedVertexShaderFileData.size(),
+            nullptr,
+            &m_quantizedVertexShader
+        ));
+
     // After the pixel shader file is loaded, create the shader and constant buffer.
     std::vector<byte> pixelShaderFileData = co_await DX::ReadDataAsync(L"ms-appx:///PCRPixelShader.cso");
     winrt::check_hresult(
@@ -203,6 +268,24 @@ std::future<void> PointCloudRenderer::CreateDeviceDependentResources()
             &m_pointCloudBuffer
         ));
 
+    // Quantized counterpart (6 bytes per point), raw views address it in 4 byte words
+    const UINT quantizedByteWidth = (sizeof(QuantizedPoint) * static_cast<UINT>(MAX_POINT_CLOUD_COUNT) + 3) & ~3u;
+    const CD3D11_BUFFER_DESC quantizedBufferDesc(quantizedByteWidth, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+    winrt::check_hresult(
+        m_deviceResources->GetD3DDevice()->CreateBuffer(
+            &quantizedBufferDesc,
+            nullptr,
+            &m_quantizedPointCloudBuffer
+        ));
+
+    const CD3D11_SHADER_RESOURCE_VIEW_DESC quantizedViewDesc(m_quantizedPointCloudBuffer.Get(), DXGI_FORMAT_R32_TYPELESS, 0, quantizedByteWidth / 4, D3D11_BUFFEREX_SRV_FLAG_RAW);
+    winrt::check_hresult(
+        m_deviceResources->GetD3DDevice()->CreateShaderResourceView(
+            m_quantizedPointCloudBuffer.Get(),
+            &quantizedViewDesc,
+            &m_quantizedPointCloudView
+        ));
+
     // the object is ready to be rendered.
     m_loadingComplete = true;
 };
@@ -217,4 +300,7 @@ void PointCloudRenderer::ReleaseDeviceDependentResources()
     m_geometryShader.Reset();
     m_modelConstantBuffer.Reset();
     m_pointCloudBuffer.Reset();
+    m_quantizedVertexShader.Reset();
+    m_quantizedPointCloudBuffer.Reset();
+    m_quantizedPointCloudView.Reset();
 }
@@ -2,6 +2,7 @@
 
 #include "../Common/DeviceResources.h"
 #include "ShaderStructures.h"
+#include "../Sensor/PointQuantization.h"
 
 #define MAX_POINT_CLOUD_COUNT 1000000 // 1mio
 
@@ -18,6 +19,8 @@ namespace HolographicFindSurfaceDemo
 
     public:
         void UpdatePointCloudBuffer(const DirectX::XMFLOAT3* pBuffer, size_t count, DirectX::XMMATRIX model, bool isTransposed = false);
+        // Uploads the int16 millimeter points as they are, the vertex shader converts them to meter.
+        void UpdatePointCloudBuffer(const QuantizedPoint* pBuffer, size_t count, DirectX::XMMATRIX model, bool isTransposed = false);
         void ClearPointCloudBuffer() { m_vertexCount = 0; }
 
     private:
@@ -32,8 +35,14 @@ namespace HolographicFindSurfaceDemo
         Microsoft::WRL::ComPtr<ID3D11Buffer>            m_modelConstantBuffer;
         Microsoft::WRL::ComPtr<ID3D11Buffer>            m_pointCloudBuffer;
 
+        // Quantized point cloud, read by the vertex shader through a raw view (no input layout for 3 x int16)
+        Microsoft::WRL::ComPtr<ID3D11VertexShader>      m_quantizedVertexShader;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>            m_quantizedPointCloudBuffer;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_quantizedPointCloudView;
+
         // System resources for point cloud geometry.
         uint32_t                                        m_vertexCount = 0;
+        bool                                            m_isQuantized = false; // which buffer holds the points
 
         // Variables used with the rendering loop.
         bool                                            m_loadingComplete = false;
@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "FindSurfaceContextPool.h"
+#include "LatencyTracer.h"
+
+#include <sstream>
+
+using namespace HolographicFindSurfaceDemo;
+
+static inline uint32_t _popCount(uint32_t v)
+{
+	uint32_t count = 0;
+	for (; v; v &= v - 1) { count++; }
+	return count;
+}
+
+static inline uint32_t _lowestBitIndex(uint32_t v)
+{
+	uint32_t index = 0;
+	while ((v & 1) == 0) { v >>= 1; index++; }
+	return index;
+}
+
+bool FindSurfaceContext::findSurface(FS_FEATURE_TYPE type, unsigned int seedIndex, float seedRadius, FS_FEATURE_RESULT& result)
+{
+	result = { FS_TYPE_NONE, };
+	int ret = ::findSurface(m_hCtx, type, seedIndex, seedRadius, &result);
+	switch (ret)
+	{
+	case FS_NO_ERROR:
+		return true;
+	case FS_INVALID_VALUE:
+		throw FindSurfaceException::InvalidArgument(::getFindSurfaceErrorMessage(m_hCtx));
+	case FS_INVALID_OPERATION:
+		throw FindSurfaceException::InvalidOperation(::getFindSurfaceErrorMessage(m_hCtx));
+	}
+	return false; // just not found
+}
+
+void FindSurfaceContextRef::reset()
+{
+	if (m_pContext)
+	{
+		m_pContext->m_pPool->recycle(m_pContext);
+		m_pContext = nullptr;
+	}
+}
+
+FindSurfaceContextPool::FindSurfaceContextPool(uint32_t poolSize)
+	: m_nFreeMask(0), m_nCreationTicks(LatencyTracer::now())
+{
+	if (poolSize < 1) {
+		poolSize = (std::min)(MAX_POOL_SIZE, (std::max)(1u, std::thread::hardware_concurrency()));
+	}
+	if (poolSize > MAX_POOL_SIZE) {
+		throw std::invalid_argument("FindSurfaceContextPool: pool size must be in [0, 32]");
+	}
+
+	m_pContexts.reset(new FindSurfaceContext[poolSize]);
+	for (uint32_t i = 0; i < poolSize; i++)
+	{
+		FIND_SURFACE_CONTEXT hCtx = nullptr;
+		if (::createFindSurface(&hCtx) != FS_NO_ERROR || !hCtx)
+		{
+			OutputDebugString(L"FindSurfaceContextPool: failed to create a FindSurface context\n");
+			continue;
+		}
+
+		FindSurfaceContext& context = m_pContexts[m_nPoolSize];
+		context.m_hCtx = hCtx;
+		context.m_pPool = this;
+		context.m_nSlot = m_nPoolSize;
+		m_nPoolSize++;
+	}
+	m_nFreeMask.store(m_nPoolSize == 32 ? 0xFFFFFFFFu : ((1u << m_nPoolSize) - 1), std::memory_order_release);
+}
+
+FindSurfaceContextRef FindSurfaceContextPool::acquire()
+{
+	uint32_t freeMask = m_nFreeMask.load(std::memory_order_acquire);
+	uint32_t slot;
+	do
+	{
+		if (freeMask == 0)
+		{
+			m_nExhaustedCount.fetch_add(1, std::memory_order_relaxed);
+			return FindSurfaceContextRef();
+		}
+		slot = _lowestBitIndex(freeMask);
+	} while (!m_nFreeMask.compare_exchange_weak(freeMask, freeMask & ~(1u << slot), std::memory_order_acq_rel, std::memory_order_acquire));
+
+	m_nAcquireCount.fetch_add(1, std::memory_order_relaxed);
+
+	uint32_t inUse = m_nPoolSize - _popCount(freeMask & ~(1u << slot));
+	uint32_t peak = m_nPeakInUseCount.load(std::memory_order_relaxed);
+	while (inUse > peak && !m_nPeakInUseCount.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {}
+
+	FindSurfaceContext* pContext = &m_pContexts[slot];
+	pContext->m_nAcquireCount.fetch_add(1, std::memory_order_relaxed);
+	pContext->m_nAcquireTicks.store(LatencyTracer::now(), std::memory_order_relaxed);
+	return FindSurfaceContextRef(pContext);
+}
+
+void FindSurfaceContextPool::recycle(FindSurfaceContext* pContext)
+{
+	pContext->m_nBusyTicks.fetch_add(LatencyTracer::now() - pContext->m_nAcquireTicks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_nFreeMask.fetch_or(1u << pContext->m_nSlot, std::memory_order_acq_rel);
+}
+
+FindSurfaceContextPool::Statistics FindSurfaceContextPool::getStatistics() const
+{
+	const long long nowTicks = LatencyTracer::now();
+	const uint32_t freeMask = m_nFreeMask.load(std::memory_order_relaxed);
+	const double elapsed = static_cast<double>((std::max)(nowTicks - m_nCreationTicks, 1LL));
+
+	Statistics stat;
+	stat.acquireCount = m_nAcquireCount.load(std::memory_order_relaxed);
+	stat.exhaustedCount = m_nExhaustedCount.load(std::memory_order_relaxed);
+	stat.inUseCount = m_nPoolSize - _popCount(freeMask);
+	stat.peakInUseCount = m_nPeakInUseCount.load(std::memory_order_relaxed);
+	stat.contexts.resize(m_nPoolSize);
+	for (uint32_t i = 0; i < m_nPoolSize; i++)
+	{
+		const FindSurfaceContext& context = m_pContexts[i];
+		ContextStatistics& out = stat.contexts[i];
+		out.isInUse = ((freeMask >> i) & 1) == 0;
+		out.acquireCount = context.m_nAcquireCount.load(std::memory_order_relaxed);
+
+		// Approximate while the context is in use (the current acquisition may be released meanwhile)
+		long long busyTicks = context.m_nBusyTicks.load(std::memory_order_relaxed);
+		if (out.isInUse) {
+			busyTicks += (std::max)(nowTicks - context.m_nAcquireTicks.load(std::memory_order_relaxed), 0LL);
+		}
+		out.occupancy = static_cast<float>((std::min)(static_cast<double>(busyTicks) / elapsed, 1.0));
+	}
+	return stat;
+}
+
+std::wstring FindSurfaceContextPool::report() const
+{
+	Statistics stat = getStatistics();
+
+	std::wostringstream wss;
+	wss << L"FindSurface contexts in use: " << stat.inUseCount << L"/" << m_nPoolSize << L" (peak " << stat.peakInUseCount
+		<< L"), exhausted: " << stat.exhaustedCount << L", occupancy:";
+	for (const ContextStatistics& context : stat.contexts) {
+		wss << L" " << static_cast<int>(context.occupancy * 100.0f + 0.5f) << L"%";
+	}
+	wss << std::endl;
+	return wss.str();
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#ifndef _FIND_SURFACE_CONTEXT_POOL_H_
+#define _FIND_SURFACE_CONTEXT_POOL_H_
+
+#include <FindSurface.hpp>
+#include <atomic>
+
+namespace HolographicFindSurfaceDemo
+{
+	class FindSurfaceContextPool;
+
+	// One FindSurface context (createFindSurface()) with the interface of FindSurface (FindSurface.hpp).
+	// Unlike the FindSurface::getInstance() singleton, every context has its own point cloud binding and parameters,
+	// so fits on different contexts can run concurrently. Contexts live in a FindSurfaceContextPool.
+	class FindSurfaceContext
+	{
+	private:
+		friend class FindSurfaceContextPool;
+		friend class FindSurfaceContextRef;
+
+		FIND_SURFACE_CONTEXT m_hCtx = nullptr;
+		FindSurfaceContextPool* m_pPool = nullptr;
+		uint32_t m_nSlot = 0;
+
+		// Occupancy (see FindSurfaceContextPool::getStatistics())
+		std::atomic<uint64_t> m_nAcquireCount{ 0 };
+		std::atomic<long long> m_nBusyTicks{ 0 };  // time in use of the released acquisitions
+		std::atomic<long long> m_nAcquireTicks{ 0 }; // time of the current acquisition
+
+	public:
+		FindSurfaceContext() = default;
+		FindSurfaceContext(const FindSurfaceContext&) = delete;
+		FindSurfaceContext& operator=(const FindSurfaceContext&) = delete;
+		~FindSurfaceContext() { if (m_hCtx) { ::releaseFindSurface(m_hCtx); } }
+
+	public: // Setter
+		inline void setSmartConversionOptions(int options) { ::setSmartConversionOptions(m_hCtx, options); }
+		inline void setRadialExpansion(FS_SEARCH_LEVEL level) { ::setRadialExpansion(m_hCtx, level); }
+		inline void setLateralExtension(FS_SEARCH_LEVEL level) { ::setLateralExtension(m_hCtx, level); }
+		inline void setMeasurementAccuracy(float val) { ::setMeasurementAccuracy(m_hCtx, val); }
+		inline void setMeanDistance(float val) { ::setMeanDistance(m_hCtx, val); }
+
+	public: // Getter
+		inline int getSmartConversionOptions()       const { return ::getSmartConversionOptions(m_hCtx); }
+		inline FS_SEARCH_LEVEL getRadialExpansion()  const { return ::getRadialExpansion(m_hCtx); }
+		inline FS_SEARCH_LEVEL getLateralExtension() const { return ::getLateralExtension(m_hCtx); }
+		inline float getMeasurementAccuracy()        const { return ::getMeasurementAccuracy(m_hCtx); }
+		inline float getMeanDistance()               const { return ::getMeanDistance(m_hCtx); }
+
+	public:
+		inline FS_ERROR setPointCloudDataFloat(const void* data, unsigned int count, unsigned int stride = 0) { return ::setPointCloudFloat(m_hCtx, data, count, stride); }
+		inline unsigned int getPointCloudCount() const { return ::getPointCloudCount(m_hCtx); }
+
+		inline void cleanUp() { ::cleanUpFindSurface(m_hCtx); }
+
+		// Same search as FindSurface::findSurface(), into `result` instead of a new FindSurfaceResult.
+		// Returns false if no surface is found, throws the FindSurfaceException of an invalid argument or operation.
+		bool findSurface(FS_FEATURE_TYPE type, unsigned int seedIndex, float seedRadius, FS_FEATURE_RESULT& result);
+		// Flag of each point of the point cloud data (0 for inliers) by the last findSurface(), valid until the next call.
+		inline const unsigned char* getInOutlierFlags() const { return ::getInOutlierFlags(m_hCtx); }
+	};
+
+	// Exclusive handle of a pooled FindSurfaceContext.
+	// The context returns to its pool when the handle is reset or destroyed.
+	class FindSurfaceContextRef
+	{
+	private:
+		FindSurfaceContext* m_pContext = nullptr;
+
+	public:
+		FindSurfaceContextRef() = default;
+		explicit FindSurfaceContextRef(FindSurfaceContext* pContext) : m_pContext(pContext) {} // used by FindSurfaceContextPool
+		FindSurfaceContextRef(const FindSurfaceContextRef&) = delete;
+		FindSurfaceContextRef(FindSurfaceContextRef&& other) noexcept : m_pContext(other.m_pContext) { other.m_pContext = nullptr; }
+		~FindSurfaceContextRef() { reset(); }
+
+		FindSurfaceContextRef& operator=(const FindSurfaceContextRef&) = delete;
+		FindSurfaceContextRef& operator=(FindSurfaceContextRef&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_pContext = other.m_pContext;
+				other.m_pContext = nullptr;
+			}
+			return *this;
+		}
+
+		void reset();
+
+		inline FindSurfaceContext* get() const { return m_pContext; }
+		inline FindSurfaceContext* operator->() const { return m_pContext; }
+		inline FindSurfaceContext& operator*() const { return *m_pContext; }
+		inline explicit operator bool() const { return m_pContext != nullptr; }
+	};
+
+	// Fixed set of FindSurface contexts shared by the threads that run FindSurface.
+	// acquire() and release are lock-free and never block, a thread holds a context for one fit (or a batch of them).
+	// A released context keeps the parameters and point cloud binding of its last user, set both after acquire().
+	class FindSurfaceContextPool
+	{
+	public:
+		static constexpr uint32_t MAX_POOL_SIZE = 32;
+
+		struct ContextStatistics
+		{
+			bool isInUse;
+			uint64_t acquireCount;
+			float occupancy;         // fraction of the time since the pool was created that the context was in use
+		};
+
+		struct Statistics
+		{
+			uint64_t acquireCount;   // successful acquire()
+			uint64_t exhaustedCount; // acquire() failed because every context was in use
+			uint32_t inUseCount;     // contexts currently acquired
+			uint32_t peakInUseCount; // highest inUseCount so far
+			std::vector<ContextStatistics> contexts; // per context, in slot order
+		};
+
+	private:
+		std::unique_ptr<FindSurfaceContext[]> m_pContexts;
+		uint32_t m_nPoolSize = 0;
+		std::atomic<uint32_t> m_nFreeMask; // bit i set: context i is free
+		long long m_nCreationTicks;
+
+		std::atomic<uint64_t> m_nAcquireCount{ 0 };
+		std::atomic<uint64_t> m_nExhaustedCount{ 0 };
+		std::atomic<uint32_t> m_nPeakInUseCount{ 0 };
+
+	public:
+		// Creates `poolSize` contexts, 0 selects std::thread::hardware_concurrency().
+		// A context FindSurface fails to create is left out, see size().
+		explicit FindSurfaceContextPool(uint32_t poolSize);
+		FindSurfaceContextPool(const FindSurfaceContextPool&) = delete;
+		FindSurfaceContextPool& operator=(const FindSurfaceContextPool&) = delete;
+
+		// Returns a free context, or an empty handle if every context is in use.
+		FindSurfaceContextRef acquire();
+
+		Statistics getStatistics() const;
+		// Human readable occupancy (one line)
+		std::wstring report() const;
+		inline uint32_t size() const { return m_nPoolSize; }
+
+	private:
+		friend class FindSurfaceContextRef;
+		void recycle(FindSurfaceContext* pContext);
+	};
+};
+
+#endif
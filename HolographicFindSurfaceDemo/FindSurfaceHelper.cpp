@@ -8,7 +8,7 @@
 using namespace HolographicFindSurfaceDemo;
 using namespace DirectX;
 
-void FindSurfaceHelper::FillFindSurfaceParameter(FindSurface* pContext, float distance, ErrorLevel errLv)
+void FindSurfaceHelper::FillFindSurfaceParameter(FindSurfaceContext* pContext, float distance, ErrorLevel errLv)
 {
 	constexpr float _baseError = 0.002f;  // 2 mm at meter
 	float errorDistance = distance > 1.0f ? (distance - 1.0f) : 0.0f;
@@ -37,13 +37,86 @@ void FindSurfaceHelper::FillFindSurfaceParameter(FindSurface* pContext, float di
 	pContext->setRadialExpansion(FS_SEARCH_LEVEL::FS_LEVEL_DEFAULT);
 }
 
+float FindSurfaceHelper::GetCropRadius(const FindSurfaceContext* pContext, float seedRadius, float cropScale)
+{
+	if (cropScale > 0.0f) {
+		return seedRadius * cropScale;
+	}
+
+	// FindSurface grows the surface from the seed region, farther for a higher search level.
+	// 4x seed radius with both levels off, 20x at FS_LEVEL_DEFAULT and 36x at FS_LEVEL_RADICAL.
+	constexpr float _baseScale = 4.0f;
+	constexpr float _scalePerLevel = 3.2f;
+
+	int level = (std::max)(static_cast<int>(pContext->getLateralExtension()), static_cast<int>(pContext->getRadialExpansion()));
+	return seedRadius * (_baseScale + _scalePerLevel * static_cast<float>(level));
+}
+
+static inline XMVECTOR _loadPoint(const XMFLOAT3& point) { return XMLoadFloat3(&point); }
+static inline XMVECTOR _loadPoint(const QuantizedPoint& point) { return LoadQuantizedPoint(point); }
+
+template <typename TPoint>
+static unsigned int _cropAroundSeed(std::vector<XMFLOAT3>& out, const TPoint* pPoints, size_t count, unsigned int seedIndex, float radius)
+{
+	if (seedIndex >= count) {
+		throw std::invalid_argument("seedIndex is out of range");
+	}
+
+	const XMVECTOR center = _loadPoint(pPoints[seedIndex]);
+	const float sqRadius = radius * radius;
+
+	out.clear();
+	unsigned int outSeedIndex = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const XMVECTOR v = _loadPoint(pPoints[i]);
+		if (i == seedIndex) {
+			outSeedIndex = static_cast<unsigned int>(out.size());
+		}
+		else if (XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(v, center))) > sqRadius) {
+			continue;
+		}
+		out.emplace_back();
+		XMStoreFloat3(&out.back(), v);
+	}
+	return outSeedIndex;
+}
+
+unsigned int FindSurfaceHelper::CropAroundSeed(std::vector<XMFLOAT3>& out, const XMFLOAT3* pPoints, size_t count, unsigned int seedIndex, float radius)
+{
+	return _cropAroundSeed(out, pPoints, count, seedIndex, radius);
+}
+
+unsigned int FindSurfaceHelper::CropAroundSeed(std::vector<XMFLOAT3>& out, const QuantizedPoint* pPoints, size_t count, unsigned int seedIndex, float radius)
+{
+	return _cropAroundSeed(out, pPoints, count, seedIndex, radius);
+}
+
+bool FindSurfaceHelper::IsTouchingCropBoundary(const unsigned char* pInOutlierFlags, const XMFLOAT3* pPoints, size_t count, const XMFLOAT3& center, float radius, float margin)
+{
+	if (pInOutlierFlags == nullptr) {
+		return true; // Cannot tell
+	}
+
+	const XMVECTOR c = XMLoadFloat3(&center);
+	const float innerRadius = (std::max)(radius - margin, 0.0f);
+	const float sqInnerRadius = innerRadius * innerRadius;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (pInOutlierFlags[i] == 0 && XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&pPoints[i]), c))) > sqInnerRadius) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static const XMFLOAT4 Y_DIR = { 0.0f, 1.0f, 0.0f, 0.0f };
 static const XMFLOAT4 HALF = { 0.5f, 0.5f, 0.5f, 0.5f };
 static const XMFLOAT4 QUARTER = { 0.25f, 0.25f, 0.25f, 0.25f };
 
 void FindSurfaceHelper::FillConstantBufferFromResult(
 	InstanceConstantBuffer& out, 
-	const FindSurfaceResult* pResult,
+	const FS_FEATURE_RESULT* pResult,
 	const winrt::Windows::Foundation::Numerics::float3& headFowardDirection,
 	const winrt::Windows::Foundation::Numerics::float3& headUpDirection,
 	const XMFLOAT4X4* pointCloudModel
@@ -62,7 +135,7 @@ void FindSurfaceHelper::FillConstantBufferFromResult(
 		upDir = XMVector3TransformNormal(upDir, invBaseModel);
 	}
 
-	switch (pResult->getType())
+	switch (pResult->type)
 	{
 		case FS_TYPE_PLANE:
 		{
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <FindSurface.hpp>
+#include "FindSurfaceContextPool.h"
 #include "Content/ShaderStructures.h"
+#include "Sensor/PointQuantization.h"
 
 namespace HolographicFindSurfaceDemo
 {
@@ -15,16 +16,32 @@ namespace HolographicFindSurfaceDemo
 			ERROR_LEVEL_LOW
 		};
 
+		// Seed radius scale of the cropped input that is derived from the search levels of the context.
+		static constexpr float CROP_SCALE_ADAPTIVE = 0.0f;
+
 	public:
-		static void FillFindSurfaceParameter(FindSurface* pContext, float shortestDistanceToSeedPointThroughHeadForwardDirection, ErrorLevel errLv = ERROR_LEVEL_NORMAL);
+		static void FillFindSurfaceParameter(FindSurfaceContext* pContext, float shortestDistanceToSeedPointThroughHeadForwardDirection, ErrorLevel errLv = ERROR_LEVEL_NORMAL);
 
 		static void FillConstantBufferFromResult(
 			InstanceConstantBuffer& out, 
-			const FindSurfaceResult* pResult,
+			const FS_FEATURE_RESULT* pResult,
 			const winrt::Windows::Foundation::Numerics::float3& headFowardDirection,
 			const winrt::Windows::Foundation::Numerics::float3& headUpDirection,
 			const DirectX::XMFLOAT4X4* pointCloudModel = nullptr
 		);
+
+		// Radius around the seed point that bounds the input of findSurface().
+		// Uses `cropScale` times the seed radius, or the lateral extension and radial expansion levels of the context for CROP_SCALE_ADAPTIVE.
+		static float GetCropRadius(const FindSurfaceContext* pContext, float seedRadius, float cropScale = CROP_SCALE_ADAPTIVE);
+
+		// Copies the points within `radius` of the seed point in their original order, and returns the index of the seed point in `out`.
+		static unsigned int CropAroundSeed(std::vector<DirectX::XMFLOAT3>& out, const DirectX::XMFLOAT3* pPoints, size_t count, unsigned int seedIndex, float radius);
+		// Same as above on quantized points, only the points within `radius` are decoded (as DequantizePoints() does).
+		static unsigned int CropAroundSeed(std::vector<DirectX::XMFLOAT3>& out, const QuantizedPoint* pPoints, size_t count, unsigned int seedIndex, float radius);
+
+		// Returns true, if an inlier of the result (`pInOutlierFlags` of the context, see FindSurfaceContext::getInOutlierFlags())
+		// lies within `margin` of the crop boundary, that is, the surface might have grown further on the full point cloud.
+		static bool IsTouchingCropBoundary(const unsigned char* pInOutlierFlags, const DirectX::XMFLOAT3* pPoints, size_t count, const DirectX::XMFLOAT3& center, float radius, float margin);
 		
 	};
 };
@@ -0,0 +1,216 @@
+#include "pch.h"
+#include "FindSurfaceWorker.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Thread
+void FindSurfaceWorker::WorkerLoopThread(FindSurfaceWorker* pOwner)
+{
+	for (;;)
+	{
+		Request request;
+		{
+			std::unique_lock lock(pOwner->m_hMailboxMutex);
+			pOwner->m_cvMailbox.wait(lock, [pOwner] { return pOwner->m_fExit || pOwner->m_fHasRequest; });
+			if (pOwner->m_fExit) { break; }
+
+			request = std::move(pOwner->m_mailbox);
+			pOwner->m_fHasRequest = false;
+		}
+
+		Result& result = pOwner->m_tbResult.back();
+		if (pOwner->run(request, result)) {
+			pOwner->m_tbResult.publish();
+		}
+	}
+}
+
+FindSurfaceWorker::FindSurfaceWorker(FindSurfaceContextPool* pContextPool, LatencyTracer* pTracer)
+	: m_pContextPool(pContextPool), m_pTracer(pTracer)
+{
+}
+
+FindSurfaceWorker::~FindSurfaceWorker()
+{
+	stop();
+}
+
+void FindSurfaceWorker::start()
+{
+	// Check Thread is already working
+	if (m_pWorkerThread)
+	{
+		if (m_pWorkerThread->joinable()) { return; }
+		// Else Cleanup previous thread context
+		delete m_pWorkerThread;
+		m_pWorkerThread = nullptr;
+	}
+	m_fExit = false;
+	m_pWorkerThread = new std::thread(WorkerLoopThread, this);
+}
+
+void FindSurfaceWorker::stop()
+{
+	if (m_pWorkerThread)
+	{
+		if (m_pWorkerThread->joinable()) {
+			{
+				std::lock_guard lock(m_hMailboxMutex);
+				m_fExit = true;
+			}
+			m_cvMailbox.notify_all();
+			m_pWorkerThread->join();
+		}
+		cancel();
+		// Cleanup thread context
+		delete m_pWorkerThread;
+		m_pWorkerThread = nullptr;
+	}
+}
+
+void FindSurfaceWorker::post(Request&& request)
+{
+	Request replaced;
+	{
+		std::lock_guard lock(m_hMailboxMutex);
+		replaced = std::move(m_mailbox); // recycled outside of the lock
+		m_mailbox = std::move(request);
+		m_fHasRequest = true;
+	}
+	m_cvMailbox.notify_one();
+}
+
+void FindSurfaceWorker::cancel()
+{
+	Request dropped;
+	{
+		std::lock_guard lock(m_hMailboxMutex);
+		dropped = std::move(m_mailbox);
+		m_fHasRequest = false;
+	}
+	m_tbResult.discard();
+}
+
+bool FindSurfaceWorker::run(const Request& request, Result& result)
+{
+	FindSurfaceContextRef context = m_pContextPool->acquire();
+	if (!context) { return false; }
+
+	const PointCloudFrame& frame = *request.frame;
+	result.isFound = false;
+	result.frameTicks = frame.timestamp;
+
+	if (m_pTracer) { m_pTracer->stamp(frame.timestamp, LATENCY_STAGE_FINDSURFACE_BEGIN); }
+
+	FS_FEATURE_RESULT fsResult;
+	bool isFound = false;
+	try
+	{
+		// Set Algorithm Parameters
+		FindSurfaceHelper::FillFindSurfaceParameter(context.get(), request.distance, request.errorLevel);
+
+		// Set PointCloud Data
+		// FindSurface reads the neighbourhood of the seed point only,
+		// and the search is repeated on the whole frame if the surface reaches the boundary of that neighbourhood.
+		const float cropRadius = FindSurfaceHelper::GetCropRadius(context.get(), request.seedRadius, request.cropSeedRadiusScale);
+		unsigned int seedIdx = request.seedIndex;
+		bool isCropped = false;
+		if (frame.isLazy())
+		{
+			if (request.isCropInput) {
+				frame.lazyDepth.unprojectSphere(m_vecCandidates, &m_vecCandidatePixels, request.seedPoint, cropRadius);
+			}
+			else {
+				frame.lazyDepth.unprojectAll(m_vecCandidates, &m_vecCandidatePixels);
+			}
+
+			// Both are in pixel order, the seed pixel is always part of the sphere around it
+			seedIdx = static_cast<unsigned int>(std::lower_bound(m_vecCandidatePixels.begin(), m_vecCandidatePixels.end(), request.seedPixel) - m_vecCandidatePixels.begin());
+
+			// unprojectSphere() returns whole tiles, trim them to the sphere so that the crop boundary is exact
+			if (request.isCropInput) {
+				seedIdx = FindSurfaceHelper::CropAroundSeed(m_vecRegion, m_vecCandidates.data(), m_vecCandidates.size(), seedIdx, cropRadius);
+				isCropped = true;
+			}
+			else {
+				m_vecRegion.swap(m_vecCandidates);
+			}
+			context->setPointCloudDataFloat(m_vecRegion.data(), static_cast<unsigned int>(m_vecRegion.size()), sizeof(XMFLOAT3));
+		}
+		else if (frame.isQuantized)
+		{
+			// Decoded into the buffer of the worker, the neighbourhood of the seed point only if the input is cropped
+			const PointCloudFrame::QuantizedPointBuffer& qData = frame.quantizedPoints;
+			if (request.isCropInput)
+			{
+				seedIdx = FindSurfaceHelper::CropAroundSeed(m_vecRegion, qData.data(), qData.size(), seedIdx, cropRadius);
+				isCropped = m_vecRegion.size() < qData.size();
+			}
+			else
+			{
+				m_vecRegion.resize(qData.size());
+				DequantizePoints(m_vecRegion.data(), qData.data(), qData.size());
+			}
+			context->setPointCloudDataFloat(m_vecRegion.data(), static_cast<unsigned int>(m_vecRegion.size()), sizeof(XMFLOAT3));
+		}
+		else
+		{
+			const PointCloudFrame::PointBuffer& pcData = frame.points;
+			if (request.isCropInput)
+			{
+				seedIdx = FindSurfaceHelper::CropAroundSeed(m_vecRegion, pcData.data(), pcData.size(), seedIdx, cropRadius);
+				isCropped = m_vecRegion.size() < pcData.size();
+			}
+
+			if (isCropped) {
+				context->setPointCloudDataFloat(m_vecRegion.data(), static_cast<unsigned int>(m_vecRegion.size()), sizeof(XMFLOAT3));
+			}
+			else {
+				seedIdx = request.seedIndex;
+				context->setPointCloudDataFloat(pcData.data(), static_cast<unsigned int>(pcData.size()), sizeof(XMFLOAT3));
+			}
+		}
+
+		isFound = context->findSurface(request.type, seedIdx, request.seedRadius, fsResult);
+		if (isFound && isCropped &&
+			FindSurfaceHelper::IsTouchingCropBoundary(context->getInOutlierFlags(), m_vecRegion.data(), m_vecRegion.size(), request.seedPoint, cropRadius, context->getMeanDistance()))
+		{
+			// Fall back to the whole frame
+			unsigned int fallbackSeedIdx = request.seedIndex;
+			if (frame.isLazy())
+			{
+				frame.lazyDepth.unprojectAll(m_vecRegion, &m_vecCandidatePixels);
+				fallbackSeedIdx = static_cast<unsigned int>(std::lower_bound(m_vecCandidatePixels.begin(), m_vecCandidatePixels.end(), request.seedPixel) - m_vecCandidatePixels.begin());
+				context->setPointCloudDataFloat(m_vecRegion.data(), static_cast<unsigned int>(m_vecRegion.size()), sizeof(XMFLOAT3));
+			}
+			else if (frame.isQuantized)
+			{
+				m_vecRegion.resize(frame.quantizedPoints.size());
+				DequantizePoints(m_vecRegion.data(), frame.quantizedPoints.data(), frame.quantizedPoints.size());
+				context->setPointCloudDataFloat(m_vecRegion.data(), static_cast<unsigned int>(m_vecRegion.size()), sizeof(XMFLOAT3));
+			}
+			else
+			{
+				context->setPointCloudDataFloat(frame.points.data(), static_cast<unsigned int>(frame.points.size()), sizeof(XMFLOAT3));
+			}
+			isFound = context->findSurface(request.type, fallbackSeedIdx, request.seedRadius, fsResult);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		// A failed request must not end the worker, it is reported as not found
+		OutputDebugStringA(e.what());
+		OutputDebugString(L"\n");
+		isFound = false;
+	}
+	if (m_pTracer) { m_pTracer->stamp(frame.timestamp, LATENCY_STAGE_FINDSURFACE_END); }
+
+	if (isFound)
+	{
+		// Result to Instance Buffer
+		FindSurfaceHelper::FillConstantBufferFromResult(result.instance, &fsResult, request.headForward, request.headUp, &request.pointCloudModel);
+		result.isFound = true;
+	}
+	return true;
+}
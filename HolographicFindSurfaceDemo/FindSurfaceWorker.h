@@ -0,0 +1,94 @@
+#pragma once
+
+#ifndef _FIND_SURFACE_WORKER_H_
+#define _FIND_SURFACE_WORKER_H_
+
+#include "FindSurfaceHelper.h"
+#include "LatencyTracer.h"
+#include "Sensor/PointCloudFramePool.h"
+#include "Sensor/TripleBuffer.h"
+
+#include <condition_variable>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Runs FindSurface on a long-lived thread, on a context of a FindSurfaceContextPool that it holds for each request.
+	// The render thread post()s requests into a single slot mailbox (a newer request replaces the pending one)
+	// and polls the results, which the worker publishes into a lock-free slot. Neither thread ever waits for the other.
+	class FindSurfaceWorker
+	{
+	public:
+		struct Request
+		{
+			PointCloudFrameRef frame;                 // keeps the point cloud alive while FindSurface reads it
+			DirectX::XMFLOAT4X4 pointCloudModel;      // point cloud to stationary frame coordinates
+			FS_FEATURE_TYPE type = FS_TYPE_PLANE;
+			unsigned int seedIndex = 0;               // into the points of `frame` (quantized or not), ignored for lazy frames
+			UINT32 seedPixel = INVALID_POINT_INDEX;   // depth image pixel of the seed point of a lazy frame
+			DirectX::XMFLOAT3 seedPoint;              // camera coordinates
+			float seedRadius = 0.0f;
+			float distance = 0.0f;                    // shortest distance from head to seed point on head forward direction
+			FindSurfaceHelper::ErrorLevel errorLevel = FindSurfaceHelper::ERROR_LEVEL_NORMAL;
+			bool isCropInput = true;                  // hand over the neighbourhood of the seed point only
+			float cropSeedRadiusScale = FindSurfaceHelper::CROP_SCALE_ADAPTIVE;
+			winrt::Windows::Foundation::Numerics::float3 headForward;
+			winrt::Windows::Foundation::Numerics::float3 headUp;
+		};
+
+		struct Result
+		{
+			bool isFound = false;
+			InstanceConstantBuffer instance;
+			long long frameTicks = 0; // HostTicks of the depth frame of the request
+		};
+
+	private:
+		FindSurfaceContextPool* m_pContextPool;
+		LatencyTracer* m_pTracer;
+
+		std::thread* m_pWorkerThread = nullptr;
+		bool m_fExit = false; // Thread Exit Flag
+
+		// Mailbox (render thread -> worker)
+		std::mutex m_hMailboxMutex;
+		std::condition_variable m_cvMailbox;
+		Request m_mailbox;
+		bool m_fHasRequest = false;
+
+		// Results (worker -> render thread)
+		TripleBuffer<Result> m_tbResult;
+
+		// Input of the context (cropped or decoded points), owned by the worker (FindSurface keeps pointing to it until the next request)
+		std::vector<DirectX::XMFLOAT3> m_vecRegion;
+		std::vector<DirectX::XMFLOAT3> m_vecCandidates;
+		std::vector<UINT32> m_vecCandidatePixels;
+
+	public:
+		// `pContextPool` must outlive the worker, and may be shared with other workers.
+		FindSurfaceWorker(FindSurfaceContextPool* pContextPool, LatencyTracer* pTracer = nullptr);
+		FindSurfaceWorker(const FindSurfaceWorker&) = delete;
+		FindSurfaceWorker& operator=(const FindSurfaceWorker&) = delete;
+		~FindSurfaceWorker();
+
+		void start();
+		void stop();
+
+	public: // Render thread
+		// Replaces the pending request, if the worker did not take it yet.
+		// Quantized frames are decoded by the worker, only as far as FindSurface reads them.
+		void post(Request&& request);
+		// Drops the pending request and result, the request the worker is running still publishes its result.
+		void cancel();
+
+		// Returns the latest result, or nullptr if nothing was published since the last call.
+		// The result stays valid until the next call.
+		inline const Result* pollResult() { return m_tbResult.acquire(); }
+
+	private:
+		static void WorkerLoopThread(FindSurfaceWorker* pOwner);
+		// Returns false if every context was in use (nothing to publish, the next request tries again).
+		bool run(const Request& request, Result& result);
+	};
+};
+
+#endif
@@ -1,11 +1,18 @@
 #pragma once
 
+#include "Sensor/PointQuantization.h"
+
 namespace HolographicFindSurfaceDemo
 {
+	inline DirectX::XMVECTOR loadPickPoint(const DirectX::XMFLOAT3& point) { return DirectX::XMLoadFloat3(&point); }
+	inline DirectX::XMVECTOR loadPickPoint(const QuantizedPoint& point) { return LoadQuantizedPoint(point); }
+
+	// `TPoint` is DirectX::XMFLOAT3 (meter) or QuantizedPoint (millimeter, picked as DequantizePoints() converts it).
+	template <typename TPoint>
 	inline int pickPoint(
         const winrt::Windows::Foundation::Numerics::float3 const& gazeOrigin, 
         const winrt::Windows::Foundation::Numerics::float3 const& gazeDirection,
-        const DirectX::XMFLOAT3* pPtList, 
+        const TPoint* pPtList, 
         size_t count, 
         DirectX::XMMATRIX pointCloudModel
     )
@@ -30,7 +37,7 @@ namespace HolographicFindSurfaceDemo
         float maxCos = -FLT_MAX;
 
         for (size_t i = 0; i < count; i++) {
-            DirectX::XMVECTOR v = DirectX::XMLoadFloat3(&pPtList[i]);
+            DirectX::XMVECTOR v = loadPickPoint(pPtList[i]);
             v = DirectX::XMVectorSubtract(v, pos);
 
             float len1 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, dir));
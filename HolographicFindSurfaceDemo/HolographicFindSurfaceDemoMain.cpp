@@ -9,6 +9,7 @@
 #include <sstream> // for Debug String
 
 #include "Helper.h" // Picking
+#include "Sensor/ResearchModeImuSource.h"
 #endif
 
 using namespace HolographicFindSurfaceDemo;
@@ -59,6 +60,26 @@ using namespace winrt::Windows::Media::SpeechSynthesis;
 #define VCID_NORMAL_ERROR      0x50
 #define VCID_HIGH_ERROR        0x51
 #define VCID_LOW_ERROR         0x52
+#define VCID_ACCUMULATE_ON     0x60
+#define VCID_ACCUMULATE_OFF    0x61
+#define VCID_LONG_THROW        0x70
+#define VCID_SHORT_THROW       0x71
+#define VCID_LATENCY_REPORT    0x80
+#define VCID_COMPACT_POINTS    0x90
+#define VCID_FULL_POINTS       0x91
+#define VCID_CROP_INPUT        0xA0
+#define VCID_FULL_INPUT        0xA1
+#define VCID_REPLAY            0xB0
+#define VCID_LIVE_SENSOR       0xB1
+#define VCID_START_RECORDING   0xB2
+#define VCID_STOP_RECORDING    0xB3
+
+// Depth recording in the app's local folder (see SensorManager::startRecording())
+static std::wstring _depthRecordingPath()
+{
+    auto localFolder = winrt::Windows::Storage::ApplicationData::Current().LocalFolder();
+    return std::wstring(localFolder.Path()) + L"\\DepthRecording.bin";
+}
 #endif
 
 // Loads and initializes application assets when the application is loaded.
@@ -90,8 +111,10 @@ HolographicFindSurfaceDemoMain::HolographicFindSurfaceDemoMain(std::shared_ptr<D
     // Initialize Voice UI(s).
     InitializeVoiceUIPrompt();
 
-    // Initialize FindSurface Context (singleton instance)
-    m_pFS = FindSurface::getInstance();
+    // Initialize FindSurface Contexts (one per worker thread)
+    m_pFSContextPool = std::make_unique<FindSurfaceContextPool>(1);
+    m_pFSWorker = std::make_unique<FindSurfaceWorker>(m_pFSContextPool.get(), &m_latencyTracer);
+    m_pFSWorker->start();
 #endif
 }
 
@@ -156,6 +179,27 @@ void HolographicFindSurfaceDemoMain::InitializeSpeechCommandList()
     m_speechCommandData.Insert(L"normal error", VCID_NORMAL_ERROR);
     m_speechCommandData.Insert(L"high error", VCID_HIGH_ERROR);
     m_speechCommandData.Insert(L"low error", VCID_LOW_ERROR);
+
+    m_speechCommandData.Insert(L"accumulate points", VCID_ACCUMULATE_ON);
+    m_speechCommandData.Insert(L"single frame", VCID_ACCUMULATE_OFF);
+
+    m_speechCommandData.Insert(L"long throw", VCID_LONG_THROW);
+    m_speechCommandData.Insert(L"far mode", VCID_LONG_THROW);
+    m_speechCommandData.Insert(L"short throw", VCID_SHORT_THROW);
+    m_speechCommandData.Insert(L"near mode", VCID_SHORT_THROW);
+
+    m_speechCommandData.Insert(L"latency report", VCID_LATENCY_REPORT);
+
+    m_speechCommandData.Insert(L"compact points", VCID_COMPACT_POINTS);
+    m_speechCommandData.Insert(L"full points", VCID_FULL_POINTS);
+
+    m_speechCommandData.Insert(L"crop input", VCID_CROP_INPUT);
+    m_speechCommandData.Insert(L"full input", VCID_FULL_INPUT);
+
+    m_speechCommandData.Insert(L"replay recording", VCID_REPLAY);
+    m_speechCommandData.Insert(L"live sensor", VCID_LIVE_SENSOR);
+    m_speechCommandData.Insert(L"start recording", VCID_START_RECORDING);
+    m_speechCommandData.Insert(L"stop recording", VCID_STOP_RECORDING);
 }
 
 void HolographicFindSurfaceDemoMain::InitializeVoiceUIPrompt()
@@ -387,27 +431,53 @@ task<bool> HolographicFindSurfaceDemoMain::StartRecognizeSpeechCommands()
 
 void HolographicFindSurfaceDemoMain::HandlePointCloudStream()
 {
-    std::vector<DirectX::XMFLOAT3> buffer;
-    long long timestamp = 0;
-
-    if (m_pSM->getUpdatedData(buffer, timestamp))
+    PointCloudFrameRef frame = m_pSM->acquireLatestFrame();
+    if (frame)
     {
+        m_latencyTracer.stamp(frame->timestamp, LATENCY_STAGE_CONSUMED);
+
+        // Accumulated points are already in our stationary coordinate system (identity model).
+        // Replayed streams have no rig node to locate: use the recorded rig pose (relative to the recording's
+        // coordinate system, placed at the origin of ours), or keep the rig pose at the origin.
+        float4x4 rigNodeToCoordinateSystem = float4x4::identity();
+        if (frame->hasRigPose && !frame->isWorldSpace) {
+            DirectX::XMStoreFloat4x4(&rigNodeToCoordinateSystem, DirectX::XMLoadFloat4x4(&frame->rigPose));
+        }
+
         auto locator = m_pSM->spatialLocator();
-        auto pts = PerceptionTimestampHelper::FromSystemRelativeTargetTime(HundredsOfNanoseconds(timestamp));
+        if (locator && !frame->isWorldSpace)
+        {
+            auto pts = PerceptionTimestampHelper::FromSystemRelativeTargetTime(HundredsOfNanoseconds(frame->timestamp));
+
+            auto location = locator.TryLocateAtTimestamp(pts, m_stationaryReferenceFrame.CoordinateSystem());
+            if (!location) { return; }
 
-        auto location = locator.TryLocateAtTimestamp(pts, m_stationaryReferenceFrame.CoordinateSystem());
-        float4x4 rigNodeToCoordinateSystem = make_float4x4_from_quaternion(location.Orientation()) * make_float4x4_translation(location.Position());
+            rigNodeToCoordinateSystem = make_float4x4_from_quaternion(location.Orientation()) * make_float4x4_translation(location.Position());
+        }
 
-        DirectX::XMMATRIX c2r = DirectX::XMLoadFloat4x4(m_pSM->getCameraNodeToRigNode());
+        DirectX::XMMATRIX c2r = frame->isWorldSpace ? DirectX::XMMatrixIdentity() : DirectX::XMLoadFloat4x4(m_pSM->getCameraNodeToRigNode());
         DirectX::XMMATRIX r2g = DirectX::XMLoadFloat4x4(&rigNodeToCoordinateSystem);
         DirectX::XMMATRIX pointCloudModel = DirectX::XMMatrixMultiply(c2r, r2g);
 
         // Update to member variable
-        m_vecPrevPCData.swap(buffer);
+        m_refPrevPCFrame = frame;
         DirectX::XMStoreFloat4x4(&m_matPrevPCModel, pointCloudModel);
-        m_nPrevPCTimestamp = timestamp;
+        m_nPrevPCTimestamp = frame->timestamp;
 
-        m_pointCloudRenderer->UpdatePointCloudBuffer(m_vecPrevPCData.data(), m_vecPrevPCData.size(), pointCloudModel);
+        if (frame->isLazy())
+        {
+            // Lazy frames are only published while the point cloud is hidden
+            m_pointCloudRenderer->ClearPointCloudBuffer();
+        }
+        else if (frame->isQuantized)
+        {
+            // Uploaded as int16, the vertex shader converts them to meter
+            m_pointCloudRenderer->UpdatePointCloudBuffer(frame->quantizedPoints.data(), frame->quantizedPoints.size(), pointCloudModel);
+        }
+        else
+        {
+            m_pointCloudRenderer->UpdatePointCloudBuffer(frame->points.data(), frame->points.size(), pointCloudModel);
+        }
     }
 }
 
@@ -460,9 +530,11 @@ void HolographicFindSurfaceDemoMain::HandleVoiceCommand()
             break;
         case VCID_SHOW_POINTCLOUD:
             m_isShowPointCloud = true;
+            m_pSM->setLazyUnprojection(false);
             break;
         case VCID_HIDE_POINTCLOUD:
             m_isShowPointCloud = false;
+            m_pSM->setLazyUnprojection(true);
             break;
         case VCID_SHOW_CURSOR:
             m_isShowCursor = true;
@@ -473,10 +545,12 @@ void HolographicFindSurfaceDemoMain::HandleVoiceCommand()
         case VCID_SHOW_ALL:
             m_isShowPointCloud = true;
             m_isShowCursor = true;
+            m_pSM->setLazyUnprojection(false);
             break;
         case VCID_HIDE_ALL:
             m_isShowPointCloud = false;
             m_isShowCursor = false;
+            m_pSM->setLazyUnprojection(true);
             break;
         case VCID_VERY_SMALL_RADIUS:
             m_gazePointRenderer->SetSeedRadiusAtMeter(0.025f);
@@ -505,12 +579,158 @@ void HolographicFindSurfaceDemoMain::HandleVoiceCommand()
             m_errorLevel = FindSurfaceHelper::ERROR_LEVEL_LOW;
             m_gazePointRenderer->SetCircleIndex(CIRCLE_INDEX_LOW);
             break;
+        case VCID_ACCUMULATE_ON:
+            if (m_stationaryReferenceFrame) {
+                m_isAccumulatingPoints = true;
+                m_pSM->startAccumulation(m_stationaryReferenceFrame.CoordinateSystem());
+            }
+            break;
+        case VCID_ACCUMULATE_OFF:
+            m_isAccumulatingPoints = false;
+            m_pSM->stopAccumulation();
+            break;
+        case VCID_LONG_THROW:
+            SwitchDepthSensor(DEPTH_LONG_THROW);
+            break;
+        case VCID_SHORT_THROW:
+            SwitchDepthSensor(DEPTH_AHAT);
+            break;
+        case VCID_LATENCY_REPORT:
+            OutputDebugString(m_latencyTracer.report().c_str());
+            OutputDebugString(m_pFSContextPool->report().c_str());
+            {
+                SensorManager::FrameStatistics stat = m_pSM->getFrameStatistics();
+                std::wostringstream wss;
+                wss << L"Frames processed: " << stat.processedCount << L", wasted: " << stat.wastedCount
+                    << L", skipped: " << stat.skippedCount << L", deferred: " << stat.deferredCount << std::endl;
+                OutputDebugString(wss.str().c_str());
+            }
+            break;
+        case VCID_COMPACT_POINTS:
+            m_pSM->setQuantized(true);
+            break;
+        case VCID_FULL_POINTS:
+            m_pSM->setQuantized(false);
+            break;
+
+        case VCID_CROP_INPUT:
+            m_isCropFindSurfaceInput = true;
+            break;
+        case VCID_FULL_INPUT:
+            m_isCropFindSurfaceInput = false;
+            break;
+
+        case VCID_REPLAY:
+            ReplayDepthRecording();
+            break;
+        case VCID_LIVE_SENSOR:
+            SwitchDepthSensor(m_depthSensorType);
+            break;
+        case VCID_START_RECORDING:
+            if (m_stationaryReferenceFrame) {
+                m_pSM->startRecording(_depthRecordingPath(), m_stationaryReferenceFrame.CoordinateSystem());
+            }
+            break;
+        case VCID_STOP_RECORDING:
+            {
+                const size_t frameCount = m_pSM->stopRecording();
+                std::wostringstream wss;
+                wss << L"Depth frames recorded: " << frameCount << std::endl;
+                OutputDebugString(wss.str().c_str());
+            }
+            break;
         }
 
         m_gazePointRenderer->SetRotateSpeed(m_runFindSurface ? ROTATE_FAST_SPEED : ROTATE_NORMAL_SPEED);
     }
 }
 
+void HolographicFindSurfaceDemoMain::SwitchDepthSensor(ResearchModeSensorType sensorType)
+{
+    if (sensorType == m_depthSensorType && !m_isReplaying) { return; }
+
+    try
+    {
+        m_pSM->initializeSensor(sensorType);
+        m_depthSensorType = sensorType;
+        m_isReplaying = false;
+    }
+    catch (const winrt::hresult_error&)
+    {
+        // The current source is only replaced once the new sensor is initialized
+        OutputDebugString(L"Failed to switch depth sensor\n");
+    }
+    m_pSM->startSensor();
+}
+
+void HolographicFindSurfaceDemoMain::ReplayDepthRecording()
+{
+    try
+    {
+        auto pRecording = std::make_shared<MappedDepthRecording>(_depthRecordingPath());
+        if (pRecording->frameCount() > 0)
+        {
+            // In real time and looped, every frame is processed (SensorManager::BACK_PRESSURE_NONE)
+            auto pSource = std::make_unique<DepthReplaySource>(pRecording, DepthReplaySource::PACING_REAL_TIME);
+            pSource->setLoop(true);
+            m_pSM->setFrameSource(std::move(pSource));
+            m_isReplaying = true;
+        }
+        else {
+            OutputDebugString(L"Depth recording is empty\n");
+        }
+    }
+    catch (const winrt::hresult_error&)
+    {
+        OutputDebugString(L"No depth recording to replay\n");
+    }
+    catch (const std::runtime_error&)
+    {
+        OutputDebugString(L"Invalid depth recording\n");
+    }
+    m_pSM->startSensor();
+}
+
+int HolographicFindSurfaceDemoMain::PickLazyFrame(const float3& gazeOrigin, const float3& gazeDirection, DirectX::XMMATRIX pointCloudModel)
+{
+    // Wide enough to hold every point pickPoint() accepts inside its probe radius
+    constexpr float LAZY_PICK_CONE_TAN = 0.1f;
+
+    const LazyDepthImage& image = m_refPrevPCFrame->lazyDepth;
+
+    // Gaze ray in point cloud (camera) coordinates, as pickPoint() computes it
+    DirectX::XMVECTOR det = DirectX::XMMatrixDeterminant(pointCloudModel);
+    DirectX::XMMATRIX inverseModel = DirectX::XMMatrixInverse(&det, pointCloudModel);
+    DirectX::XMVECTOR pos = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&gazeOrigin), inverseModel);
+    DirectX::XMVECTOR dir = DirectX::XMVector3Normalize(DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&gazeDirection), inverseModel));
+
+    DirectX::XMFLOAT3 origin, direction;
+    DirectX::XMStoreFloat3(&origin, pos);
+    DirectX::XMStoreFloat3(&direction, dir);
+
+    image.unprojectCone(m_vecLazyPoints, &m_vecLazyPixels, origin, direction, LAZY_PICK_CONE_TAN);
+    int pickIdx = pickPoint(gazeOrigin, gazeDirection, m_vecLazyPoints.data(), m_vecLazyPoints.size(), pointCloudModel);
+
+    // A pick inside the cone is the pick of the whole frame: the cone holds every point inside the probe radius,
+    // and every point closer in angle than a point inside the cone. Otherwise search the whole frame.
+    bool isExact = false;
+    if (pickIdx >= 0)
+    {
+        DirectX::XMVECTOR v = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&m_vecLazyPoints[pickIdx]), pos);
+        float t = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, dir));
+        float distSq = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(v));
+        isExact = t > 0.0f && (distSq - t * t) <= LAZY_PICK_CONE_TAN * LAZY_PICK_CONE_TAN * t * t;
+    }
+
+    if (!isExact)
+    {
+        image.unprojectAll(m_vecLazyPoints, &m_vecLazyPixels);
+        pickIdx = pickPoint(gazeOrigin, gazeDirection, m_vecLazyPoints.data(), m_vecLazyPoints.size(), pointCloudModel);
+    }
+
+    return pickIdx;
+}
+
 bool HolographicFindSurfaceDemoMain::GetGazeInput(const SpatialPointerPose& pose, float3& outOrigin, float3& outDirection)
 {
     // Use Eye-gaze, if possible
@@ -603,9 +823,26 @@ void HolographicFindSurfaceDemoMain::SetHolographicSpace(HolographicSpace const&
     m_meshRenderer = std::make_unique<MeshRenderer>(m_deviceResources);
     // Initialize the Sensor Manager.
     m_pSM = std::make_unique<SensorManager>();
+    m_pSM->setLatencyTracer(&m_latencyTracer);
+    m_pSM->setSpatialIndex(true);
+    m_pSM->setOrganized(true);
     m_pSM->initializeSensor();
     m_pSM->startSensor();
 
+    // Gyroscope samples for readout motion compensation (SensorManager::setMotionCompensation()),
+    // which stays off until the readout time of the depth sensors is calibrated.
+    try
+    {
+        auto pGyroSource = std::make_unique<ResearchModeImuSource>(IMU_GYRO);
+        pGyroSource->initialize();
+        m_pImuStream = std::make_shared<ImuStream>(std::move(pGyroSource));
+        m_pImuStream->start();
+    }
+    catch (const winrt::hresult_error&)
+    {
+        OutputDebugString(L"Failed to initialize the gyroscope\n");
+    }
+
     // Preload audio assets for audio cues.
     HRESULT hr;
     hr = m_recognitionSound.Initialize(L"Audio//BasicResultsEarcon.wav", 0);
@@ -686,7 +923,9 @@ void HolographicFindSurfaceDemoMain::UnregisterHolographicEventHandlers()
 HolographicFindSurfaceDemoMain::~HolographicFindSurfaceDemoMain()
 {
 #ifdef DRAW_SAMPLE_CONTENT
+    if (m_pFSWorker) { m_pFSWorker->stop(); }
     if (m_pSM) { m_pSM->stopSensor(); }
+    if (m_pImuStream) { m_pImuStream->stop(); }
 #endif
 
     // Deregister device notification.
@@ -756,10 +995,25 @@ HolographicFrame HolographicFindSurfaceDemoMain::Update(HolographicFrame const&
         // Check for new speech input since the last frame.
         HandleVoiceCommand();
 
+        // Apply the latest FindSurface result since the last frame.
+        if (const FindSurfaceWorker::Result* pResult = m_pFSWorker->pollResult())
+        {
+            if (m_runFindSurface && pResult->isFound) {
+                m_meshRenderer->SetCurrentModel(pResult->instance);
+                m_latencyTracer.stamp(pResult->frameTicks, LATENCY_STAGE_APPLIED);
+            }
+            else {
+                m_meshRenderer->ClearCurrentModel();
+            }
+        }
+
         SpatialPointerPose pose = SpatialPointerPose::TryGetAtTimestamp(m_stationaryReferenceFrame.CoordinateSystem(), prediction.Timestamp());
         // When, Point-cloud is not empty && Success to get `SpatialPointerPose`
-        if (pose && !m_vecPrevPCData.empty())
+        if (pose && m_refPrevPCFrame && (m_refPrevPCFrame->pointCount() > 0 || m_refPrevPCFrame->isLazy()))
         {
+            const PointCloudFrame& frame = *m_refPrevPCFrame;
+            const bool isLazyFrame = frame.isLazy();
+
             // Ready to picking
             float3 gazeOrigin;
             float3 gazeDirection;
@@ -767,14 +1021,48 @@ HolographicFrame HolographicFindSurfaceDemoMain::Update(HolographicFrame const&
             DirectX::XMMATRIX pcModel = DirectX::XMLoadFloat4x4(&m_matPrevPCModel); // Transform Matrix (PointCloud Coordinate System to StationaryFrame Coordinate System).
 
             // Try picking point cloud with gaze input
-            int pickIdx = pickPoint(gazeOrigin, gazeDirection, m_vecPrevPCData.data(), m_vecPrevPCData.size(), pcModel);
+            int pickIdx = -1;
+            DirectX::XMFLOAT3 pickPosition; // point cloud coordinates
+            if (isLazyFrame)
+            {
+                pickIdx = PickLazyFrame(gazeOrigin, gazeDirection, pcModel);
+                if (pickIdx >= 0) { pickPosition = m_vecLazyPoints[pickIdx]; }
+            }
+            else
+            {
+                // Depth image band around the gaze ray (narrowed by the last hit), then the cells along it, then every point
+                // (on the int16 points as they are, there is no float copy of a quantized frame)
+                const DirectX::XMFLOAT3 origin(gazeOrigin.x, gazeOrigin.y, gazeOrigin.z);
+                const DirectX::XMFLOAT3 direction(gazeDirection.x, gazeDirection.y, gazeDirection.z);
+                auto pickFrame = [&](const auto& pcData)
+                {
+                    int idx = -1;
+                    const bool isImagePicked = frame.isOrganized() && frame.imageProjection &&
+                        m_imageSpacePicker.pickCoherent(*frame.imageProjection, frame.pixelToIndex.data(), origin, direction, pcData.data(), pcData.size(), pcModel, idx);
+                    if (!isImagePicked && !frame.gridIndex.pick(origin, direction, pcData.data(), pcData.size(), pcModel, idx))
+                    {
+                        idx = frame.hasPointsSoA ?
+                            PickPointSoA(origin, direction, frame.pointsX.data(), frame.pointsY.data(), frame.pointsZ.data(), frame.pointCount(), pcModel) :
+                            pickPoint(gazeOrigin, gazeDirection, pcData.data(), pcData.size(), pcModel);
+                    }
+                    return idx;
+                };
+                pickIdx = frame.isQuantized ? pickFrame(frame.quantizedPoints) : pickFrame(frame.points);
+                if (pickIdx >= 0) { pickPosition = frame.pointAt(pickIdx); }
+            }
+            // Once per point cloud frame, the picks of the following render frames on the same frame are not part of its latency
+            if (m_nPickedPCTimestamp != m_nPrevPCTimestamp)
+            {
+                m_latencyTracer.stamp(m_nPrevPCTimestamp, LATENCY_STAGE_PICKED);
+                m_nPickedPCTimestamp = m_nPrevPCTimestamp;
+            }
             if (pickIdx >= 0)
             {
                 float3 headPosition = pose.Head().Position();
                 float3 headForward = pose.Head().ForwardDirection();
                 float3 headUp = pose.Head().UpDirection();
 
-                DirectX::XMVECTOR pickedPoint = DirectX::XMLoadFloat3(&m_vecPrevPCData[pickIdx]);
+                DirectX::XMVECTOR pickedPoint = DirectX::XMLoadFloat3(&pickPosition);
                 pickedPoint = DirectX::XMVector3TransformCoord(pickedPoint, pcModel); // Transform Point Cloud Coordinates to StationaryFrame Coordinates
 
                 float3 seedPosition;
@@ -783,53 +1071,25 @@ HolographicFrame HolographicFindSurfaceDemoMain::Update(HolographicFrame const&
                 // Update Gaze Renderer Here!!
                 m_gazePointRenderer->PositionGazePointUI(pose, seedPosition);
 
-                // Run FindSurface Here!!
-                if (m_runFindSurface && !m_isFindSurfaceBusy)
+                // Run FindSurface Here!! (the worker takes the latest request once the running one ends)
+                if (m_runFindSurface)
                 {
-                    m_isFindSurfaceBusy = true;
-
+                    FindSurfaceWorker::Request request;
+                    request.frame = m_refPrevPCFrame;
+                    request.pointCloudModel = m_matPrevPCModel;
+                    request.type = m_findType;
+                    request.seedIndex = static_cast<unsigned int>(pickIdx);
+                    request.seedPixel = isLazyFrame ? m_vecLazyPixels[pickIdx] : INVALID_POINT_INDEX;
+                    request.seedPoint = pickPosition;
                     // Shortest distance from head to seed point on head forward direction.
-                    float distance = m_gazePointRenderer->GetHeadForwardDistanceToGazePoint();
-                    float seedRadius = m_gazePointRenderer->GetSeedRadiusAtGazePoint();
-
-                    // Set Algorithm Parameters
-                    FindSurfaceHelper::FillFindSurfaceParameter(m_pFS, distance, m_errorLevel);
-                    // Set PointCloud Data
-                    m_pFS->setPointCloudDataFloat(m_vecPrevPCData.data(), static_cast<unsigned int>(m_vecPrevPCData.size()), sizeof(DirectX::XMFLOAT3));
-                    // Run FindSurface Async
-                    create_task(
-                        [this, type = m_findType, pickIdx, seedRadius, headForward, headUp, pointCloudModel = m_matPrevPCModel]
-                        {
-                            auto result = m_pFS->findSurface(type, static_cast<unsigned int>(pickIdx), seedRadius);
-                            if (result != nullptr)
-                            {
-                                // Result to Instance Buffer
-                                InstanceConstantBuffer instance;
-                                FindSurfaceHelper::FillConstantBufferFromResult(instance, result.get(), headForward, headUp, &pointCloudModel);
-                                winrt::Windows::ApplicationModel::Core::CoreApplication::MainView().CoreWindow().Dispatcher().RunAsync(
-                                    winrt::Windows::UI::Core::CoreDispatcherPriority::High,
-                                    [this, &instance] {
-                                        if (m_runFindSurface) {
-                                            m_meshRenderer->SetCurrentModel(instance);
-                                        }
-                                        else {
-                                            m_meshRenderer->ClearCurrentModel();
-                                        }
-                                    }
-                                ).get();
-                            }
-                            else
-                            {
-                                winrt::Windows::ApplicationModel::Core::CoreApplication::MainView().CoreWindow().Dispatcher().RunAsync(
-                                    winrt::Windows::UI::Core::CoreDispatcherPriority::High,
-                                    [this] { m_meshRenderer->ClearCurrentModel(); }
-                                ).get();
-                            }
-
-                            m_isFindSurfaceBusy = false;
-                        }
-                    );
-                        
+                    request.distance = m_gazePointRenderer->GetHeadForwardDistanceToGazePoint();
+                    request.seedRadius = m_gazePointRenderer->GetSeedRadiusAtGazePoint();
+                    request.errorLevel = m_errorLevel;
+                    request.isCropInput = m_isCropFindSurfaceInput;
+                    request.cropSeedRadiusScale = m_cropSeedRadiusScale;
+                    request.headForward = headForward;
+                    request.headUp = headUp;
+                    m_pFSWorker->post(std::move(request));
                 }
             }
         }
@@ -1026,8 +1286,9 @@ void HolographicFindSurfaceDemoMain::EnteredBackground()
 
     m_isAppEnteredBackground = true;
     if (m_pSM) { m_pSM->stopSensor(); }
+    if (m_pImuStream) { m_pImuStream->stop(); }
     m_runFindSurface = false;
-    m_isFindSurfaceBusy = false;
+    m_pFSWorker->cancel();
     m_meshRenderer->ClearCurrentModel();
 
     //StopCurrentRecognizerIfExists();
@@ -1041,6 +1302,7 @@ void HolographicFindSurfaceDemoMain::LeavingBackground()
     {
         m_isAppEnteredBackground = false;
         if (m_pSM) { m_pSM->startSensor(); }
+        if (m_pImuStream) { m_pImuStream->start(); }
 
         //if (m_isMicAvailable)
         //{
@@ -1210,6 +1472,11 @@ void HolographicFindSurfaceDemoMain::OnHolographicDisplayIsAvailableChanged(winr
             // based on a SpatialLocator. This is roughly analogous to creating a "world" coordinate system
             // with the origin placed at the device's position as the app is launched.
             m_stationaryReferenceFrame = m_spatialLocator.CreateStationaryFrameOfReferenceAtCurrentLocation();
+
+            // Accumulated points are expressed in the previous stationary frame, start over
+            if (m_isAccumulatingPoints && m_pSM) {
+                m_pSM->startAccumulation(m_stationaryReferenceFrame.CoordinateSystem());
+            }
         }
     }
 }
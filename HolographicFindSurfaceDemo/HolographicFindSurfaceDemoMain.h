@@ -19,6 +19,7 @@
 #include "Content/MeshRenderer.h"
 
 #include "SensorManager.h"
+#include "LatencyTracer.h"
 
 #include "Audio/OmnidirectionalSound.h"
 
@@ -26,6 +27,7 @@
 
 #include <FindSurface.hpp>
 #include "FindSurfaceHelper.h"
+#include "FindSurfaceWorker.h"
 #endif
 
 // Updates, renders, and presents holographic content using Direct3D.
@@ -88,6 +90,17 @@ namespace HolographicFindSurfaceDemo
 #ifdef DRAW_SAMPLE_CONTENT
         void HandlePointCloudStream();
         void HandleVoiceCommand();
+        // Restarts the sensor thread with another Research Mode depth sensor (keeps the current one on failure).
+        void SwitchDepthSensor(ResearchModeSensorType sensorType);
+        // Replays the depth recording through the sensor thread in place of the live sensor (keeps the current source on failure).
+        void ReplayDepthRecording();
+        // Picks a lazy frame through the points of a cone around the gaze ray, and the whole frame if that cannot
+        // match pickPoint() on the full cloud. Returns an index into m_vecLazyPoints.
+        int PickLazyFrame(
+            const winrt::Windows::Foundation::Numerics::float3& gazeOrigin,
+            const winrt::Windows::Foundation::Numerics::float3& gazeDirection,
+            DirectX::XMMATRIX pointCloudModel
+        );
         // Return true, if gaze source can be acquried eye or hand.
         bool GetGazeInput(
             const winrt::Windows::UI::Input::Spatial::SpatialPointerPose& pose,
@@ -131,9 +144,18 @@ namespace HolographicFindSurfaceDemo
 
         // Sensor Manager
         std::unique_ptr<SensorManager>                              m_pSM;
-        std::vector<DirectX::XMFLOAT3>                              m_vecPrevPCData;  // latest PointCloud Data
+        PointCloudFrameRef                                          m_refPrevPCFrame; // latest PointCloud Frame (pooled by SensorManager)
         DirectX::XMFLOAT4X4                                         m_matPrevPCModel; // latest PointCloud Model Matrix
         long long                                                   m_nPrevPCTimestamp = 0; // latest PointCloud Timestamp
+        long long                                                   m_nPickedPCTimestamp = 0; // PointCloud Timestamp of the last LATENCY_STAGE_PICKED stamp
+        bool                                                        m_isAccumulatingPoints = false; // multi-frame world space accumulation
+        ResearchModeSensorType                                      m_depthSensorType = DEPTH_LONG_THROW;
+        bool                                                        m_isReplaying = false; // depth recording in place of the live sensor
+        LatencyTracer                                               m_latencyTracer; // motion-to-surface latency per stage
+        std::vector<DirectX::XMFLOAT3>                              m_vecLazyPoints; // picking region of a lazy frame
+        std::vector<UINT32>                                         m_vecLazyPixels; // pixel index of m_vecLazyPoints
+        ImageSpacePicker                                            m_imageSpacePicker; // picks organized frames in the depth image, from the last hit
+        std::shared_ptr<ImuStream>                                  m_pImuStream; // gyroscope, nullptr if unavailable
 
         // Eye-gaze input
         bool                                                        m_isEyeTrackingEnabled = false;
@@ -157,11 +179,13 @@ namespace HolographicFindSurfaceDemo
         uint32_t                                                      m_lastHandId = 0;
 
         // FindSurface Related
-        FindSurface                                                 *m_pFS = nullptr;
-        bool                                                         m_isFindSurfaceBusy = false;
+        std::unique_ptr<FindSurfaceContextPool>                      m_pFSContextPool;
+        std::unique_ptr<FindSurfaceWorker>                           m_pFSWorker; // runs FindSurface on the contexts of m_pFSContextPool
         bool                                                         m_runFindSurface = false;
         FS_FEATURE_TYPE                                              m_findType = FS_TYPE_PLANE;
         FindSurfaceHelper::ErrorLevel                                m_errorLevel = FindSurfaceHelper::ERROR_LEVEL_NORMAL;
+        bool                                                         m_isCropFindSurfaceInput = true; // hand over the neighbourhood of the seed point only
+        float                                                        m_cropSeedRadiusScale = FindSurfaceHelper::CROP_SCALE_ADAPTIVE;
 
         // Show/Hide UI Component
         bool                                                         m_isShowPointCloud = true;
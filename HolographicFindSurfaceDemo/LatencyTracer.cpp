@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "LatencyTracer.h"
+
+#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+
+using namespace HolographicFindSurfaceDemo;
+
+namespace
+{
+	const wchar_t* STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+		L"acquired",
+		L"unprojected",
+		L"published",
+		L"consumed",
+		L"picked",
+		L"findsurface begin",
+		L"findsurface end",
+		L"applied"
+	};
+
+	constexpr float TICKS_TO_MS = 1.0e-4f; // 100 ns -> ms
+
+	// Nearest-rank percentile of a sorted sample
+	inline float percentile(const std::vector<float>& sorted, float p)
+	{
+		if (sorted.empty()) { return 0.0f; }
+		size_t rank = static_cast<size_t>(ceilf(p * static_cast<float>(sorted.size())));
+		return sorted[rank > 0 ? rank - 1 : 0];
+	}
+}
+
+long long LatencyTracer::now()
+{
+	static const long long frequency = [] {
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		return f.QuadPart;
+	}();
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Split to avoid overflow of counter * 10^7
+	const long long seconds = counter.QuadPart / frequency;
+	const long long remainder = counter.QuadPart % frequency;
+	return seconds * 10'000'000ll + remainder * 10'000'000ll / frequency;
+}
+
+void LatencyTracer::stamp(long long frameTicks, LatencyStage stage, long long stampTicks)
+{
+	if (!m_fEnabled.load(std::memory_order_relaxed)) { return; }
+
+	const uint64_t ticket = m_nHead.fetch_add(1, std::memory_order_relaxed);
+	Event& ev = m_pRing[ticket & (RING_SIZE - 1)];
+
+	// Seqlock style: readers discard events whose sequence changes while they read them
+	ev.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	ev.frameTicks.store(frameTicks, std::memory_order_relaxed);
+	ev.stampTicks.store(stampTicks, std::memory_order_relaxed);
+	ev.stage.store(stage, std::memory_order_relaxed);
+	ev.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+std::array<LatencyTracer::StageStatistics, LATENCY_STAGE_COUNT> LatencyTracer::summarize() const
+{
+	struct Sample
+	{
+		long long frameTicks;
+		long long stampTicks;
+		uint32_t stage;
+	};
+
+	// Snapshot
+	std::vector<Sample> samples;
+	samples.reserve(RING_SIZE);
+	for (uint32_t i = 0; i < RING_SIZE; i++)
+	{
+		const Event& ev = m_pRing[i];
+		uint64_t sequence = ev.sequence.load(std::memory_order_acquire);
+		if (sequence == 0) { continue; }
+
+		Sample sample;
+		sample.frameTicks = ev.frameTicks.load(std::memory_order_relaxed);
+		sample.stampTicks = ev.stampTicks.load(std::memory_order_relaxed);
+		sample.stage = ev.stage.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (ev.sequence.load(std::memory_order_relaxed) != sequence || sample.stage >= LATENCY_STAGE_COUNT) { continue; } // overwritten meanwhile
+
+		samples.push_back(sample);
+	}
+
+	// Per frame stamps, to measure stage deltas
+	std::unordered_map<long long, std::array<long long, LATENCY_STAGE_COUNT>> frames;
+	for (const Sample& sample : samples)
+	{
+		auto it = frames.find(sample.frameTicks);
+		if (it == frames.end()) {
+			std::array<long long, LATENCY_STAGE_COUNT> stamps;
+			stamps.fill(-1);
+			it = frames.emplace(sample.frameTicks, stamps).first;
+		}
+		// A stage may be stamped more than once per frame (e.g. picked every render frame), keep the first
+		long long& stamp = it->second[sample.stage];
+		if (stamp < 0 || sample.stampTicks < stamp) { stamp = sample.stampTicks; }
+	}
+
+	std::array<std::vector<float>, LATENCY_STAGE_COUNT> totals;
+	std::array<std::vector<float>, LATENCY_STAGE_COUNT> deltas;
+	for (const auto& [frameTicks, stamps] : frames)
+	{
+		long long previous = -1;
+		for (uint32_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+		{
+			if (stamps[stage] < 0) { continue; }
+
+			totals[stage].push_back(static_cast<float>(stamps[stage] - frameTicks) * TICKS_TO_MS);
+			if (previous >= 0) {
+				deltas[stage].push_back(static_cast<float>(stamps[stage] - previous) * TICKS_TO_MS);
+			}
+			previous = stamps[stage];
+		}
+	}
+
+	std::array<StageStatistics, LATENCY_STAGE_COUNT> statistics;
+	for (uint32_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		std::sort(totals[stage].begin(), totals[stage].end());
+		std::sort(deltas[stage].begin(), deltas[stage].end());
+
+		StageStatistics& st = statistics[stage];
+		st.count = static_cast<uint32_t>(totals[stage].size());
+		st.p50 = percentile(totals[stage], 0.50f);
+		st.p95 = percentile(totals[stage], 0.95f);
+		st.p99 = percentile(totals[stage], 0.99f);
+		st.deltaP50 = percentile(deltas[stage], 0.50f);
+		st.deltaP95 = percentile(deltas[stage], 0.95f);
+		st.deltaP99 = percentile(deltas[stage], 0.99f);
+	}
+	return statistics;
+}
+
+std::wstring LatencyTracer::report() const
+{
+	auto statistics = summarize();
+
+	std::wostringstream wss;
+	wss << std::fixed << std::setprecision(2);
+	wss << L"stage: count | since exposure p50/p95/p99 ms | since previous stage p50/p95/p99 ms" << std::endl;
+	for (uint32_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		const StageStatistics& st = statistics[stage];
+		wss << STAGE_NAMES[stage] << L": " << st.count
+			<< L" | " << st.p50 << L" / " << st.p95 << L" / " << st.p99
+			<< L" | " << st.deltaP50 << L" / " << st.deltaP95 << L" / " << st.deltaP99 << std::endl;
+	}
+	return wss.str();
+}
+
+void LatencyTracer::clear()
+{
+	for (uint32_t i = 0; i < RING_SIZE; i++) {
+		m_pRing[i].sequence.store(0, std::memory_order_relaxed);
+	}
+}
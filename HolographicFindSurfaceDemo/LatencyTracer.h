@@ -0,0 +1,81 @@
+#pragma once
+
+#ifndef _LATENCY_TRACER_H_
+#define _LATENCY_TRACER_H_
+
+#include <atomic>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Pipeline stages of a depth frame, in order.
+	enum LatencyStage : uint32_t
+	{
+		LATENCY_STAGE_ACQUIRED = 0,    // Depth frame acquired by the sensor thread
+		LATENCY_STAGE_UNPROJECTED,     // Point cloud ready (unprojection, filters)
+		LATENCY_STAGE_PUBLISHED,       // Handed to the render thread
+		LATENCY_STAGE_CONSUMED,        // Picked up by HandlePointCloudStream
+		LATENCY_STAGE_PICKED,          // Gaze picking done
+		LATENCY_STAGE_FINDSURFACE_BEGIN,
+		LATENCY_STAGE_FINDSURFACE_END,
+		LATENCY_STAGE_APPLIED,         // Surface applied to MeshRenderer by Update
+		LATENCY_STAGE_COUNT
+	};
+
+	// Lightweight per-stage latency tracing.
+	// Any thread stamps (frame, stage) events into a fixed size lock-free ring (oldest events are overwritten);
+	// summarize() computes percentiles over the events currently in the ring.
+	// Frames are identified by their HostTicks, which share the QueryPerformanceCounter time base of now().
+	class LatencyTracer
+	{
+	public:
+		struct StageStatistics
+		{
+			uint32_t count = 0;
+			// Since exposure (frame HostTicks), milliseconds
+			float p50 = 0.0f;
+			float p95 = 0.0f;
+			float p99 = 0.0f;
+			// Since the previous stamped stage of the same frame, milliseconds
+			float deltaP50 = 0.0f;
+			float deltaP95 = 0.0f;
+			float deltaP99 = 0.0f;
+		};
+
+	private:
+		struct Event
+		{
+			std::atomic<uint64_t> sequence{ 0 }; // ticket + 1 once written, 0 if never written
+			std::atomic<long long> frameTicks{ 0 };
+			std::atomic<long long> stampTicks{ 0 };
+			std::atomic<uint32_t> stage{ 0 };
+		};
+
+		static constexpr uint32_t RING_SIZE = 4096; // power of 2
+
+		std::unique_ptr<Event[]> m_pRing;
+		std::atomic<uint64_t> m_nHead{ 0 };
+		std::atomic<bool> m_fEnabled{ true };
+
+	public:
+		LatencyTracer() : m_pRing(new Event[RING_SIZE]) {}
+
+		// Current time in HostTicks (100 ns, QueryPerformanceCounter based)
+		static long long now();
+
+		inline void setEnabled(bool enabled) { m_fEnabled = enabled; }
+		inline bool isEnabled() const { return m_fEnabled; }
+
+		// Wait-free, callable from any thread.
+		void stamp(long long frameTicks, LatencyStage stage) { stamp(frameTicks, stage, now()); }
+		void stamp(long long frameTicks, LatencyStage stage, long long stampTicks);
+
+		// Percentiles per stage over the events in the ring. Callable from any thread, not wait-free.
+		std::array<StageStatistics, LATENCY_STAGE_COUNT> summarize() const;
+		// Human readable summary (one line per stage)
+		std::wstring report() const;
+
+		void clear();
+	};
+};
+
+#endif
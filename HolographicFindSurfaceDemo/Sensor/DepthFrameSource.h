@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef _DEPTH_FRAME_SOURCE_H_
+#define _DEPTH_FRAME_SOURCE_H_
+
+namespace HolographicFindSurfaceDemo
+{
+	// A depth frame borrowed from a DepthFrameSource.
+	// Buffers are valid until DepthFrameSource::releaseFrame() is called.
+	struct DepthFrame
+	{
+		UINT32        width = 0;
+		UINT32        height = 0;
+		UINT64        hostTicks = 0;      // ResearchModeSensorTimestamp::HostTicks (100 ns)
+		const UINT16* pDepth = nullptr;   // width * height depth values in millimeter
+		const BYTE*   pSigma = nullptr;   // width * height sigma values (Long Throw only, otherwise nullptr)
+		UINT16        maxValidDepth = 0xFFFF; // larger depth values are invalid (DEPTH_AHAT_MAX_VALID for AHAT)
+		const DirectX::XMFLOAT4X4* pRigPose = nullptr; // RigNode to recording coordinate system (recorded streams only)
+	};
+
+	// Interface of depth frame producers consumed by SensorManager's worker thread.
+	class DepthFrameSource
+	{
+	public:
+		virtual ~DepthFrameSource() = default;
+
+	public: // Called on the sensor thread
+		// Prepares streaming, returns false if the stream can not be opened.
+		virtual bool open() = 0;
+		virtual void close() = 0;
+
+		// Waits for the next frame. Returns false if no frame is available (interrupted, failed or end of stream).
+		virtual bool acquireFrame(_Out_ DepthFrame& frame) = 0;
+		// Releases the frame returned by the last successful acquireFrame().
+		virtual void releaseFrame() = 0;
+
+		// True if acquireFrame() will never return a frame again.
+		virtual bool isEndOfStream() const { return false; }
+
+	public: // Called on any thread
+		// Wakes up blocking acquireFrame() so that the sensor thread can check its exit flag.
+		virtual void interrupt() {}
+
+	public: // Calibration
+		virtual bool mapImagePointToCameraUnitPlane(const float(&uv)[2], float(&xy)[2]) = 0;
+		// Extrinsic Matrix (RigPose to CameraNode)
+		virtual void getCameraExtrinsics(_Out_ DirectX::XMFLOAT4X4* pExtrinsic) = 0;
+	};
+};
+
+#endif
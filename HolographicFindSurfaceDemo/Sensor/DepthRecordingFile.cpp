@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "DepthRecordingFile.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace HolographicFindSurfaceDemo::DepthRecordingFormat;
+
+// DepthRecordingWriter
+DepthRecordingWriter::DepthRecordingWriter(const std::wstring& path, UINT32 width, UINT32 height, bool hasSigma, UINT16 maxValidDepth,
+	const DirectX::XMFLOAT4X4& extrinsic, const DirectX::XMFLOAT2* pUnitPlane)
+{
+	m_hFile.attach(CreateFile2(path.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr));
+	if (!m_hFile) { winrt::throw_last_error(); }
+
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+
+	m_header = {};
+	m_header.magic = MAGIC;
+	m_header.version = VERSION;
+	m_header.width = width;
+	m_header.height = height;
+	m_header.flags = hasSigma ? FILE_HAS_SIGMA : 0;
+	m_header.maxValidDepth = maxValidDepth;
+	m_header.frameCount = 0;
+	m_header.unitPlaneOffset = sizeof(FileHeader);
+	m_header.indexOffset = 0;
+	m_header.extrinsic = extrinsic;
+
+	write(&m_header, sizeof(FileHeader));
+	write(pUnitPlane, pixelCount * sizeof(DirectX::XMFLOAT2));
+
+	m_vecRecord.resize(static_cast<size_t>(recordSize(width, height, hasSigma)));
+}
+
+DepthRecordingWriter::~DepthRecordingWriter()
+{
+	try {
+		finish();
+	}
+	catch (...) {
+#ifdef _DEBUG
+		OutputDebugString(L"DepthRecordingWriter: failed to finish recording\n");
+#endif
+	}
+}
+
+void DepthRecordingWriter::writeFrame(const DepthFrame& frame, const DirectX::XMFLOAT4X4* pRigPose)
+{
+	if (!m_hFile) { return; }
+	if (frame.width != m_header.width || frame.height != m_header.height) {
+		throw std::invalid_argument("DepthRecordingWriter::writeFrame(): resolution mismatch");
+	}
+
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+
+	FrameHeader header = {};
+	header.hostTicks = frame.hostTicks;
+	if (pRigPose)
+	{
+		header.flags = FRAME_HAS_RIG_POSE;
+		header.rigPose = *pRigPose;
+	}
+
+	BYTE* pRecord = m_vecRecord.data();
+	memcpy(pRecord, &header, sizeof(FrameHeader));
+	memcpy(pRecord + sizeof(FrameHeader), frame.pDepth, pixelCount * sizeof(UINT16));
+	if (m_header.flags & FILE_HAS_SIGMA)
+	{
+		BYTE* pSigma = pRecord + sizeof(FrameHeader) + pixelCount * sizeof(UINT16);
+		if (frame.pSigma) { memcpy(pSigma, frame.pSigma, pixelCount); }
+		else { memset(pSigma, 0, pixelCount); }
+	}
+
+	m_vecIndex.push_back(m_nOffset);
+	write(pRecord, m_vecRecord.size());
+}
+
+void DepthRecordingWriter::finish()
+{
+	if (!m_hFile) { return; }
+
+	m_header.frameCount = m_vecIndex.size();
+	m_header.indexOffset = m_nOffset;
+	write(m_vecIndex.data(), m_vecIndex.size() * sizeof(UINT64));
+
+	// Patch header
+	LARGE_INTEGER origin = {};
+	winrt::check_bool(SetFilePointerEx(m_hFile.get(), origin, nullptr, FILE_BEGIN));
+	DWORD written = 0;
+	winrt::check_bool(WriteFile(m_hFile.get(), &m_header, sizeof(FileHeader), &written, nullptr));
+
+	m_hFile.close();
+}
+
+void DepthRecordingWriter::write(const void* pData, size_t size)
+{
+	const BYTE* pBytes = static_cast<const BYTE*>(pData);
+	while (size > 0)
+	{
+		DWORD chunk = static_cast<DWORD>((std::min)(size, static_cast<size_t>(0x40000000)));
+		DWORD written = 0;
+		winrt::check_bool(WriteFile(m_hFile.get(), pBytes, chunk, &written, nullptr));
+
+		pBytes += written;
+		size -= written;
+		m_nOffset += written;
+	}
+}
+
+// MappedDepthRecording
+MappedDepthRecording::MappedDepthRecording(const std::wstring& path)
+{
+	m_hFile.attach(CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr));
+	if (!m_hFile) { winrt::throw_last_error(); }
+
+	LARGE_INTEGER fileSize = {};
+	winrt::check_bool(GetFileSizeEx(m_hFile.get(), &fileSize));
+	m_nFileSize = static_cast<UINT64>(fileSize.QuadPart);
+	if (m_nFileSize < sizeof(FileHeader)) {
+		throw std::runtime_error("MappedDepthRecording: file too small");
+	}
+
+	m_hMapping.attach(CreateFileMappingFromApp(m_hFile.get(), nullptr, PAGE_READONLY, 0, nullptr));
+	if (!m_hMapping) { winrt::throw_last_error(); }
+
+	m_pView = static_cast<const BYTE*>(MapViewOfFileFromApp(m_hMapping.get(), FILE_MAP_READ, 0, 0));
+	if (!m_pView) { winrt::throw_last_error(); }
+
+	m_pHeader = reinterpret_cast<const FileHeader*>(m_pView);
+	if (m_pHeader->magic != MAGIC || m_pHeader->version != VERSION) {
+		UnmapViewOfFile(m_pView);
+		throw std::runtime_error("MappedDepthRecording: unsupported file");
+	}
+
+	const UINT64 pixelCount = static_cast<UINT64>(m_pHeader->width) * m_pHeader->height;
+	const UINT64 frameCount = m_pHeader->frameCount;
+
+	// Offsets and sizes come from the file: compared against the room left after each offset, so that nothing wraps around
+	bool valid = m_pHeader->unitPlaneOffset % 8 == 0
+		&& m_pHeader->unitPlaneOffset <= m_nFileSize
+		&& pixelCount <= (m_nFileSize - m_pHeader->unitPlaneOffset) / sizeof(DirectX::XMFLOAT2)
+		&& (frameCount == 0 || (m_pHeader->indexOffset % 8 == 0
+			&& m_pHeader->indexOffset <= m_nFileSize
+			&& frameCount <= (m_nFileSize - m_pHeader->indexOffset) / sizeof(UINT64)));
+	if (!valid) {
+		UnmapViewOfFile(m_pView);
+		throw std::runtime_error("MappedDepthRecording: corrupted file");
+	}
+	// Cannot overflow once the unit plane fits in the file
+	m_nRecordSize = recordSize(m_pHeader->width, m_pHeader->height, (m_pHeader->flags & FILE_HAS_SIGMA) != 0);
+
+	m_pIndex = reinterpret_cast<const UINT64*>(m_pView + m_pHeader->indexOffset);
+}
+
+MappedDepthRecording::~MappedDepthRecording()
+{
+	if (m_pView) { UnmapViewOfFile(m_pView); }
+}
+
+bool MappedDepthRecording::getFrame(size_t index, DepthFrame& frame) const
+{
+	if (index >= frameCount()) { return false; }
+
+	const UINT64 offset = m_pIndex[index];
+	if (offset % 8 != 0 || offset > m_nFileSize || m_nFileSize - offset < m_nRecordSize) { return false; }
+
+	const BYTE* pRecord = m_pView + offset;
+	const FrameHeader* pHeader = reinterpret_cast<const FrameHeader*>(pRecord);
+	const size_t pixelCount = static_cast<size_t>(m_pHeader->width) * m_pHeader->height;
+
+	frame.width = m_pHeader->width;
+	frame.height = m_pHeader->height;
+	frame.hostTicks = pHeader->hostTicks;
+	frame.pDepth = reinterpret_cast<const UINT16*>(pRecord + sizeof(FrameHeader));
+	frame.pSigma = (m_pHeader->flags & FILE_HAS_SIGMA) ? pRecord + sizeof(FrameHeader) + pixelCount * sizeof(UINT16) : nullptr;
+	frame.pRigPose = (pHeader->flags & FRAME_HAS_RIG_POSE) ? &pHeader->rigPose : nullptr;
+	frame.maxValidDepth = m_pHeader->maxValidDepth > 0 ? static_cast<UINT16>((std::min)(m_pHeader->maxValidDepth, 0xFFFFu)) : 0xFFFF;
+
+	return true;
+}
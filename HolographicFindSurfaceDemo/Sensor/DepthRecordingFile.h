@@ -0,0 +1,130 @@
+#pragma once
+
+#ifndef _DEPTH_RECORDING_FILE_H_
+#define _DEPTH_RECORDING_FILE_H_
+
+#include "DepthReplaySource.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Binary depth recording (little endian, 8 byte aligned sections)
+	//
+	//   FileHeader
+	//   Unit XY Plane       XMFLOAT2 * (width * height)
+	//   Frame Records       FrameHeader, UINT16 depth * (width * height), [ BYTE sigma * (width * height) ], padding
+	//   Frame Index Table   UINT64 record offset * frameCount
+	//
+	// The header is rewritten with frameCount and indexOffset when the recording is finished,
+	// an unfinished file reads as an empty recording.
+	namespace DepthRecordingFormat
+	{
+		constexpr UINT32 MAGIC = 0x52445346; // "FSDR"
+		constexpr UINT32 VERSION = 1;
+
+		enum FileFlags : UINT32
+		{
+			FILE_HAS_SIGMA = 0x1
+		};
+
+		enum FrameFlags : UINT32
+		{
+			FRAME_HAS_RIG_POSE = 0x1
+		};
+
+		struct FileHeader
+		{
+			UINT32 magic;
+			UINT32 version;
+			UINT32 width;
+			UINT32 height;
+			UINT32 flags;            // FileFlags
+			UINT32 maxValidDepth;    // DepthFrame::maxValidDepth, 0 if there is none
+			UINT64 frameCount;
+			UINT64 unitPlaneOffset;
+			UINT64 indexOffset;
+			DirectX::XMFLOAT4X4 extrinsic; // RigPose to CameraNode
+		};
+		static_assert(sizeof(FileHeader) == 112, "DepthRecordingFormat::FileHeader layout");
+
+		struct FrameHeader
+		{
+			UINT64 hostTicks;
+			UINT32 flags;            // FrameFlags
+			UINT32 reserved;
+			DirectX::XMFLOAT4X4 rigPose;   // RigNode to recording coordinate system (if FRAME_HAS_RIG_POSE)
+		};
+		static_assert(sizeof(FrameHeader) == 80, "DepthRecordingFormat::FrameHeader layout");
+
+		inline UINT64 recordSize(UINT32 width, UINT32 height, bool hasSigma)
+		{
+			const UINT64 pixelCount = static_cast<UINT64>(width) * height;
+			UINT64 size = sizeof(FrameHeader) + pixelCount * sizeof(UINT16) + (hasSigma ? pixelCount : 0);
+			return (size + 7) & ~static_cast<UINT64>(7);
+		}
+	};
+
+	// Writes depth frames to a recording file. Not thread safe.
+	class DepthRecordingWriter
+	{
+	private:
+		winrt::file_handle m_hFile;
+		DepthRecordingFormat::FileHeader m_header;
+		std::vector<UINT64> m_vecIndex;
+		UINT64 m_nOffset = 0;
+		std::vector<BYTE> m_vecRecord; // staging buffer of a frame record
+
+	public:
+		// Creates (or overwrites) `path`. `pUnitPlane` holds width * height entries.
+		// Throws winrt::hresult_error if the file can not be created.
+		DepthRecordingWriter(const std::wstring& path, UINT32 width, UINT32 height, bool hasSigma, UINT16 maxValidDepth,
+			const DirectX::XMFLOAT4X4& extrinsic, const DirectX::XMFLOAT2* pUnitPlane);
+		~DepthRecordingWriter();
+
+		DepthRecordingWriter(const DepthRecordingWriter&) = delete;
+		DepthRecordingWriter& operator=(const DepthRecordingWriter&) = delete;
+
+		// Appends a frame. `pRigPose` may be nullptr if the rig could not be located.
+		// Throws std::invalid_argument if the frame resolution differs from the recording.
+		void writeFrame(const DepthFrame& frame, const DirectX::XMFLOAT4X4* pRigPose);
+		// Writes the frame index table and the final header, then closes the file.
+		void finish();
+
+		inline size_t frameCount() const { return m_vecIndex.size(); }
+
+	private:
+		void write(const void* pData, size_t size);
+	};
+
+	// Read-only memory mapped recording file. Frames are read in place, any frame can be accessed in O(1).
+	class MappedDepthRecording : public DepthRecording
+	{
+	private:
+		winrt::file_handle m_hFile;
+		winrt::handle m_hMapping;
+		const BYTE* m_pView = nullptr;
+		UINT64 m_nFileSize = 0;
+
+		const DepthRecordingFormat::FileHeader* m_pHeader = nullptr;
+		const UINT64* m_pIndex = nullptr;
+		UINT64 m_nRecordSize = 0;
+
+	public:
+		// Throws winrt::hresult_error if the file can not be mapped, std::runtime_error if it is not a valid recording.
+		explicit MappedDepthRecording(const std::wstring& path);
+		~MappedDepthRecording();
+
+		MappedDepthRecording(const MappedDepthRecording&) = delete;
+		MappedDepthRecording& operator=(const MappedDepthRecording&) = delete;
+
+	public: // DepthRecording
+		UINT32 width() const override { return m_pHeader->width; }
+		UINT32 height() const override { return m_pHeader->height; }
+		size_t frameCount() const override { return static_cast<size_t>(m_pHeader->frameCount); }
+		bool getFrame(size_t index, _Out_ DepthFrame& frame) const override;
+
+		const DirectX::XMFLOAT2* unitPlane() const override { return reinterpret_cast<const DirectX::XMFLOAT2*>(m_pView + m_pHeader->unitPlaneOffset); }
+		const DirectX::XMFLOAT4X4& extrinsics() const override { return m_pHeader->extrinsic; }
+	};
+};
+
+#endif
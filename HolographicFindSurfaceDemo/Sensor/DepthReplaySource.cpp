@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "DepthReplaySource.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+typedef std::chrono::duration<int64_t, std::ratio<1, 10'000'000>> _HostTicks; // 100 ns
+
+// InMemoryDepthRecording
+void InMemoryDepthRecording::addFrame(UINT64 hostTicks, std::vector<UINT16> depth, std::vector<BYTE> sigma)
+{
+	const size_t pixelCount = static_cast<size_t>(m_nWidth) * m_nHeight;
+	if (depth.size() != pixelCount || (!sigma.empty() && sigma.size() != pixelCount)) {
+		throw std::invalid_argument("InMemoryDepthRecording::addFrame(): buffer size mismatch");
+	}
+	m_vecFrames.push_back(Frame{ hostTicks, std::move(depth), std::move(sigma) });
+}
+
+bool InMemoryDepthRecording::getFrame(size_t index, DepthFrame& frame) const
+{
+	if (index >= m_vecFrames.size()) { return false; }
+
+	const Frame& src = m_vecFrames[index];
+	frame.width = m_nWidth;
+	frame.height = m_nHeight;
+	frame.hostTicks = src.hostTicks;
+	frame.pDepth = src.depth.data();
+	frame.pSigma = src.sigma.empty() ? nullptr : src.sigma.data();
+	frame.maxValidDepth = m_nMaxValidDepth;
+
+	return true;
+}
+
+// DepthReplaySource
+bool DepthReplaySource::open()
+{
+	if (!m_pRecording || m_pRecording->frameCount() < 1) { return false; }
+
+	std::lock_guard lock(m_hWaitMutex);
+	m_nNextFrame = 0;
+	m_fEndOfStream = false;
+	m_fInterrupted = false;
+	m_fClockStarted = false;
+
+	return true;
+}
+
+void DepthReplaySource::close()
+{
+	std::lock_guard lock(m_hWaitMutex);
+	m_nStepCount = 0;
+}
+
+void DepthReplaySource::step(size_t count)
+{
+	{
+		std::lock_guard lock(m_hWaitMutex);
+		m_nStepCount += count;
+	}
+	m_cvWait.notify_all();
+}
+
+void DepthReplaySource::interrupt()
+{
+	{
+		std::lock_guard lock(m_hWaitMutex);
+		m_fInterrupted = true;
+	}
+	m_cvWait.notify_all();
+}
+
+bool DepthReplaySource::acquireFrame(DepthFrame& frame)
+{
+	if (m_nNextFrame >= m_pRecording->frameCount())
+	{
+		if (!m_fLoop) {
+			m_fEndOfStream = true;
+			return false;
+		}
+		m_nNextFrame = 0;
+		m_fClockStarted = false; // restart the clock
+	}
+
+	if (!m_pRecording->getFrame(m_nNextFrame, frame)) {
+		m_fEndOfStream = true;
+		return false;
+	}
+
+	std::unique_lock lock(m_hWaitMutex);
+	switch (m_pacing)
+	{
+	case PACING_REAL_TIME:
+		if (!m_fClockStarted)
+		{
+			m_fClockStarted = true;
+			m_tpStart = std::chrono::steady_clock::now();
+			m_nStartTicks = frame.hostTicks;
+		}
+		else if (frame.hostTicks > m_nStartTicks)
+		{
+			auto due = m_tpStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_HostTicks(frame.hostTicks - m_nStartTicks));
+			m_cvWait.wait_until(lock, due, [this] { return m_fInterrupted; });
+		}
+		break;
+
+	case PACING_STEPPED:
+		m_cvWait.wait(lock, [this] { return m_fInterrupted || m_nStepCount > 0; });
+		if (!m_fInterrupted) { m_nStepCount--; }
+		break;
+
+	case PACING_AS_FAST_AS_POSSIBLE:
+		break;
+	}
+
+	if (m_fInterrupted)
+	{
+		m_fInterrupted = false;
+		return false; // deliver the same frame next time
+	}
+
+	m_nNextFrame++;
+	return true;
+}
+
+bool DepthReplaySource::mapImagePointToCameraUnitPlane(const float(&uv)[2], float(&xy)[2])
+{
+	if (uv[0] < 0.0f || uv[1] < 0.0f) { return false; }
+
+	UINT32 u = static_cast<UINT32>(uv[0]);
+	UINT32 v = static_cast<UINT32>(uv[1]);
+	if (u >= m_pRecording->width() || v >= m_pRecording->height()) { return false; }
+
+	const DirectX::XMFLOAT2& unit = m_pRecording->unitPlane()[static_cast<size_t>(v) * m_pRecording->width() + u];
+	xy[0] = unit.x;
+	xy[1] = unit.y;
+
+	return true;
+}
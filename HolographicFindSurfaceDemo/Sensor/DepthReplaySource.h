@@ -0,0 +1,121 @@
+#pragma once
+
+#ifndef _DEPTH_REPLAY_SOURCE_H_
+#define _DEPTH_REPLAY_SOURCE_H_
+
+#include "DepthFrameSource.h"
+
+#include <chrono>
+#include <condition_variable>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Random access to a recorded depth stream.
+	class DepthRecording
+	{
+	public:
+		virtual ~DepthRecording() = default;
+
+		virtual UINT32 width() const = 0;
+		virtual UINT32 height() const = 0;
+		virtual size_t frameCount() const = 0;
+		// Fills `frame` with buffers owned by the recording.
+		virtual bool getFrame(size_t index, _Out_ DepthFrame& frame) const = 0;
+
+		// Camera unit plane (x, y) of each pixel, width * height entries.
+		virtual const DirectX::XMFLOAT2* unitPlane() const = 0;
+		virtual const DirectX::XMFLOAT4X4& extrinsics() const = 0;
+	};
+
+	// Recording held in memory (synthetic data, captured frames, ...)
+	class InMemoryDepthRecording : public DepthRecording
+	{
+	private:
+		struct Frame
+		{
+			UINT64 hostTicks;
+			std::vector<UINT16> depth;
+			std::vector<BYTE> sigma;
+		};
+
+		UINT32 m_nWidth;
+		UINT32 m_nHeight;
+		std::vector<DirectX::XMFLOAT2> m_vecUnitPlane;
+		DirectX::XMFLOAT4X4 m_matExtrinsic;
+		std::vector<Frame> m_vecFrames;
+		UINT16 m_nMaxValidDepth = 0xFFFF;
+
+	public:
+		InMemoryDepthRecording(UINT32 width, UINT32 height, std::vector<DirectX::XMFLOAT2> unitPlane, const DirectX::XMFLOAT4X4& extrinsic)
+			: m_nWidth(width), m_nHeight(height), m_vecUnitPlane(std::move(unitPlane)), m_matExtrinsic(extrinsic) {}
+
+		// `sigma` may be empty.
+		void addFrame(UINT64 hostTicks, std::vector<UINT16> depth, std::vector<BYTE> sigma = {});
+		// Depth encoding of the recorded sensor (e.g. DEPTH_AHAT_MAX_VALID)
+		void setMaxValidDepth(UINT16 maxValidDepth) { m_nMaxValidDepth = maxValidDepth; }
+
+	public: // DepthRecording
+		UINT32 width() const override { return m_nWidth; }
+		UINT32 height() const override { return m_nHeight; }
+		size_t frameCount() const override { return m_vecFrames.size(); }
+		bool getFrame(size_t index, _Out_ DepthFrame& frame) const override;
+
+		const DirectX::XMFLOAT2* unitPlane() const override { return m_vecUnitPlane.data(); }
+		const DirectX::XMFLOAT4X4& extrinsics() const override { return m_matExtrinsic; }
+	};
+
+	// Deterministic replay of a DepthRecording. Frames are delivered in recorded order, none is dropped by the source.
+	// SensorManager processes every one of them under BACK_PRESSURE_NONE (its consumer still sees the newest only),
+	// BACK_PRESSURE_SKIP and BACK_PRESSURE_DEFER drop frames depending on consumer timing.
+	class DepthReplaySource : public DepthFrameSource
+	{
+	public:
+		enum Pacing
+		{
+			PACING_REAL_TIME,            // Keep the recorded frame interval
+			PACING_AS_FAST_AS_POSSIBLE,  // Deliver next frame as soon as it is requested
+			PACING_STEPPED               // Deliver one frame per step() call
+		};
+
+	private:
+		std::shared_ptr<const DepthRecording> m_pRecording;
+		Pacing m_pacing;
+		bool m_fLoop = false;
+
+		size_t m_nNextFrame = 0;
+		bool m_fEndOfStream = false;
+
+		// Real-time pacing
+		std::chrono::steady_clock::time_point m_tpStart;
+		UINT64 m_nStartTicks = 0;
+		bool m_fClockStarted = false;
+
+		// Stepped pacing & interruption
+		std::mutex m_hWaitMutex;
+		std::condition_variable m_cvWait;
+		size_t m_nStepCount = 0;
+		bool m_fInterrupted = false;
+
+	public:
+		DepthReplaySource(std::shared_ptr<const DepthRecording> pRecording, Pacing pacing = PACING_REAL_TIME)
+			: m_pRecording(std::move(pRecording)), m_pacing(pacing) {}
+
+		// Restart from the first frame after the last one.
+		void setLoop(bool loop) { m_fLoop = loop; }
+		// Allows the next frame in PACING_STEPPED mode.
+		void step(size_t count = 1);
+
+	public: // DepthFrameSource
+		bool open() override;
+		void close() override;
+		bool acquireFrame(_Out_ DepthFrame& frame) override;
+		void releaseFrame() override {}
+		bool isEndOfStream() const override { return m_fEndOfStream; }
+		void interrupt() override;
+
+		bool mapImagePointToCameraUnitPlane(const float(&uv)[2], float(&xy)[2]) override;
+		void getCameraExtrinsics(_Out_ DirectX::XMFLOAT4X4* pExtrinsic) override { *pExtrinsic = m_pRecording->extrinsics(); }
+	};
+};
+
+#endif
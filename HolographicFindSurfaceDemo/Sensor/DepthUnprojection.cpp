@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "DepthUnprojection.h"
+#include "DepthFrameSource.h"
+#include "WorkStealingPool.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Note: Every lane follows exactly the same operation order as the scalar reference,
+//       z = (depth * (1 / depthAdjust)) * mm2m, x = unitX * z, y = unitY * z
+//       so that both paths produce bit-exact results (no FMA, no reciprocal estimate).
+
+static inline size_t _unprojectScalar(XMFLOAT3* pOut, const UINT16* pDepth, const BYTE* pSigma, const XMFLOAT4* pUnitXYPlane, size_t begin, size_t end, UINT16 maxValidDepth)
+{
+	size_t n = 0;
+	for (size_t index = begin; index < end; index++)
+	{
+		UINT16 depthValue = (pSigma && ((pSigma[index] & DEPTH_SIGMA_INVALID_MASK) > 0)) ? 0 : pDepth[index];
+		if (depthValue > 0 && depthValue <= maxValidDepth) {
+			float z = static_cast<float>(depthValue) * pUnitXYPlane[index].w * DEPTH_MM_TO_METER;
+			// or static_cast<float>(depthValue) / pUnitXYPlane[index].z;
+
+			// Do not need Flip YZ in here
+			pOut[n++] = XMFLOAT3(pUnitXYPlane[index].x * z, pUnitXYPlane[index].y * z, z);
+		}
+	}
+	return n;
+}
+
+size_t HolographicFindSurfaceDemo::BuildPixelIndexMap(BYTE* pValidMask, UINT32* pPixelToIndex, const UINT16* pDepth, const BYTE* pSigma, size_t count, UINT16 maxValidDepth)
+{
+	UINT32 n = 0;
+	for (size_t block = 0; block < count; block += 8)
+	{
+		const size_t end = (std::min)(count, block + 8);
+
+		BYTE bits = 0;
+		for (size_t index = block; index < end; index++)
+		{
+			// Same predicate as _unprojectScalar()
+			UINT32 valid = (pDepth[index] > 0 && pDepth[index] <= maxValidDepth && !(pSigma && ((pSigma[index] & DEPTH_SIGMA_INVALID_MASK) > 0))) ? 1 : 0;
+
+			bits |= static_cast<BYTE>(valid << (index - block));
+			pPixelToIndex[index] = valid ? n : INVALID_POINT_INDEX;
+			n += valid;
+		}
+		pValidMask[block >> 3] = bits;
+	}
+	return n;
+}
+
+size_t HolographicFindSurfaceDemo::UnprojectDepthReference(XMFLOAT3* pOutPoints, const UINT16* pDepth, const BYTE* pSigma, const XMFLOAT4* pUnitXYPlane, size_t count, UINT16 maxValidDepth)
+{
+	return _unprojectScalar(pOutPoints, pDepth, pSigma, pUnitXYPlane, 0, count, maxValidDepth);
+}
+
+#if defined(_XM_SSE_INTRINSICS_)
+
+size_t HolographicFindSurfaceDemo::UnprojectDepth(XMFLOAT3* pOutPoints, const UINT16* pDepth, const BYTE* pSigma, const XMFLOAT4* pUnitXYPlane, size_t count, UINT16 maxValidDepth)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i sigmaMask = _mm_set1_epi32(DEPTH_SIGMA_INVALID_MASK);
+	const __m128 mm2m = _mm_set1_ps(DEPTH_MM_TO_METER);
+	const __m128i maxValid = _mm_set1_epi32(maxValidDepth);
+
+	size_t n = 0;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		// 4 x UINT16 -> 4 x INT32
+		__m128i depth = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pDepth + i));
+		depth = _mm_unpacklo_epi16(depth, zero);
+
+		if (pSigma)
+		{
+			int sigma4;
+			memcpy(&sigma4, pSigma + i, sizeof(sigma4));
+			__m128i sigma = _mm_cvtsi32_si128(sigma4);
+			sigma = _mm_unpacklo_epi16(_mm_unpacklo_epi8(sigma, zero), zero);
+
+			__m128i invalid = _mm_cmpeq_epi32(_mm_and_si128(sigma, sigmaMask), sigmaMask);
+			depth = _mm_andnot_si128(invalid, depth);
+		}
+		depth = _mm_andnot_si128(_mm_cmpgt_epi32(depth, maxValid), depth);
+
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(depth, zero)));
+		if (mask == 0) { continue; }
+
+		// AoS (x, y, adjust, 1/adjust) x 4 -> SoA
+		__m128 unitX = _mm_loadu_ps(&pUnitXYPlane[i + 0].x);
+		__m128 unitY = _mm_loadu_ps(&pUnitXYPlane[i + 1].x);
+		__m128 adjust = _mm_loadu_ps(&pUnitXYPlane[i + 2].x);
+		__m128 invAdjust = _mm_loadu_ps(&pUnitXYPlane[i + 3].x);
+		_MM_TRANSPOSE4_PS(unitX, unitY, adjust, invAdjust);
+
+		__m128 z = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(depth), invAdjust), mm2m);
+		__m128 x = _mm_mul_ps(unitX, z);
+		__m128 y = _mm_mul_ps(unitY, z);
+
+		if (mask == 0xF)
+		{
+			// SoA -> 4 x XMFLOAT3 (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3)
+			__m128 xyLo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+			__m128 xyHi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+			__m128 yzLo = _mm_unpacklo_ps(y, z); // y0 z0 y1 z1
+			__m128 yzHi = _mm_unpackhi_ps(y, z); // y2 z2 y3 z3
+			__m128 zxLo = _mm_unpacklo_ps(z, x); // z0 x0 z1 x1
+			__m128 zxHi = _mm_unpackhi_ps(z, x); // z2 x2 z3 x3
+
+			float* pDst = &pOutPoints[n].x;
+			_mm_storeu_ps(pDst + 0, _mm_shuffle_ps(xyLo, zxLo, _MM_SHUFFLE(3, 0, 1, 0)));
+			_mm_storeu_ps(pDst + 4, _mm_shuffle_ps(yzLo, xyHi, _MM_SHUFFLE(1, 0, 3, 2)));
+			_mm_storeu_ps(pDst + 8, _mm_shuffle_ps(zxHi, yzHi, _MM_SHUFFLE(3, 2, 3, 0)));
+			n += 4;
+		}
+		else
+		{
+			// Stream compaction of partially valid block
+			alignas(16) float xs[4], ys[4], zs[4];
+			_mm_store_ps(xs, x);
+			_mm_store_ps(ys, y);
+			_mm_store_ps(zs, z);
+			for (int k = 0; k < 4; k++)
+			{
+				if (mask & (1 << k)) {
+					pOutPoints[n++] = XMFLOAT3(xs[k], ys[k], zs[k]);
+				}
+			}
+		}
+	}
+
+	return n + _unprojectScalar(pOutPoints + n, pDepth, pSigma, pUnitXYPlane, i, count, maxValidDepth);
+}
+
+#elif defined(_XM_ARM_NEON_INTRINSICS_)
+
+size_t HolographicFindSurfaceDemo::UnprojectDepth(XMFLOAT3* pOutPoints, const UINT16* pDepth, const BYTE* pSigma, const XMFLOAT4* pUnitXYPlane, size_t count, UINT16 maxValidDepth)
+{
+	static const uint32_t LANE_BITS[4] = { 1, 2, 4, 8 };
+
+	const uint32x4_t zero = vdupq_n_u32(0);
+	const uint32x4_t sigmaMask = vdupq_n_u32(DEPTH_SIGMA_INVALID_MASK);
+	const uint32x4_t laneBits = vld1q_u32(LANE_BITS);
+	const float32x4_t mm2m = vdupq_n_f32(DEPTH_MM_TO_METER);
+	const uint32x4_t maxValid = vdupq_n_u32(maxValidDepth);
+
+	size_t n = 0;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		// 4 x UINT16 -> 4 x UINT32
+		uint32x4_t depth = vmovl_u16(vld1_u16(pDepth + i));
+
+		if (pSigma)
+		{
+			uint32_t sigma4;
+			memcpy(&sigma4, pSigma + i, sizeof(sigma4));
+			uint16x8_t sigma16 = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(sigma4)));
+			uint32x4_t sigma = vmovl_u16(vget_low_u16(sigma16));
+
+			depth = vbicq_u32(depth, vtstq_u32(sigma, sigmaMask));
+		}
+		depth = vbicq_u32(depth, vcgtq_u32(depth, maxValid));
+
+		// movemask emulation (works on both ARM and ARM64)
+		uint32x4_t valid = vandq_u32(vcgtq_u32(depth, zero), laneBits);
+		uint32x2_t sum = vpadd_u32(vget_low_u32(valid), vget_high_u32(valid));
+		sum = vpadd_u32(sum, sum);
+		uint32_t mask = vget_lane_u32(sum, 0);
+		if (mask == 0) { continue; }
+
+		// AoS (x, y, adjust, 1/adjust) x 4 -> SoA
+		float32x4x4_t unit = vld4q_f32(&pUnitXYPlane[i].x);
+
+		float32x4x3_t point;
+		point.val[2] = vmulq_f32(vmulq_f32(vcvtq_f32_u32(depth), unit.val[3]), mm2m);
+		point.val[0] = vmulq_f32(unit.val[0], point.val[2]);
+		point.val[1] = vmulq_f32(unit.val[1], point.val[2]);
+
+		if (mask == 0xF)
+		{
+			vst3q_f32(&pOutPoints[n].x, point);
+			n += 4;
+		}
+		else
+		{
+			// Stream compaction of partially valid block
+			float xs[4], ys[4], zs[4];
+			vst1q_f32(xs, point.val[0]);
+			vst1q_f32(ys, point.val[1]);
+			vst1q_f32(zs, point.val[2]);
+			for (int k = 0; k < 4; k++)
+			{
+				if (mask & (1 << k)) {
+					pOutPoints[n++] = XMFLOAT3(xs[k], ys[k], zs[k]);
+				}
+			}
+		}
+	}
+
+	return n + _unprojectScalar(pOutPoints + n, pDepth, pSigma, pUnitXYPlane, i, count, maxValidDepth);
+}
+
+#else // _XM_NO_INTRINSICS_
+
+size_t HolographicFindSurfaceDemo::UnprojectDepth(XMFLOAT3* pOutPoints, const UINT16* pDepth, const BYTE* pSigma, const XMFLOAT4* pUnitXYPlane, size_t count, UINT16 maxValidDepth)
+{
+	return _unprojectScalar(pOutPoints, pDepth, pSigma, pUnitXYPlane, 0, count, maxValidDepth);
+}
+
+#endif
+
+size_t HolographicFindSurfaceDemo::UnprojectDepthParallel(WorkStealingPool& pool, XMFLOAT3* pOutPoints, const DepthFrame& frame, const XMFLOAT4* pUnitXYPlane, uint32_t bandCount, std::vector<size_t>& bandPointCounts)
+{
+	bandCount = (std::min)(frame.height, bandCount);
+	if (bandCount < 1) { return 0; }
+
+	const size_t bandRows = (frame.height + bandCount - 1) / bandCount;
+	const size_t bandPixels = bandRows * frame.width;
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+
+	bandPointCounts.assign(bandCount, 0);
+
+	pool.parallelFor(bandCount, [&](uint32_t band) {
+		const size_t begin = (std::min)(pixelCount, band * bandPixels);
+		const size_t end = (std::min)(pixelCount, begin + bandPixels);
+
+		bandPointCounts[band] = UnprojectDepth(
+			pOutPoints + begin,
+			frame.pDepth + begin,
+			frame.pSigma ? frame.pSigma + begin : nullptr,
+			pUnitXYPlane + begin,
+			end - begin,
+			frame.maxValidDepth
+		);
+	});
+
+	// Join the bands in row order, so that point order matches the single threaded path
+	size_t pointCount = bandPointCounts[0];
+	for (uint32_t band = 1; band < bandCount; band++)
+	{
+		const size_t count = bandPointCounts[band];
+		if (count > 0) {
+			memmove(pOutPoints + pointCount, pOutPoints + band * bandPixels, count * sizeof(XMFLOAT3));
+		}
+		pointCount += count;
+	}
+
+	return pointCount;
+}
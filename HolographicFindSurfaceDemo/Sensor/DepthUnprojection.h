@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef _DEPTH_UNPROJECTION_H_
+#define _DEPTH_UNPROJECTION_H_
+
+namespace HolographicFindSurfaceDemo
+{
+	struct DepthFrame;
+	class WorkStealingPool;
+
+	// invalidation mask of sigma buffer for Long Throw
+	constexpr BYTE  DEPTH_SIGMA_INVALID_MASK = 0x80;
+	constexpr float DEPTH_MM_TO_METER = 0.001f;
+
+	// largest valid depth value (millimeter) per sensor
+	constexpr UINT16 DEPTH_MAX_VALID_ANY = 0xFFFF;
+	constexpr UINT16 DEPTH_AHAT_MAX_VALID = 4089; // AHAT reports invalid pixels as values >= 4090
+
+	// pixel -> point index of invalid pixels
+	constexpr UINT32 INVALID_POINT_INDEX = 0xFFFFFFFF;
+
+	// Unprojects `count` depth pixels to camera space points and packs the valid ones densely into `pOutPoints`.
+	// - pUnitXYPlane[i] = ( x, y, sqrt(1 + x*x + y*y), 1 / sqrt(1 + x*x + y*y) ) on camera unit plane of pixel i.
+	// - pSigma is optional (Long Throw only), a pixel is dropped if its sigma has DEPTH_SIGMA_INVALID_MASK.
+	// - a pixel is dropped if its depth is 0 or greater than maxValidDepth.
+	// - pOutPoints must have room for `count` points.
+	// Returns the number of points written.
+	size_t UnprojectDepth(
+		_Out_writes_to_(count, return) DirectX::XMFLOAT3* pOutPoints,
+		_In_reads_(count) const UINT16* pDepth,
+		_In_reads_opt_(count) const BYTE* pSigma,
+		_In_reads_(count) const DirectX::XMFLOAT4* pUnitXYPlane,
+		size_t count,
+		UINT16 maxValidDepth = DEPTH_MAX_VALID_ANY
+	);
+
+	// Builds the pixel grid structure of the points UnprojectDepth() produces from the same pixels.
+	// - pValidMask: bit (i & 7) of byte (i >> 3) is set if pixel i has a point, (count + 7) / 8 bytes.
+	// - pPixelToIndex: index of the point of pixel i in the packed output, or INVALID_POINT_INDEX.
+	// Returns the number of valid pixels (== UnprojectDepth() result).
+	size_t BuildPixelIndexMap(
+		_Out_writes_((count + 7) / 8) BYTE* pValidMask,
+		_Out_writes_(count) UINT32* pPixelToIndex,
+		_In_reads_(count) const UINT16* pDepth,
+		_In_reads_opt_(count) const BYTE* pSigma,
+		size_t count,
+		UINT16 maxValidDepth = DEPTH_MAX_VALID_ANY
+	);
+
+	// UnprojectDepth() of a whole frame on `pool`, split into `bandCount` row bands that are compacted into their own
+	// region of `pOutPoints` and then joined in row order, so the output matches the single threaded call.
+	// `bandPointCounts` is scratch (one entry per band), pOutPoints must have room for every pixel.
+	size_t UnprojectDepthParallel(
+		WorkStealingPool& pool,
+		DirectX::XMFLOAT3* pOutPoints,
+		const DepthFrame& frame,
+		const DirectX::XMFLOAT4* pUnitXYPlane,
+		uint32_t bandCount,
+		std::vector<size_t>& bandPointCounts
+	);
+
+	// Scalar reference of UnprojectDepth(). The vectorized kernel must produce bit-exact identical output.
+	size_t UnprojectDepthReference(
+		_Out_writes_to_(count, return) DirectX::XMFLOAT3* pOutPoints,
+		_In_reads_(count) const UINT16* pDepth,
+		_In_reads_opt_(count) const BYTE* pSigma,
+		_In_reads_(count) const DirectX::XMFLOAT4* pUnitXYPlane,
+		size_t count,
+		UINT16 maxValidDepth = DEPTH_MAX_VALID_ANY
+	);
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "pch.h"
+#include "FlyingPixelFilter.h"
+#include "DepthUnprojection.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+namespace
+{
+	inline UINT16 cleanScalar(UINT16 depth, const BYTE* pSigma, size_t index, UINT16 maxValidDepth)
+	{
+		bool invalid = (pSigma && (pSigma[index] & DEPTH_SIGMA_INVALID_MASK)) || depth > maxValidDepth;
+		return invalid ? 0 : depth;
+	}
+
+	inline bool isJump(UINT16 center, UINT16 neighbour, UINT16 threshold)
+	{
+		if (neighbour == 0) { return false; }
+		UINT16 diff = center > neighbour ? center - neighbour : neighbour - center;
+		return diff > threshold;
+	}
+
+	inline UINT16 jumpThreshold(UINT16 depth, UINT16 minJump, UINT16 relativeJumpQ16)
+	{
+		UINT32 threshold = static_cast<UINT32>(minJump) + ((static_cast<UINT32>(depth) * relativeJumpQ16) >> 16);
+		return static_cast<UINT16>(threshold > 0xFFFF ? 0xFFFF : threshold);
+	}
+
+	// Filters pixels [begin, end) of a row. `pUp` / `pDown` are the neighbour rows (the row itself at image borders).
+	inline void filterScalar(UINT16* pOut, const UINT16* pRow, const UINT16* pUp, const UINT16* pDown, UINT32 width, UINT32 begin, UINT32 end, UINT16 minJump, UINT16 relativeJumpQ16)
+	{
+		for (UINT32 u = begin; u < end; u++)
+		{
+			const UINT16 c = pRow[u];
+			const UINT16 threshold = jumpThreshold(c, minJump, relativeJumpQ16);
+
+			bool jump = isJump(c, pUp[u], threshold) || isJump(c, pDown[u], threshold)
+				|| (u > 0 && isJump(c, pRow[u - 1], threshold))
+				|| (u + 1 < width && isJump(c, pRow[u + 1], threshold));
+
+			pOut[u] = jump ? 0 : c;
+		}
+	}
+}
+
+void FlyingPixelFilter::setThreshold(UINT16 minJump, float relativeJump)
+{
+	float q16 = relativeJump * 65536.0f;
+	m_nMinJump = minJump;
+	m_nRelativeJumpQ16 = static_cast<UINT16>(q16 < 0.0f ? 0.0f : (q16 > 65535.0f ? 65535.0f : q16));
+}
+
+const UINT16* FlyingPixelFilter::apply(const DepthFrame& frame)
+{
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+	m_vecClean.resize(pixelCount);
+	m_vecFiltered.resize(pixelCount);
+
+	clean(m_vecClean.data(), frame.pDepth, frame.pSigma, pixelCount, frame.maxValidDepth);
+	filterRows(m_vecFiltered.data(), m_vecClean.data(), frame.width, frame.height);
+
+	return m_vecFiltered.data();
+}
+
+void FlyingPixelFilter::applyReference(UINT16* pOut, const DepthFrame& frame) const
+{
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+	std::vector<UINT16> cleaned(pixelCount);
+	for (size_t i = 0; i < pixelCount; i++) {
+		cleaned[i] = cleanScalar(frame.pDepth[i], frame.pSigma, i, frame.maxValidDepth);
+	}
+
+	for (UINT32 v = 0; v < frame.height; v++)
+	{
+		const UINT16* pRow = cleaned.data() + static_cast<size_t>(v) * frame.width;
+		const UINT16* pUp = v > 0 ? pRow - frame.width : pRow;
+		const UINT16* pDown = v + 1 < frame.height ? pRow + frame.width : pRow;
+		filterScalar(pOut + static_cast<size_t>(v) * frame.width, pRow, pUp, pDown, frame.width, 0, frame.width, m_nMinJump, m_nRelativeJumpQ16);
+	}
+}
+
+#if defined(_XM_SSE_INTRINSICS_)
+
+// |a - b| of unsigned 16 bit lanes
+static inline __m128i _absDiffU16(__m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+}
+
+// Non-zero lanes where |c - n| > threshold and n is valid
+static inline __m128i _jumpU16(__m128i c, __m128i n, __m128i threshold, __m128i zero)
+{
+	__m128i excess = _mm_subs_epu16(_absDiffU16(c, n), threshold);
+	return _mm_andnot_si128(_mm_cmpeq_epi16(n, zero), excess);
+}
+
+void FlyingPixelFilter::clean(UINT16* pOut, const UINT16* pDepth, const BYTE* pSigma, size_t count, UINT16 maxValidDepth)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i sigmaMask = _mm_set1_epi16(DEPTH_SIGMA_INVALID_MASK);
+	const __m128i maxValid = _mm_set1_epi16(static_cast<short>(maxValidDepth));
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i depth = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDepth + i));
+
+		// depth > maxValidDepth (unsigned)
+		__m128i invalid = _mm_xor_si128(_mm_cmpeq_epi16(_mm_subs_epu16(depth, maxValid), zero), _mm_cmpeq_epi16(zero, zero));
+		if (pSigma)
+		{
+			__m128i sigma = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSigma + i)), zero);
+			invalid = _mm_or_si128(invalid, _mm_cmpeq_epi16(_mm_and_si128(sigma, sigmaMask), sigmaMask));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), _mm_andnot_si128(invalid, depth));
+	}
+
+	for (; i < count; i++) {
+		pOut[i] = cleanScalar(pDepth[i], pSigma, i, maxValidDepth);
+	}
+}
+
+void FlyingPixelFilter::filterRows(UINT16* pOut, const UINT16* pClean, UINT32 width, UINT32 height) const
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i minJump = _mm_set1_epi16(static_cast<short>(m_nMinJump));
+	const __m128i relativeJump = _mm_set1_epi16(static_cast<short>(m_nRelativeJumpQ16));
+
+	for (UINT32 v = 0; v < height; v++)
+	{
+		const UINT16* pRow = pClean + static_cast<size_t>(v) * width;
+		const UINT16* pUp = v > 0 ? pRow - width : pRow;
+		const UINT16* pDown = v + 1 < height ? pRow + width : pRow;
+		UINT16* pDst = pOut + static_cast<size_t>(v) * width;
+
+		// Interior columns: u - 1 and u + 8 stay inside the row
+		UINT32 u = 1;
+		for (; u + 9 <= width; u += 8)
+		{
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + u));
+			__m128i threshold = _mm_adds_epu16(minJump, _mm_mulhi_epu16(c, relativeJump));
+
+			__m128i jump = _jumpU16(c, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + u - 1)), threshold, zero);
+			jump = _mm_or_si128(jump, _jumpU16(c, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + u + 1)), threshold, zero));
+			jump = _mm_or_si128(jump, _jumpU16(c, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pUp + u)), threshold, zero));
+			jump = _mm_or_si128(jump, _jumpU16(c, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDown + u)), threshold, zero));
+
+			__m128i keep = _mm_cmpeq_epi16(jump, zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + u), _mm_and_si128(keep, c));
+		}
+
+		filterScalar(pDst, pRow, pUp, pDown, width, 0, (std::min)(1u, width), m_nMinJump, m_nRelativeJumpQ16);
+		filterScalar(pDst, pRow, pUp, pDown, width, (std::max)(u, (std::min)(1u, width)), width, m_nMinJump, m_nRelativeJumpQ16);
+	}
+}
+
+#elif defined(_XM_ARM_NEON_INTRINSICS_)
+
+// Non-zero lanes where |c - n| > threshold and n is valid
+static inline uint16x8_t _jumpU16(uint16x8_t c, uint16x8_t n, uint16x8_t threshold)
+{
+	uint16x8_t excess = vqsubq_u16(vabdq_u16(c, n), threshold);
+	return vandq_u16(excess, vtstq_u16(n, n));
+}
+
+void FlyingPixelFilter::clean(UINT16* pOut, const UINT16* pDepth, const BYTE* pSigma, size_t count, UINT16 maxValidDepth)
+{
+	const uint16x8_t sigmaMask = vdupq_n_u16(DEPTH_SIGMA_INVALID_MASK);
+	const uint16x8_t maxValid = vdupq_n_u16(maxValidDepth);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t depth = vld1q_u16(pDepth + i);
+
+		uint16x8_t invalid = vcgtq_u16(depth, maxValid);
+		if (pSigma)
+		{
+			uint16x8_t sigma = vmovl_u8(vld1_u8(pSigma + i));
+			invalid = vorrq_u16(invalid, vtstq_u16(sigma, sigmaMask));
+		}
+
+		vst1q_u16(pOut + i, vbicq_u16(depth, invalid));
+	}
+
+	for (; i < count; i++) {
+		pOut[i] = cleanScalar(pDepth[i], pSigma, i, maxValidDepth);
+	}
+}
+
+void FlyingPixelFilter::filterRows(UINT16* pOut, const UINT16* pClean, UINT32 width, UINT32 height) const
+{
+	const uint16x8_t minJump = vdupq_n_u16(m_nMinJump);
+	const uint16x4_t relativeJump = vdup_n_u16(m_nRelativeJumpQ16);
+
+	for (UINT32 v = 0; v < height; v++)
+	{
+		const UINT16* pRow = pClean + static_cast<size_t>(v) * width;
+		const UINT16* pUp = v > 0 ? pRow - width : pRow;
+		const UINT16* pDown = v + 1 < height ? pRow + width : pRow;
+		UINT16* pDst = pOut + static_cast<size_t>(v) * width;
+
+		// Interior columns: u - 1 and u + 8 stay inside the row
+		UINT32 u = 1;
+		for (; u + 9 <= width; u += 8)
+		{
+			uint16x8_t c = vld1q_u16(pRow + u);
+
+			// (c * relativeJumpQ16) >> 16
+			uint16x4_t scaledLo = vshrn_n_u32(vmull_u16(vget_low_u16(c), relativeJump), 16);
+			uint16x4_t scaledHi = vshrn_n_u32(vmull_u16(vget_high_u16(c), relativeJump), 16);
+			uint16x8_t threshold = vqaddq_u16(minJump, vcombine_u16(scaledLo, scaledHi));
+
+			uint16x8_t jump = _jumpU16(c, vld1q_u16(pRow + u - 1), threshold);
+			jump = vorrq_u16(jump, _jumpU16(c, vld1q_u16(pRow + u + 1), threshold));
+			jump = vorrq_u16(jump, _jumpU16(c, vld1q_u16(pUp + u), threshold));
+			jump = vorrq_u16(jump, _jumpU16(c, vld1q_u16(pDown + u), threshold));
+
+			vst1q_u16(pDst + u, vbicq_u16(c, vtstq_u16(jump, jump)));
+		}
+
+		filterScalar(pDst, pRow, pUp, pDown, width, 0, (std::min)(1u, width), m_nMinJump, m_nRelativeJumpQ16);
+		filterScalar(pDst, pRow, pUp, pDown, width, (std::max)(u, (std::min)(1u, width)), width, m_nMinJump, m_nRelativeJumpQ16);
+	}
+}
+
+#else // _XM_NO_INTRINSICS_
+
+void FlyingPixelFilter::clean(UINT16* pOut, const UINT16* pDepth, const BYTE* pSigma, size_t count, UINT16 maxValidDepth)
+{
+	for (size_t i = 0; i < count; i++) {
+		pOut[i] = cleanScalar(pDepth[i], pSigma, i, maxValidDepth);
+	}
+}
+
+void FlyingPixelFilter::filterRows(UINT16* pOut, const UINT16* pClean, UINT32 width, UINT32 height) const
+{
+	for (UINT32 v = 0; v < height; v++)
+	{
+		const UINT16* pRow = pClean + static_cast<size_t>(v) * width;
+		const UINT16* pUp = v > 0 ? pRow - width : pRow;
+		const UINT16* pDown = v + 1 < height ? pRow + width : pRow;
+		filterScalar(pOut + static_cast<size_t>(v) * width, pRow, pUp, pDown, width, 0, width, m_nMinJump, m_nRelativeJumpQ16);
+	}
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef _FLYING_PIXEL_FILTER_H_
+#define _FLYING_PIXEL_FILTER_H_
+
+#include "DepthFrameSource.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Removes flying (mixed depth) pixels at depth discontinuities from a raw depth image.
+	// A pixel is invalidated if the depth jump to any valid 4-neighbour exceeds
+	//   minJump + depth * relativeJump    (millimeter)
+	// Pixels invalidated by the sigma mask or maxValidDepth are removed first and do not take part as neighbours.
+	// Scratch buffers are kept between calls, a filter instance must be used by one thread at a time.
+	class FlyingPixelFilter
+	{
+	private:
+		UINT16 m_nMinJump;
+		UINT16 m_nRelativeJumpQ16; // relativeJump in 0.16 fixed point
+
+		std::vector<UINT16> m_vecClean;    // depth with invalid pixels set to 0
+		std::vector<UINT16> m_vecFiltered;
+
+	public:
+		explicit FlyingPixelFilter(UINT16 minJump = 25, float relativeJump = 0.02f) { setThreshold(minJump, relativeJump); }
+
+		// `relativeJump` is clamped to [0, 1).
+		void setThreshold(UINT16 minJump, float relativeJump);
+
+		// Returns the filtered depth image (frame.width * frame.height, invalid pixels are 0), valid until the next call.
+		// Unproject it without sigma buffer and depth limit, both are already applied.
+		const UINT16* apply(const DepthFrame& frame);
+
+		// Scalar reference of apply() writing to `pOut`. The vectorized path must produce identical output.
+		void applyReference(UINT16* pOut, const DepthFrame& frame) const;
+
+	private:
+		static void clean(UINT16* pOut, const UINT16* pDepth, const BYTE* pSigma, size_t count, UINT16 maxValidDepth);
+		void filterRows(UINT16* pOut, const UINT16* pClean, UINT32 width, UINT32 height) const;
+	};
+};
+
+#endif
@@ -0,0 +1,451 @@
+#include "pch.h"
+#include "ImageSpacePicker.h"
+#include "DepthUnprojection.h"
+
+#include <climits>
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Probe of pickPoint() (Helper.h), _probeInside() repeats its arithmetic operation by operation
+static constexpr float PROBE_RADIUS_ON_METER = 0.015f; // 1.5 cm
+static constexpr float PR_SQ_PLUS_ONE = 1.0f + (PROBE_RADIUS_ON_METER * PROBE_RADIUS_ON_METER);
+
+// Farthest point UnprojectDepth() can produce (z, meter)
+static constexpr float MAX_DEPTH = DEPTH_MAX_VALID_ANY * DEPTH_MM_TO_METER;
+
+static constexpr int PROJECT_ITERATIONS = 3;
+static constexpr UINT32 MAX_GRID_SCALE = 4; // grid cells per pixel along each axis, at most
+
+static inline XMVECTOR _loadPoint(const XMFLOAT3& point) { return XMLoadFloat3(&point); }
+static inline XMVECTOR _loadPoint(const QuantizedPoint& point) { return LoadQuantizedPoint(point); }
+
+// Ties go to the lower index, as in the sequential scan of pickPoint(). Returns true if `pickIdx` changed.
+template <typename TPoint>
+static inline bool _probeInside(float& minLen, int& pickIdx, const TPoint* pPoints, UINT32 index, FXMVECTOR pos, FXMVECTOR dir)
+{
+	XMVECTOR v = _loadPoint(pPoints[index]);
+	v = XMVectorSubtract(v, pos);
+
+	float len1 = XMVectorGetX(XMVector3Dot(v, dir));
+	if (len1 < FLT_EPSILON) { return false; }
+
+	v = XMVector3LengthSq(v);
+
+	float len1Sq = len1 * len1;
+	float distSq = XMVectorGetX(v);
+	if (distSq < (PR_SQ_PLUS_ONE * len1Sq))
+	{
+		const int i = static_cast<int>(index);
+		float len2Sq = distSq - len1Sq;
+		if (len2Sq < minLen || (len2Sq == minLen && i < pickIdx)) {
+			minLen = len2Sq;
+			pickIdx = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Unit plane derivatives at pixel (u, v), central differences (one-sided at the border)
+static inline void _jacobian(const DepthImageProjection& projection, UINT32 u, UINT32 v, XMFLOAT2& du, XMFLOAT2& dv)
+{
+	const UINT32 u0 = u > 0 ? u - 1 : u, u1 = u + 1 < projection.width ? u + 1 : u;
+	const UINT32 v0 = v > 0 ? v - 1 : v, v1 = v + 1 < projection.height ? v + 1 : v;
+	const size_t row = static_cast<size_t>(v) * projection.width;
+
+	const XMFLOAT2& pu0 = projection.unitPlane[row + u0];
+	const XMFLOAT2& pu1 = projection.unitPlane[row + u1];
+	const XMFLOAT2& pv0 = projection.unitPlane[static_cast<size_t>(v0) * projection.width + u];
+	const XMFLOAT2& pv1 = projection.unitPlane[static_cast<size_t>(v1) * projection.width + u];
+
+	const float su = 1.0f / static_cast<float>(u1 - u0);
+	const float sv = 1.0f / static_cast<float>(v1 - v0);
+	du = XMFLOAT2((pu1.x - pu0.x) * su, (pu1.y - pu0.y) * su);
+	dv = XMFLOAT2((pv1.x - pv0.x) * sv, (pv1.y - pv0.y) * sv);
+}
+
+std::shared_ptr<const DepthImageProjection> DepthImageProjection::Build(const XMFLOAT4* pUnitPlane, UINT32 width, UINT32 height)
+{
+	if (width < 2 || height < 2) { return nullptr; }
+
+	auto pProjection = std::make_shared<DepthImageProjection>();
+	DepthImageProjection& projection = *pProjection;
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+
+	projection.width = width;
+	projection.height = height;
+	projection.unitPlane.resize(pixelCount);
+	for (size_t i = 0; i < pixelCount; i++) {
+		projection.unitPlane[i] = XMFLOAT2(pUnitPlane[i].x, pUnitPlane[i].y);
+	}
+
+	// Pixels the sensor failed to map are left at the origin of the unit plane (see UnitPlaneCache::MapPixel())
+	auto isMapped = [&](size_t i) { return projection.unitPlane[i].x != 0.0f || projection.unitPlane[i].y != 0.0f; };
+
+	// Smallest singular value of the pixel -> unit plane derivative, i.e. the largest pixel step per unit plane step
+	float minSigma = FLT_MAX;
+	XMFLOAT2 lo = { FLT_MAX, FLT_MAX };
+	XMFLOAT2 hi = { -FLT_MAX, -FLT_MAX };
+	for (UINT32 v = 0; v < height; v++)
+	{
+		for (UINT32 u = 0; u < width; u++)
+		{
+			const size_t i = static_cast<size_t>(v) * width + u;
+			if (!isMapped(i)) { continue; }
+
+			const XMFLOAT2& p = projection.unitPlane[i];
+			lo = XMFLOAT2((std::min)(lo.x, p.x), (std::min)(lo.y, p.y));
+			hi = XMFLOAT2((std::max)(hi.x, p.x), (std::max)(hi.y, p.y));
+
+			const bool isNeighbourhoodMapped =
+				(u == 0 || isMapped(i - 1)) && (u + 1 == width || isMapped(i + 1)) &&
+				(v == 0 || isMapped(i - width)) && (v + 1 == height || isMapped(i + width));
+			if (!isNeighbourhoodMapped) { continue; }
+
+			XMFLOAT2 du, dv;
+			_jacobian(projection, u, v, du, dv);
+
+			const float frobeniusSq = du.x * du.x + du.y * du.y + dv.x * dv.x + dv.y * dv.y;
+			const float det = du.x * dv.y - du.y * dv.x;
+			const float discriminant = (std::max)(0.0f, frobeniusSq * frobeniusSq - 4.0f * det * det);
+			const float sigmaSq = 0.5f * (frobeniusSq - sqrtf(discriminant));
+			minSigma = (std::min)(minSigma, sqrtf((std::max)(0.0f, sigmaSq)));
+		}
+	}
+	if (!(minSigma > 0.0f) || minSigma == FLT_MAX) { return nullptr; }
+
+	projection.maxPixelsPerUnit = 1.0f / minSigma;
+
+	// Grid cells no larger than a pixel, capped at MAX_GRID_SCALE^2 cells per pixel
+	projection.gridOrigin = lo;
+	projection.cellSize = (std::max)(minSigma, (std::max)((hi.x - lo.x) / (MAX_GRID_SCALE * width), (hi.y - lo.y) / (MAX_GRID_SCALE * height)));
+	projection.gridWidth = static_cast<UINT32>((hi.x - lo.x) / projection.cellSize) + 1;
+	projection.gridHeight = static_cast<UINT32>((hi.y - lo.y) / projection.cellSize) + 1;
+
+	const size_t cellCount = static_cast<size_t>(projection.gridWidth) * projection.gridHeight;
+	projection.gridPixel.assign(cellCount, INVALID_POINT_INDEX);
+
+	// Each cell takes the mapped pixel nearest to its center
+	std::vector<float> vecDistSq(cellCount, FLT_MAX);
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		if (!isMapped(i)) { continue; }
+
+		const XMFLOAT2& p = projection.unitPlane[i];
+		const float gx = (p.x - lo.x) / projection.cellSize;
+		const float gy = (p.y - lo.y) / projection.cellSize;
+		const UINT32 cx = (std::min)(projection.gridWidth - 1, static_cast<UINT32>(gx));
+		const UINT32 cy = (std::min)(projection.gridHeight - 1, static_cast<UINT32>(gy));
+		const float ex = gx - (cx + 0.5f), ey = gy - (cy + 0.5f);
+
+		const size_t cell = static_cast<size_t>(cy) * projection.gridWidth + cx;
+		if (ex * ex + ey * ey < vecDistSq[cell])
+		{
+			vecDistSq[cell] = ex * ex + ey * ey;
+			projection.gridPixel[cell] = static_cast<UINT32>(i);
+		}
+	}
+
+	// Empty cells (between sparse pixels and outside the field of view) take the pixel of their nearest filled cell
+	std::vector<UINT32> queue;
+	queue.reserve(cellCount);
+	for (size_t cell = 0; cell < cellCount; cell++) {
+		if (projection.gridPixel[cell] != INVALID_POINT_INDEX) { queue.push_back(static_cast<UINT32>(cell)); }
+	}
+	for (size_t head = 0; head < queue.size(); head++)
+	{
+		const UINT32 cell = queue[head];
+		const UINT32 cx = cell % projection.gridWidth, cy = cell / projection.gridWidth;
+		const UINT32 neighbours[4] = {
+			cx > 0 ? cell - 1 : cell,
+			cx + 1 < projection.gridWidth ? cell + 1 : cell,
+			cy > 0 ? cell - projection.gridWidth : cell,
+			cy + 1 < projection.gridHeight ? cell + projection.gridWidth : cell,
+		};
+		for (UINT32 neighbour : neighbours)
+		{
+			if (projection.gridPixel[neighbour] == INVALID_POINT_INDEX)
+			{
+				projection.gridPixel[neighbour] = projection.gridPixel[cell];
+				queue.push_back(neighbour);
+			}
+		}
+	}
+
+	return pProjection;
+}
+
+XMFLOAT2 DepthImageProjection::project(float x, float y) const
+{
+	const float gx = (std::min)((std::max)((x - gridOrigin.x) / cellSize, 0.0f), static_cast<float>(gridWidth - 1));
+	const float gy = (std::min)((std::max)((y - gridOrigin.y) / cellSize, 0.0f), static_cast<float>(gridHeight - 1));
+	const UINT32 pixel = gridPixel[static_cast<size_t>(gy) * gridWidth + static_cast<size_t>(gx)];
+
+	// Newton steps on the unit plane table, from the pixel of the grid cell
+	UINT32 u = pixel % width, v = pixel / width;
+	XMFLOAT2 result(static_cast<float>(u), static_cast<float>(v));
+	for (int iteration = 0; iteration < PROJECT_ITERATIONS; iteration++)
+	{
+		XMFLOAT2 du, dv;
+		_jacobian(*this, u, v, du, dv);
+
+		const float det = du.x * dv.y - du.y * dv.x;
+		if (fabsf(det) < FLT_MIN) { break; }
+
+		const XMFLOAT2& p = unitPlane[static_cast<size_t>(v) * width + u];
+		const float ex = x - p.x, ey = y - p.y;
+		result.x = u + (dv.y * ex - dv.x * ey) / det;
+		result.y = v + (du.x * ey - du.y * ex) / det;
+
+		const UINT32 nu = static_cast<UINT32>((std::min)((std::max)(result.x + 0.5f, 0.0f), static_cast<float>(width - 1)));
+		const UINT32 nv = static_cast<UINT32>((std::min)((std::max)(result.y + 0.5f, 0.0f), static_cast<float>(height - 1)));
+		if (nu == u && nv == v) { break; }
+		u = nu;
+		v = nv;
+	}
+	return result;
+}
+
+// Gaze ray in point cloud (camera) coordinates, exactly as pickPoint() computes it
+struct _GazeRay
+{
+	XMVECTOR pos;
+	XMVECTOR dir;
+	XMFLOAT3 origin; // pos
+	XMFLOAT3 axis;   // unit dir
+	float coneTan;   // pickPoint() accepts the points inside the cone |perpendicular| < coneTan * t along the axis (t)
+	float slackSq;   // bound of the rounding of |perpendicular|^2 from pickPoint()'s squared distance, per t^2
+};
+
+static bool _toGazeRay(_GazeRay& ray, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, XMMATRIX pointCloudModel)
+{
+	XMVECTOR det = XMMatrixDeterminant(pointCloudModel);
+	pointCloudModel = XMMatrixInverse(&det, pointCloudModel);
+
+	ray.pos = XMVector3TransformCoord(XMLoadFloat3(&gazeOrigin), pointCloudModel);
+	ray.dir = XMVector3TransformNormal(XMLoadFloat3(&gazeDirection), pointCloudModel);
+
+	const float dirLength = XMVectorGetX(XMVector3Length(ray.dir));
+	if (!(dirLength > 0.5f && dirLength < 2.0f)) { return false; }
+
+	XMStoreFloat3(&ray.origin, ray.pos);
+	XMStoreFloat3(&ray.axis, XMVectorScale(ray.dir, 1.0f / dirLength));
+
+	const float dirLengthSq = dirLength * dirLength;
+	const float coneTanSq = PR_SQ_PLUS_ONE * dirLengthSq - 1.0f;
+	ray.coneTan = coneTanSq > 0.0f ? sqrtf(coneTanSq + 1e-5f) + 1e-4f : 0.0f;
+
+	// pickPoint() minimizes |v|^2 - (v . dir)^2 = |perpendicular|^2 + (1 - |dir|^2) t^2, rounded at the scale of |v|^2
+	ray.slackSq = fabsf(1.0f - dirLengthSq) + 16.0f * FLT_EPSILON * (1.0f + ray.coneTan * ray.coneTan);
+	return true;
+}
+
+bool ImageSpacePicker::markBand(const DepthImageProjection& projection, const XMFLOAT3& o, const XMFLOAT3& a, float coneTan, float maxDistanceSq, float slackSq)
+{
+	const int width = static_cast<int>(projection.width);
+	const int height = static_cast<int>(projection.height);
+	m_vecRowBegin.assign(height, INT_MAX);
+	m_vecRowEnd.assign(height, INT_MIN);
+
+	// Part of the axis in front of the camera (z >= MIN_DEPTH), up to the farthest point the cone can hold
+	float t = 0.0f;
+	if (o.z < MIN_DEPTH)
+	{
+		if (!(a.z > 0.0f)) { return false; }
+		t = (MIN_DEPTH - o.z) / a.z;
+	}
+	// Cone points at t are at least t - |o| away from the camera, points at most MAX_DEPTH * |(x, y, 1)|
+	const float maxX = (std::max)(fabsf(projection.gridOrigin.x), fabsf(projection.gridOrigin.x + projection.gridWidth * projection.cellSize));
+	const float maxY = (std::max)(fabsf(projection.gridOrigin.y), fabsf(projection.gridOrigin.y + projection.gridHeight * projection.cellSize));
+	const float tEnd = sqrtf(o.x * o.x + o.y * o.y + o.z * o.z) + MAX_DEPTH * sqrtf(1.0f + maxX * maxX + maxY * maxY);
+
+	// Walk the axis, marking the pixels the cross section of the cone at t may project to
+	// (the disc of radius rho around c = o + t * a, at depth z >= max(MIN_DEPTH, c.z - rho)).
+	const float ppu = projection.maxPixelsPerUnit;
+	bool isBandEmpty = true;
+	while (t <= tEnd)
+	{
+		const float cx = o.x + a.x * t, cy = o.y + a.y * t;
+		float cz = o.z + a.z * t;
+		if (cz < MIN_DEPTH)
+		{
+			if (!(a.z > 0.0f)) { break; } // the axis turned behind the camera
+			cz = MIN_DEPTH;               // rounding of the first t
+		}
+
+		float rho = coneTan * t;
+		if (maxDistanceSq < FLT_MAX) {
+			rho = (std::min)(rho, sqrtf(maxDistanceSq + slackSq * t * t));
+		}
+		if (cz - rho > MAX_DEPTH) { break; }
+
+		const float lateral = sqrtf(cx * cx + cy * cy);
+		const float radius = rho * (cz + lateral) / ((std::max)(MIN_DEPTH, cz - rho) * cz) * ppu + PIXEL_MARGIN + 1.0f;
+
+		const XMFLOAT2 center = projection.project(cx / cz, cy / cz);
+		const float u0 = (std::max)(center.x - radius, 0.0f), u1 = (std::min)(center.x + radius, static_cast<float>(width - 1));
+		const float v0 = (std::max)(center.y - radius, 0.0f), v1 = (std::min)(center.y + radius, static_cast<float>(height - 1));
+		if (u0 <= u1 && v0 <= v1)
+		{
+			const int ub = static_cast<int>(ceilf(u0)), ue = static_cast<int>(u1);
+			for (int v = static_cast<int>(ceilf(v0)); v <= static_cast<int>(v1); v++)
+			{
+				m_vecRowBegin[v] = (std::min)(m_vecRowBegin[v], ub);
+				m_vecRowEnd[v] = (std::max)(m_vecRowEnd[v], ue);
+			}
+			isBandEmpty = false;
+		}
+
+		// About a pixel per step inside the image, larger steps towards it from outside.
+		// The step is also bounded by 10% of t and of the depth, so that the disc radius and the speed change little.
+		const float outside = (std::max)(
+			(std::max)(-(center.x + radius), center.x - radius - (width - 1)),
+			(std::max)(-(center.y + radius), center.y - radius - (height - 1)));
+		const float stepPixels = (std::max)(1.0f, 0.5f * outside);
+
+		const float vx = (a.x * cz - cx * a.z) / (cz * cz);
+		const float vy = (a.y * cz - cy * a.z) / (cz * cz);
+		const float speed = sqrtf(vx * vx + vy * vy) * ppu;
+
+		float dt = speed > 0.0f ? stepPixels / speed : FLT_MAX;
+		dt = (std::min)(dt, (std::max)(0.1f * t, 1e-3f));
+		if (a.z != 0.0f) { dt = (std::min)(dt, 0.1f * cz / fabsf(a.z)); }
+		t += (std::max)(dt, 1e-4f);
+	}
+	return !isBandEmpty;
+}
+
+template <typename TPoint>
+bool ImageSpacePicker::probePixels(const UINT32* pPixelToIndex, UINT32 width, int u0, int u1, int v, const TPoint* pPoints, size_t count, FXMVECTOR pos, FXMVECTOR dir, float& minLen, int& pickIdx)
+{
+	const UINT32* pRow = pPixelToIndex + static_cast<size_t>(v) * width;
+	for (int u = u0; u <= u1; u++)
+	{
+		const UINT32 index = pRow[u];
+		if (index == INVALID_POINT_INDEX) { continue; }
+		if (index >= count) { return false; } // not the points of this pixel map
+
+		if (_probeInside(minLen, pickIdx, pPoints, index, pos, dir)) {
+			m_nPickPixel = static_cast<UINT32>(v) * width + u;
+		}
+	}
+	return true;
+}
+
+bool ImageSpacePicker::pick(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const XMFLOAT3* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx)
+{
+	return pickPoints(projection, pPixelToIndex, gazeOrigin, gazeDirection, pPoints, count, pointCloudModel, pickIdx);
+}
+
+bool ImageSpacePicker::pick(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const QuantizedPoint* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx)
+{
+	return pickPoints(projection, pPixelToIndex, gazeOrigin, gazeDirection, pPoints, count, pointCloudModel, pickIdx);
+}
+
+template <typename TPoint>
+bool ImageSpacePicker::pickPoints(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const TPoint* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx)
+{
+	pickIdx = -1;
+
+	_GazeRay ray;
+	if (!_toGazeRay(ray, gazeOrigin, gazeDirection, pointCloudModel)) { return false; }
+	if (!markBand(projection, ray.origin, ray.axis, ray.coneTan, FLT_MAX, 0.0f)) { return false; }
+
+	float minLen = FLT_MAX;
+	for (UINT32 v = 0; v < projection.height; v++)
+	{
+		if (!probePixels(pPixelToIndex, projection.width, m_vecRowBegin[v], m_vecRowEnd[v], v, pPoints, count, ray.pos, ray.dir, minLen, pickIdx))
+		{
+			pickIdx = -1;
+			return false;
+		}
+	}
+
+	return pickIdx >= 0;
+}
+
+bool ImageSpacePicker::pickCoherent(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const XMFLOAT3* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx)
+{
+	return pickCoherentPoints(projection, pPixelToIndex, gazeOrigin, gazeDirection, pPoints, count, pointCloudModel, pickIdx);
+}
+
+bool ImageSpacePicker::pickCoherent(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const QuantizedPoint* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx)
+{
+	return pickCoherentPoints(projection, pPixelToIndex, gazeOrigin, gazeDirection, pPoints, count, pointCloudModel, pickIdx);
+}
+
+template <typename TPoint>
+bool ImageSpacePicker::pickCoherentPoints(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const TPoint* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx)
+{
+	pickIdx = -1;
+
+	const bool hasLastHit = m_fHasLastHit && m_nLastWidth == projection.width && m_nLastHeight == projection.height;
+	m_fHasLastHit = false;
+
+	_GazeRay ray;
+	if (!_toGazeRay(ray, gazeOrigin, gazeDirection, pointCloudModel)) { return false; }
+
+	const int width = static_cast<int>(projection.width);
+	const int height = static_cast<int>(projection.height);
+	float minLen = FLT_MAX;
+
+	if (hasLastHit)
+	{
+		// Point of the current ray at the distance of the last hit, or the last hit pixel if that is behind the camera
+		XMVECTOR det = XMMatrixDeterminant(pointCloudModel);
+		const XMVECTOR lastHit = XMVector3TransformCoord(XMLoadFloat3(&m_lastHit), XMMatrixInverse(&det, pointCloudModel));
+		const float t = XMVectorGetX(XMVector3Dot(XMVectorSubtract(lastHit, ray.pos), XMLoadFloat3(&ray.axis)));
+
+		XMFLOAT2 center(static_cast<float>(m_nPickPixel % projection.width), static_cast<float>(m_nPickPixel / projection.width));
+		const float cz = ray.origin.z + ray.axis.z * t;
+		if (t > 0.0f && cz >= MIN_DEPTH) {
+			center = projection.project((ray.origin.x + ray.axis.x * t) / cz, (ray.origin.y + ray.axis.y * t) / cz);
+		}
+
+		// Growing windows (each level probes the ring around the previous one) until a point inside the probe radius
+		const int cu = static_cast<int>(floorf(center.x + 0.5f)), cv = static_cast<int>(floorf(center.y + 0.5f));
+		int inner = -1;
+		for (int radius : COHERENT_WINDOW_RADII)
+		{
+			const int v0 = (std::max)(cv - radius, 0), v1 = (std::min)(cv + radius, height - 1);
+			const int u0 = (std::max)(cu - radius, 0), u1 = (std::min)(cu + radius, width - 1);
+			for (int v = v0; v <= v1 && u0 <= u1; v++)
+			{
+				bool isProbed = true;
+				if (v < cv - inner || v > cv + inner) {
+					isProbed = probePixels(pPixelToIndex, projection.width, u0, u1, v, pPoints, count, ray.pos, ray.dir, minLen, pickIdx);
+				}
+				else {
+					isProbed = probePixels(pPixelToIndex, projection.width, u0, (std::min)(u1, cu - inner - 1), v, pPoints, count, ray.pos, ray.dir, minLen, pickIdx) &&
+						probePixels(pPixelToIndex, projection.width, (std::max)(u0, cu + inner + 1), u1, v, pPoints, count, ray.pos, ray.dir, minLen, pickIdx);
+				}
+				if (!isProbed) { pickIdx = -1; return false; }
+			}
+			inner = radius;
+			if (pickIdx >= 0) { break; }
+		}
+	}
+
+	// A point inside the probe radius bounds the distance of the best one to the ray, so the band narrows to that distance.
+	// Without one, the band covers the whole cone.
+	const float maxDistanceSq = pickIdx >= 0 ? (std::max)(minLen, 0.0f) : FLT_MAX;
+	if (!markBand(projection, ray.origin, ray.axis, ray.coneTan, maxDistanceSq, ray.slackSq)) { return false; }
+
+	for (int v = 0; v < height; v++)
+	{
+		if (!probePixels(pPixelToIndex, projection.width, m_vecRowBegin[v], m_vecRowEnd[v], v, pPoints, count, ray.pos, ray.dir, minLen, pickIdx))
+		{
+			pickIdx = -1;
+			return false;
+		}
+	}
+	if (pickIdx < 0) { return false; }
+
+	// Remember the hit (gaze coordinates, i.e. independent of the frame) for the next call
+	XMStoreFloat3(&m_lastHit, XMVector3TransformCoord(_loadPoint(pPoints[pickIdx]), pointCloudModel));
+	m_nLastWidth = projection.width;
+	m_nLastHeight = projection.height;
+	m_fHasLastHit = true;
+	return true;
+}
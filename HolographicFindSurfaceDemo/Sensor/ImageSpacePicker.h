@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef _IMAGE_SPACE_PICKER_H_
+#define _IMAGE_SPACE_PICKER_H_
+
+#include "PointQuantization.h"
+
+#include <memory>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Inverse of the unit plane table (camera unit plane -> depth image pixel) of one resolution,
+	// immutable once built and shared by every organized frame of that resolution.
+	struct DepthImageProjection
+	{
+		UINT32 width = 0;
+		UINT32 height = 0;
+		std::vector<DirectX::XMFLOAT2> unitPlane; // (x, y) of each pixel, see UnprojectDepth()
+		float maxPixelsPerUnit = 0.0f;            // bound of the pixel displacement per unit plane displacement
+
+		// Uniform grid over the unit plane, each cell holds the pixel nearest to it (start of project())
+		DirectX::XMFLOAT2 gridOrigin = { 0.0f, 0.0f };
+		float cellSize = 0.0f;
+		UINT32 gridWidth = 0;
+		UINT32 gridHeight = 0;
+		std::vector<UINT32> gridPixel;
+
+		// Returns nullptr if the table is degenerate (e.g. the sensor failed to map the pixels).
+		static std::shared_ptr<const DepthImageProjection> Build(const DirectX::XMFLOAT4* pUnitPlane, UINT32 width, UINT32 height);
+
+		// Pixel coordinates (pixel (u, v) at (u, v)) of the camera space direction (x, y, 1),
+		// extrapolated from the image border outside the field of view.
+		DirectX::XMFLOAT2 project(float x, float y) const;
+	};
+
+	// Picks an organized frame through the pixels that the gaze cone of pickPoint() (Helper.h) covers in the depth image,
+	// instead of every point: the gaze ray is projected into the image and walked from near to far, so the cost is
+	// O(W + H) pixels of the band around it. Owned by the consumer thread (scratch buffers).
+	class ImageSpacePicker
+	{
+	public:
+		static constexpr float MIN_DEPTH = 0.05f;   // meter, nearer than any point the depth sensors report
+		static constexpr float PIXEL_MARGIN = 2.0f; // slack of the band: projection error, decoded millimeter points
+
+		static constexpr int COHERENT_WINDOW_RADII[] = { 2, 6, 18 }; // pixels around the predicted hit, see pickCoherent()
+
+	private:
+		std::vector<int> m_vecRowBegin; // band column range per image row, begin > end if the row is outside the band
+		std::vector<int> m_vecRowEnd;
+		UINT32 m_nPickPixel = 0;        // pixel of the best point probed so far
+
+		// Last hit of pickCoherent()
+		bool m_fHasLastHit = false;
+		DirectX::XMFLOAT3 m_lastHit;    // gaze (world) coordinates
+		UINT32 m_nLastWidth = 0;
+		UINT32 m_nLastHeight = 0;
+
+	public:
+		// Same pick as pickPoint() over `pPoints`, the points of an organized frame whose pixels `projection` maps.
+		// Returns false if the gaze does not pick a point inside the probe radius (pickPoint() falls back to the point
+		// of the least angle to the ray, which can be anywhere in the frame), or if the ray is degenerate.
+		// The caller scans the frame then.
+		bool pick(
+			const DepthImageProjection& projection,
+			const UINT32* pPixelToIndex,
+			const DirectX::XMFLOAT3& gazeOrigin,
+			const DirectX::XMFLOAT3& gazeDirection,
+			const DirectX::XMFLOAT3* pPoints,
+			size_t count,
+			DirectX::XMMATRIX pointCloudModel,
+			_Out_ int& pickIdx
+		);
+		// Same as pick() over the quantized points of the frame (PointCloudFrame::quantizedPoints).
+		bool pick(
+			const DepthImageProjection& projection,
+			const UINT32* pPixelToIndex,
+			const DirectX::XMFLOAT3& gazeOrigin,
+			const DirectX::XMFLOAT3& gazeDirection,
+			const QuantizedPoint* pPoints,
+			size_t count,
+			DirectX::XMMATRIX pointCloudModel,
+			_Out_ int& pickIdx
+		);
+
+		// Same as pick(), starting from the last hit: while the gaze rests, the hit moves little between frames.
+		// Windows of COHERENT_WINDOW_RADII around the pixel where the ray reaches the distance of the last hit are probed
+		// first. A point found inside the probe radius bounds the distance of the best point to the ray, so the walk
+		// only needs the pixels within that distance instead of the whole cone. The result is proven the same as pick().
+		bool pickCoherent(
+			const DepthImageProjection& projection,
+			const UINT32* pPixelToIndex,
+			const DirectX::XMFLOAT3& gazeOrigin,
+			const DirectX::XMFLOAT3& gazeDirection,
+			const DirectX::XMFLOAT3* pPoints,
+			size_t count,
+			DirectX::XMMATRIX pointCloudModel,
+			_Out_ int& pickIdx
+		);
+		// Same as pickCoherent() over the quantized points of the frame (PointCloudFrame::quantizedPoints).
+		bool pickCoherent(
+			const DepthImageProjection& projection,
+			const UINT32* pPixelToIndex,
+			const DirectX::XMFLOAT3& gazeOrigin,
+			const DirectX::XMFLOAT3& gazeDirection,
+			const QuantizedPoint* pPoints,
+			size_t count,
+			DirectX::XMMATRIX pointCloudModel,
+			_Out_ int& pickIdx
+		);
+		inline void resetCoherence() { m_fHasLastHit = false; }
+
+	private:
+		// Marks the pixels the part of the cone (apex `o`, unit axis `a`) within sqrt(maxDistanceSq + slackSq * t^2)
+		// of the axis may project to. Returns false if the band is empty.
+		bool markBand(const DepthImageProjection& projection, const DirectX::XMFLOAT3& o, const DirectX::XMFLOAT3& a, float coneTan, float maxDistanceSq, float slackSq);
+		// Probes pixels [u0, u1] of row v, returns false if the pixel map does not belong to `pPoints`.
+		template <typename TPoint>
+		bool probePixels(const UINT32* pPixelToIndex, UINT32 width, int u0, int u1, int v, const TPoint* pPoints, size_t count, DirectX::FXMVECTOR pos, DirectX::FXMVECTOR dir, float& minLen, int& pickIdx);
+		template <typename TPoint>
+		bool pickPoints(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const DirectX::XMFLOAT3& gazeOrigin, const DirectX::XMFLOAT3& gazeDirection, const TPoint* pPoints, size_t count, DirectX::XMMATRIX pointCloudModel, int& pickIdx);
+		template <typename TPoint>
+		bool pickCoherentPoints(const DepthImageProjection& projection, const UINT32* pPixelToIndex, const DirectX::XMFLOAT3& gazeOrigin, const DirectX::XMFLOAT3& gazeDirection, const TPoint* pPoints, size_t count, DirectX::XMMATRIX pointCloudModel, int& pickIdx);
+	};
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "ImuPoseInterpolator.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+static constexpr float TICKS_TO_SECOND = 1e-7f;
+
+// Orientation integrated piecewise between consecutive samples, angular velocity interpolated linearly.
+// Orientation q at time t is relative to the first integrated timestamp, body frame increments
+// (Hamilton q * dq, which is XMQuaternionMultiply(dq, q)).
+class _GyroIntegrator
+{
+private:
+	const std::vector<ImuSample>& m_samples;
+	size_t m_nSegment = 0;     // m_samples[m_nSegment].hostTicks <= m_nTicks < m_samples[m_nSegment + 1].hostTicks
+	UINT64 m_nTicks;
+	XMVECTOR m_orientation = XMQuaternionIdentity();
+
+public:
+	_GyroIntegrator(const std::vector<ImuSample>& samples, UINT64 startTicks) : m_samples(samples), m_nTicks(startTicks) {}
+
+	// `ticks` must not decrease between calls
+	XMVECTOR advance(UINT64 ticks)
+	{
+		while (m_nTicks < ticks)
+		{
+			while (m_nSegment + 2 < m_samples.size() && m_samples[m_nSegment + 1].hostTicks <= m_nTicks) { m_nSegment++; }
+
+			const ImuSample& a = m_samples[m_nSegment];
+			const ImuSample& b = m_samples[m_nSegment + 1];
+			const UINT64 end = (std::min)(ticks, (std::max)(b.hostTicks, m_nTicks + 1));
+
+			// Midpoint rule on the sub-interval
+			const float span = static_cast<float>(b.hostTicks - a.hostTicks);
+			const float t = span > 0.0f ? 0.5f * static_cast<float>((m_nTicks - a.hostTicks) + (end - a.hostTicks)) / span : 0.0f;
+			XMVECTOR omega = XMVectorLerp(XMLoadFloat3(&a.value), XMLoadFloat3(&b.value), t);
+
+			const float speed = XMVectorGetX(XMVector3Length(omega));
+			const float angle = speed * static_cast<float>(end - m_nTicks) * TICKS_TO_SECOND;
+			if (angle > 1e-9f)
+			{
+				XMVECTOR delta = XMQuaternionRotationNormal(XMVectorScale(omega, 1.0f / speed), angle);
+				m_orientation = XMQuaternionNormalize(XMQuaternionMultiply(delta, m_orientation));
+			}
+			m_nTicks = end;
+		}
+		return m_orientation;
+	}
+};
+
+ImuPoseInterpolator::ImuPoseInterpolator()
+{
+	XMStoreFloat4x4(&m_matImuToTarget, XMMatrixIdentity());
+}
+
+void ImuPoseInterpolator::setTargetFrame(const XMFLOAT4X4& imuToTarget)
+{
+	XMMATRIX m = XMLoadFloat4x4(&imuToTarget);
+	m.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMStoreFloat4x4(&m_matImuToTarget, m);
+}
+
+bool ImuPoseInterpolator::getRotation(const ImuRing& gyro, UINT64 referenceTicks, UINT64 ticks, XMFLOAT4& rotation)
+{
+	return getRotations(gyro, referenceTicks, ticks, 0, 1, &rotation);
+}
+
+bool ImuPoseInterpolator::getRotations(const ImuRing& gyro, UINT64 referenceTicks, UINT64 firstTicks, UINT64 stepTicks, size_t count, XMFLOAT4* pRotations)
+{
+	if (count < 1) { return true; }
+
+	const UINT64 lastTicks = firstTicks + stepTicks * (count - 1);
+	const UINT64 startTicks = (std::min)(referenceTicks, firstTicks);
+	const UINT64 endTicks = (std::max)(referenceTicks, lastTicks);
+
+	if (!gyro.copy(startTicks, endTicks, m_vecSamples) || m_vecSamples.size() < 2) { return false; }
+
+	// Angular velocity in the target frame
+	const XMMATRIX imuToTarget = XMLoadFloat4x4(&m_matImuToTarget);
+	for (ImuSample& sample : m_vecSamples) {
+		XMStoreFloat3(&sample.value, XMVector3TransformNormal(XMLoadFloat3(&sample.value), imuToTarget));
+	}
+
+	// One sweep over the ascending timestamps, the reference timestamp is visited in between
+	_GyroIntegrator integrator(m_vecSamples, startTicks);
+	XMVECTOR reference = XMQuaternionIdentity();
+	bool referenceVisited = false;
+	for (size_t i = 0; i < count; i++)
+	{
+		const UINT64 ticks = firstTicks + stepTicks * i;
+		if (!referenceVisited && referenceTicks <= ticks)
+		{
+			reference = integrator.advance(referenceTicks);
+			referenceVisited = true;
+		}
+		XMStoreFloat4(&pRotations[i], integrator.advance(ticks));
+	}
+	if (!referenceVisited) {
+		reference = integrator.advance(referenceTicks);
+	}
+
+	// Relative to the reference timestamp: conjugate(q_ref) * q_t (Hamilton)
+	const XMVECTOR inverseReference = XMQuaternionConjugate(reference);
+	for (size_t i = 0; i < count; i++) {
+		XMStoreFloat4(&pRotations[i], XMQuaternionMultiply(XMLoadFloat4(&pRotations[i]), inverseReference));
+	}
+	return true;
+}
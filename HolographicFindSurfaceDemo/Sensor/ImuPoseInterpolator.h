@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef _IMU_POSE_INTERPOLATOR_H_
+#define _IMU_POSE_INTERPOLATOR_H_
+
+#include "ImuRingBuffer.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Rotation of a rigidly mounted frame (e.g. the depth camera) between two timestamps, integrated from gyroscope samples.
+	// A rotation maps directions observed at a timestamp into the frame at the reference timestamp:
+	//     XMVector3Rotate(directionAtTicks, rotation) = directionAtReferenceTicks
+	// Only rotation is corrected, translation over a few milliseconds is negligible next to it at depth sensor range.
+	class ImuPoseInterpolator
+	{
+	private:
+		DirectX::XMFLOAT4X4 m_matImuToTarget; // rotation part only
+		std::vector<ImuSample> m_vecSamples;  // scratch, angular velocity in the target frame
+
+	public:
+		ImuPoseInterpolator();
+
+		// `imuToTarget` rotates gyroscope vectors into the target frame (row vector convention),
+		// e.g. Inverse(gyroscope extrinsic) * camera extrinsic. Identity by default.
+		void setTargetFrame(const DirectX::XMFLOAT4X4& imuToTarget);
+
+		// Returns false if `gyro` does not cover both timestamps.
+		bool getRotation(const ImuRing& gyro, UINT64 referenceTicks, UINT64 ticks, _Out_ DirectX::XMFLOAT4& rotation);
+
+		// Rotations of `count` timestamps firstTicks, firstTicks + stepTicks, ... (e.g. the rows of a depth image),
+		// with a single read of `gyro`. Returns false if `gyro` does not cover all timestamps.
+		bool getRotations(const ImuRing& gyro, UINT64 referenceTicks, UINT64 firstTicks, UINT64 stepTicks, size_t count, _Out_writes_(count) DirectX::XMFLOAT4* pRotations);
+	};
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "ImuReplaySource.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+typedef std::chrono::duration<int64_t, std::ratio<1, 10'000'000>> _HostTicks; // 100 ns
+
+ImuReplaySource::ImuReplaySource(std::shared_ptr<const std::vector<ImuSample>> pSamples, const DirectX::XMFLOAT4X4& extrinsic, Pacing pacing, size_t batchSize)
+	: m_pSamples(std::move(pSamples)), m_matExtrinsic(extrinsic), m_pacing(pacing), m_nBatchSize(batchSize)
+{
+	if (batchSize < 1) {
+		throw std::invalid_argument("ImuReplaySource: batchSize must be positive");
+	}
+}
+
+bool ImuReplaySource::open()
+{
+	if (!m_pSamples || m_pSamples->empty()) { return false; }
+
+	std::lock_guard lock(m_hWaitMutex);
+	m_nNextSample = 0;
+	m_fEndOfStream = false;
+	m_fInterrupted = false;
+	m_fClockStarted = false;
+
+	return true;
+}
+
+void ImuReplaySource::interrupt()
+{
+	{
+		std::lock_guard lock(m_hWaitMutex);
+		m_fInterrupted = true;
+	}
+	m_cvWait.notify_all();
+}
+
+bool ImuReplaySource::acquireSamples(std::vector<ImuSample>& samples)
+{
+	const std::vector<ImuSample>& recorded = *m_pSamples;
+	if (m_nNextSample >= recorded.size())
+	{
+		m_fEndOfStream = true;
+		return false;
+	}
+
+	const size_t end = (std::min)(recorded.size(), m_nNextSample + m_nBatchSize);
+
+	std::unique_lock lock(m_hWaitMutex);
+	if (m_pacing == PACING_REAL_TIME)
+	{
+		if (!m_fClockStarted)
+		{
+			m_fClockStarted = true;
+			m_tpStart = std::chrono::steady_clock::now();
+			m_nStartTicks = recorded[m_nNextSample].hostTicks;
+		}
+
+		const UINT64 latestTicks = recorded[end - 1].hostTicks;
+		if (latestTicks > m_nStartTicks)
+		{
+			auto due = m_tpStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_HostTicks(latestTicks - m_nStartTicks));
+			m_cvWait.wait_until(lock, due, [this] { return m_fInterrupted; });
+		}
+	}
+
+	if (m_fInterrupted)
+	{
+		m_fInterrupted = false;
+		return false; // deliver the same batch next time
+	}
+
+	samples.insert(samples.end(), recorded.begin() + m_nNextSample, recorded.begin() + end);
+	m_nNextSample = end;
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#ifndef _IMU_REPLAY_SOURCE_H_
+#define _IMU_REPLAY_SOURCE_H_
+
+#include "ImuSampleSource.h"
+
+#include <chrono>
+#include <condition_variable>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Deterministic replay of recorded IMU samples (ascending hostTicks), in batches like the live sensor.
+	class ImuReplaySource : public ImuSampleSource
+	{
+	public:
+		enum Pacing
+		{
+			PACING_REAL_TIME,            // Deliver each batch once its latest sample is due
+			PACING_AS_FAST_AS_POSSIBLE   // Deliver next batch as soon as it is requested
+		};
+
+	private:
+		std::shared_ptr<const std::vector<ImuSample>> m_pSamples;
+		DirectX::XMFLOAT4X4 m_matExtrinsic;
+		Pacing m_pacing;
+		size_t m_nBatchSize;
+
+		size_t m_nNextSample = 0;
+		bool m_fEndOfStream = false;
+
+		// Real-time pacing
+		std::chrono::steady_clock::time_point m_tpStart;
+		UINT64 m_nStartTicks = 0;
+		bool m_fClockStarted = false;
+
+		// Interruption
+		std::mutex m_hWaitMutex;
+		std::condition_variable m_cvWait;
+		bool m_fInterrupted = false;
+
+	public:
+		// `extrinsic` is the recorded RigPose to IMU matrix. Throws std::invalid_argument if `batchSize` is 0.
+		ImuReplaySource(std::shared_ptr<const std::vector<ImuSample>> pSamples, const DirectX::XMFLOAT4X4& extrinsic, Pacing pacing = PACING_REAL_TIME, size_t batchSize = 32);
+
+	public: // ImuSampleSource
+		bool open() override;
+		void close() override {}
+		bool acquireSamples(std::vector<ImuSample>& samples) override;
+		bool isEndOfStream() const override { return m_fEndOfStream; }
+		void interrupt() override;
+
+		void getExtrinsics(_Out_ DirectX::XMFLOAT4X4* pExtrinsic) override { *pExtrinsic = m_matExtrinsic; }
+	};
+};
+
+#endif
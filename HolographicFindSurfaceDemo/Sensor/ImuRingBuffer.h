@@ -0,0 +1,152 @@
+#pragma once
+
+#ifndef _IMU_RING_BUFFER_H_
+#define _IMU_RING_BUFFER_H_
+
+#include <atomic>
+
+namespace HolographicFindSurfaceDemo
+{
+	struct ImuSample
+	{
+		UINT64            hostTicks = 0;   // 100 ns, same clock as DepthFrame::hostTicks
+		DirectX::XMFLOAT3 value = { 0.0f, 0.0f, 0.0f }; // rad/s (gyroscope) or m/s^2 (accelerometer) in the IMU frame
+	};
+
+	// Lock-free single producer / multiple consumer ring of timestamped IMU samples.
+	// The producer push()es samples in timestamp order, overwriting the oldest ones.
+	// Consumers never block the producer, they detect a concurrent overwrite of what they read instead.
+	template <size_t CAPACITY>
+	class ImuRingBuffer
+	{
+		static_assert(CAPACITY > 1 && (CAPACITY & (CAPACITY - 1)) == 0, "ImuRingBuffer: CAPACITY must be a power of two");
+
+	private:
+		struct Slot
+		{
+			std::atomic<UINT64> hostTicks{ 0 };
+			std::atomic<float> value[3];
+		};
+		static constexpr UINT64 INDEX_MASK = CAPACITY - 1;
+
+		Slot m_slots[CAPACITY];
+		std::atomic<UINT64> m_nWriting{ 0 }; // samples the producer started to write
+		std::atomic<UINT64> m_nWritten{ 0 }; // samples readable by consumers
+		std::atomic<UINT64> m_nCleared{ 0 }; // samples dropped by clear()
+
+	public: // Producer
+		inline void push(const ImuSample& sample)
+		{
+			const UINT64 n = m_nWritten.load(std::memory_order_relaxed);
+			Slot& slot = m_slots[n & INDEX_MASK];
+
+			// Announce the overwrite before touching the slot (see read())
+			m_nWriting.store(n + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			slot.hostTicks.store(sample.hostTicks, std::memory_order_relaxed);
+			slot.value[0].store(sample.value.x, std::memory_order_relaxed);
+			slot.value[1].store(sample.value.y, std::memory_order_relaxed);
+			slot.value[2].store(sample.value.z, std::memory_order_relaxed);
+
+			m_nWritten.store(n + 1, std::memory_order_release);
+		}
+
+		// Drops all samples (e.g. when a replay restarts with earlier timestamps).
+		// Indices keep counting up, so that consumers never mix samples from before and after.
+		inline void clear() { m_nCleared.store(m_nWritten.load(std::memory_order_relaxed), std::memory_order_release); }
+
+	public: // Consumer
+		// Copies the samples within [fromTicks, toTicks] to `out`, together with the nearest sample on each side,
+		// so that every timestamp of the range lies between two copied samples.
+		// Returns false if the ring does not cover the whole range (yet or any more), or the producer overwrote it meanwhile.
+		bool copy(UINT64 fromTicks, UINT64 toTicks, std::vector<ImuSample>& out) const
+		{
+			out.clear();
+
+			const UINT64 cleared = m_nCleared.load(std::memory_order_acquire);
+			const UINT64 end = m_nWritten.load(std::memory_order_acquire);
+			const UINT64 begin = (std::max)(end > CAPACITY ? end - CAPACITY : 0, cleared);
+			if (end <= begin) { return false; }
+
+			// First sample later than fromTicks
+			UINT64 lo = begin;
+			UINT64 hi = end;
+			UINT64 lowest = end; // oldest slot read
+			while (lo < hi)
+			{
+				const UINT64 mid = lo + (hi - lo) / 2;
+				lowest = (std::min)(lowest, mid);
+				if (ticksAt(mid) <= fromTicks) { lo = mid + 1; }
+				else { hi = mid; }
+			}
+			if (lo == begin) { return false; } // older than the ring
+			lowest = (std::min)(lowest, lo - 1);
+
+			for (UINT64 k = lo - 1; k < end; k++)
+			{
+				out.push_back(read(k));
+				if (out.back().hostTicks >= toTicks) { break; }
+			}
+
+			// What was read is intact, if the producer has not announced to overwrite the oldest slot read
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (m_nWriting.load(std::memory_order_relaxed) > lowest + CAPACITY || m_nCleared.load(std::memory_order_relaxed) != cleared)
+			{
+				out.clear();
+				return false;
+			}
+			return out.back().hostTicks >= toTicks;
+		}
+
+		// Linear interpolation of the samples around `ticks`.
+		bool interpolate(UINT64 ticks, _Out_ DirectX::XMFLOAT3& value) const
+		{
+			thread_local std::vector<ImuSample> samples;
+			if (!copy(ticks, ticks, samples)) { return false; }
+
+			const ImuSample& a = samples.front();
+			const ImuSample& b = samples.back();
+			const float t = b.hostTicks > a.hostTicks ? static_cast<float>(ticks - a.hostTicks) / static_cast<float>(b.hostTicks - a.hostTicks) : 0.0f;
+			DirectX::XMStoreFloat3(&value, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&a.value), DirectX::XMLoadFloat3(&b.value), t));
+			return true;
+		}
+
+		// Timestamp of the latest sample, 0 if empty.
+		inline UINT64 latestTicks() const
+		{
+			const UINT64 cleared = m_nCleared.load(std::memory_order_acquire);
+			const UINT64 end = m_nWritten.load(std::memory_order_acquire);
+			return end > cleared ? ticksAt(end - 1) : 0;
+		}
+
+		inline size_t size() const
+		{
+			const UINT64 cleared = m_nCleared.load(std::memory_order_relaxed);
+			const UINT64 end = m_nWritten.load(std::memory_order_relaxed);
+			return static_cast<size_t>(end > cleared ? (std::min)(end - cleared, static_cast<UINT64>(CAPACITY)) : 0);
+		}
+
+		static constexpr size_t capacity() { return CAPACITY; }
+
+	private:
+		inline UINT64 ticksAt(UINT64 index) const { return m_slots[index & INDEX_MASK].hostTicks.load(std::memory_order_relaxed); }
+
+		inline ImuSample read(UINT64 index) const
+		{
+			const Slot& slot = m_slots[index & INDEX_MASK];
+
+			ImuSample sample;
+			sample.hostTicks = slot.hostTicks.load(std::memory_order_relaxed);
+			sample.value.x = slot.value[0].load(std::memory_order_relaxed);
+			sample.value.y = slot.value[1].load(std::memory_order_relaxed);
+			sample.value.z = slot.value[2].load(std::memory_order_relaxed);
+			return sample;
+		}
+	};
+
+	// Several seconds of Research Mode gyroscope or accelerometer samples
+	typedef ImuRingBuffer<8192> ImuRing;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef _IMU_SAMPLE_SOURCE_H_
+#define _IMU_SAMPLE_SOURCE_H_
+
+#include "ImuRingBuffer.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Interface of IMU sample producers (one sensor each) consumed by ImuStream's threads.
+	class ImuSampleSource
+	{
+	public:
+		virtual ~ImuSampleSource() = default;
+
+	public: // Called on the IMU thread
+		// Prepares streaming, returns false if the stream can not be opened.
+		virtual bool open() = 0;
+		virtual void close() = 0;
+
+		// Waits for the next batch of samples and appends them to `samples` in timestamp order.
+		// Returns false if no sample is available (interrupted, failed or end of stream).
+		virtual bool acquireSamples(std::vector<ImuSample>& samples) = 0;
+
+		// True if acquireSamples() will never return a sample again.
+		virtual bool isEndOfStream() const { return false; }
+
+	public: // Called on any thread
+		// Wakes up blocking acquireSamples() so that the IMU thread can check its exit flag.
+		virtual void interrupt() {}
+
+	public: // Calibration
+		// Extrinsic Matrix (RigPose to IMU)
+		virtual void getExtrinsics(_Out_ DirectX::XMFLOAT4X4* pExtrinsic) = 0;
+	};
+};
+
+#endif
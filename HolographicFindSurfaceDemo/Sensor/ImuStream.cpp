@@ -0,0 +1,97 @@
+#include "pch.h"
+#include "ImuStream.h"
+
+#include <chrono>
+
+using namespace HolographicFindSurfaceDemo;
+
+// Thread
+void ImuStream::ImuLoopThread(ImuStream* pOwner, Channel* pChannel)
+{
+	ImuSampleSource* pSource = pChannel->pSource.get();
+
+	if (pSource->open())
+	{
+		std::vector<ImuSample> samples;
+		UINT64 latestTicks = 0;
+
+		while (!pOwner->m_fExit)
+		{
+			samples.clear();
+			if (pSource->acquireSamples(samples))
+			{
+				for (const ImuSample& sample : samples)
+				{
+					// Keep the ring ascending (batches of the live sensor may overlap by a sample)
+					if (sample.hostTicks <= latestTicks) { continue; }
+					pChannel->ring.push(sample);
+					latestTicks = sample.hostTicks;
+				}
+			}
+			else if (pSource->isEndOfStream()) {
+				break;
+			}
+			else if (!pOwner->m_fExit) {
+				// Failed (e.g. GetNextBuffer), retry later instead of spinning
+				std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_MILLISECONDS));
+			}
+		}
+
+		pSource->close();
+	}
+}
+
+ImuStream::ImuStream(std::unique_ptr<ImuSampleSource> pGyroSource, std::unique_ptr<ImuSampleSource> pAccelSource)
+{
+	if (!pGyroSource) {
+		throw std::invalid_argument("ImuStream: gyroscope source is required");
+	}
+
+	m_gyro.pSource = std::move(pGyroSource);
+	m_gyro.pSource->getExtrinsics(&m_gyro.extrinsic);
+
+	m_accel.pSource = std::move(pAccelSource);
+	if (m_accel.pSource) {
+		m_accel.pSource->getExtrinsics(&m_accel.extrinsic);
+	}
+	else {
+		DirectX::XMStoreFloat4x4(&m_accel.extrinsic, DirectX::XMMatrixIdentity());
+	}
+}
+
+void ImuStream::start()
+{
+	stop();
+
+	m_fExit = false;
+	startChannel(m_gyro);
+	startChannel(m_accel);
+}
+
+void ImuStream::stop()
+{
+	m_fExit = true;
+	stopChannel(m_gyro);
+	stopChannel(m_accel);
+}
+
+void ImuStream::startChannel(Channel& channel)
+{
+	if (!channel.pSource) { return; }
+
+	channel.ring.clear();
+	channel.pThread = new std::thread(ImuLoopThread, this, &channel);
+}
+
+void ImuStream::stopChannel(Channel& channel)
+{
+	if (!channel.pThread) { return; }
+
+	if (channel.pThread->joinable()) {
+		channel.pSource->interrupt();
+		channel.pThread->join();
+	}
+	// Cleanup thread context
+	delete channel.pThread;
+	channel.pThread = nullptr;
+}
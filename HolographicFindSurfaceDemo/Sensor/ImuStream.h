@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef _IMU_STREAM_H_
+#define _IMU_STREAM_H_
+
+#include "ImuSampleSource.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Acquires gyroscope (and optionally accelerometer) samples on a thread per sensor into lock-free rings,
+	// which any thread can read without waiting for the sensors or pose queries.
+	class ImuStream
+	{
+	private:
+		struct Channel
+		{
+			std::unique_ptr<ImuSampleSource> pSource;
+			DirectX::XMFLOAT4X4 extrinsic;  // RigPose to IMU
+			std::thread* pThread = nullptr;
+			ImuRing ring;
+		};
+
+		static constexpr int RETRY_MILLISECONDS = 10; // after a failed acquisition
+
+		Channel m_gyro;
+		Channel m_accel;
+		std::atomic<bool> m_fExit{ false }; // Thread Exit Flag
+
+	public:
+		// Throws std::invalid_argument if `pGyroSource` is nullptr. `pAccelSource` is optional.
+		explicit ImuStream(std::unique_ptr<ImuSampleSource> pGyroSource, std::unique_ptr<ImuSampleSource> pAccelSource = nullptr);
+		~ImuStream() { stop(); }
+
+		ImuStream(const ImuStream&) = delete;
+		ImuStream& operator=(const ImuStream&) = delete;
+
+	public:
+		// Starts acquisition, rings are cleared.
+		void start();
+		void stop();
+
+	public: // Getter
+		// Angular velocity (rad/s) in the gyroscope frame.
+		inline const ImuRing& gyro() const { return m_gyro.ring; }
+		// Acceleration (m/s^2) in the accelerometer frame, stays empty without accelerometer source.
+		inline const ImuRing& accel() const { return m_accel.ring; }
+
+		// Extrinsic Matrix (RigPose to Gyroscope)
+		inline const DirectX::XMFLOAT4X4* getGyroExtrinsicPtr() const { return &m_gyro.extrinsic; }
+		// Extrinsic Matrix (RigPose to Accelerometer)
+		inline const DirectX::XMFLOAT4X4* getAccelExtrinsicPtr() const { return &m_accel.extrinsic; }
+
+	private:
+		void startChannel(Channel& channel);
+		void stopChannel(Channel& channel);
+
+	private: // Thread Function
+		static void ImuLoopThread(ImuStream* pOwner, Channel* pChannel);
+	};
+};
+
+#endif
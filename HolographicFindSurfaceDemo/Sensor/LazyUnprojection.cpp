@@ -0,0 +1,332 @@
+#include "pch.h"
+#include "LazyUnprojection.h"
+#include "DepthUnprojection.h"
+
+#include <cmath>
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Bounds of a tile: its points are r * d for pixel directions d within the angle a of the center direction c
+// and r in [rMin, rMax] (meter), so they lie in the capsule around the segment [rMin * cos(a) * c, rMax * c]
+// with radius rMax * sin(a).
+namespace
+{
+	struct Capsule
+	{
+		XMVECTOR a;
+		XMVECTOR b;
+		float radius;
+	};
+
+	// Slack for rounding of the unprojection and the bounds
+	constexpr float BOUND_EPSILON = 1e-4f;
+
+	// Distance from `p` to the cone (apex, unit axis, half angle given by cos / sin), 0 inside
+	inline float distanceToCone(XMVECTOR p, XMVECTOR apex, XMVECTOR axis, float cosAngle, float sinAngle)
+	{
+		XMVECTOR v = XMVectorSubtract(p, apex);
+		float t = XMVectorGetX(XMVector3Dot(v, axis));
+		float h = XMVectorGetX(XMVector3Length(XMVectorSubtract(v, XMVectorScale(axis, t))));
+
+		if (t >= 0.0f && h * cosAngle <= t * sinAngle) { return 0.0f; }   // inside
+		if (t * cosAngle + h * sinAngle <= 0.0f) { return XMVectorGetX(XMVector3Length(v)); } // closest to the apex
+		return h * cosAngle - t * sinAngle;                                 // closest to the mantle
+	}
+
+	// Minimum of the (convex) distance to the cone over the capsule segment
+	inline bool capsuleIntersectsCone(const Capsule& capsule, XMVECTOR apex, XMVECTOR axis, float cosAngle, float sinAngle)
+	{
+		constexpr float INV_PHI = 0.618033989f;
+		constexpr int ITERATIONS = 24;
+
+		auto distanceAt = [&](float s) {
+			return distanceToCone(XMVectorLerp(capsule.a, capsule.b, s), apex, axis, cosAngle, sinAngle);
+		};
+
+		// Most tiles are rejected by the bounding sphere of the capsule
+		const float halfLength = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(capsule.b, capsule.a)));
+		const float dm = distanceAt(0.5f);
+		if (dm > halfLength + capsule.radius) { return false; }
+		if (dm <= capsule.radius) { return true; }
+
+		float lo = 0.0f, hi = 1.0f;
+		float s1 = hi - INV_PHI * (hi - lo), s2 = lo + INV_PHI * (hi - lo);
+		float d1 = distanceAt(s1), d2 = distanceAt(s2);
+		float best = (std::min)((std::min)(distanceAt(0.0f), distanceAt(1.0f)), (std::min)((std::min)(d1, d2), dm));
+
+		for (int i = 0; i < ITERATIONS && best > capsule.radius; i++)
+		{
+			if (d1 < d2) {
+				hi = s2; s2 = s1; d2 = d1;
+				s1 = hi - INV_PHI * (hi - lo); d1 = distanceAt(s1);
+				best = (std::min)(best, d1);
+			}
+			else {
+				lo = s1; s1 = s2; d1 = d2;
+				s2 = lo + INV_PHI * (hi - lo); d2 = distanceAt(s2);
+				best = (std::min)(best, d2);
+			}
+		}
+
+		// Remaining bracket width bounds the error of the minimum (the distance is 1-Lipschitz along the segment)
+		float slack = (hi - lo) * XMVectorGetX(XMVector3Length(XMVectorSubtract(capsule.b, capsule.a)));
+		return best <= capsule.radius + slack;
+	}
+
+	// Valid depth range of a tile of `columns` x `rows` pixels, min > max if the tile has no valid pixel
+	inline void tileDepthRange(const UINT16* pDepth, UINT32 stride, UINT32 columns, UINT32 rows, UINT16& minDepth, UINT16& maxDepth)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		if (columns == LazyUnprojectionTable::TILE_SIZE)
+		{
+			// Signed 16 bit min / max on biased values (SSE2 has no unsigned variant), invalid 0 is excluded from the minimum
+			const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+			const __m128i zero = _mm_setzero_si128();
+			__m128i lo = _mm_set1_epi16(0x7FFF);
+			__m128i hi = _mm_set1_epi16(static_cast<short>(0x8000));
+
+			for (UINT32 r = 0; r < rows; r++)
+			{
+				__m128i depth = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDepth + static_cast<size_t>(r) * stride));
+				lo = _mm_min_epi16(lo, _mm_xor_si128(_mm_or_si128(depth, _mm_cmpeq_epi16(depth, zero)), bias));
+				hi = _mm_max_epi16(hi, _mm_xor_si128(depth, bias));
+			}
+
+			lo = _mm_min_epi16(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+			lo = _mm_min_epi16(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+			lo = _mm_min_epi16(lo, _mm_shufflelo_epi16(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+			hi = _mm_max_epi16(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+			hi = _mm_max_epi16(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+			hi = _mm_max_epi16(hi, _mm_shufflelo_epi16(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			minDepth = static_cast<UINT16>(_mm_cvtsi128_si32(lo) ^ 0x8000);
+			maxDepth = static_cast<UINT16>(_mm_cvtsi128_si32(hi) ^ 0x8000);
+			return;
+		}
+#elif defined(_XM_ARM_NEON_INTRINSICS_)
+		if (columns == LazyUnprojectionTable::TILE_SIZE)
+		{
+			uint16x8_t lo = vdupq_n_u16(0xFFFF);
+			uint16x8_t hi = vdupq_n_u16(0);
+
+			for (UINT32 r = 0; r < rows; r++)
+			{
+				uint16x8_t depth = vld1q_u16(pDepth + static_cast<size_t>(r) * stride);
+				lo = vminq_u16(lo, vorrq_u16(depth, vceqq_u16(depth, vdupq_n_u16(0))));
+				hi = vmaxq_u16(hi, depth);
+			}
+
+			// Pairwise reduction (vminvq_u16() / vmaxvq_u16() are AArch64 only)
+			uint16x4_t lo4 = vpmin_u16(vget_low_u16(lo), vget_high_u16(lo));
+			uint16x4_t hi4 = vpmax_u16(vget_low_u16(hi), vget_high_u16(hi));
+			lo4 = vpmin_u16(lo4, lo4);
+			hi4 = vpmax_u16(hi4, hi4);
+			lo4 = vpmin_u16(lo4, lo4);
+			hi4 = vpmax_u16(hi4, hi4);
+
+			minDepth = vget_lane_u16(lo4, 0);
+			maxDepth = vget_lane_u16(hi4, 0);
+			return;
+		}
+#endif
+		minDepth = 0xFFFF;
+		maxDepth = 0;
+		for (UINT32 r = 0; r < rows; r++)
+		{
+			for (UINT32 c = 0; c < columns; c++)
+			{
+				const UINT16 depthValue = pDepth[static_cast<size_t>(r) * stride + c];
+				if (depthValue == 0) { continue; }
+				minDepth = (std::min)(minDepth, depthValue);
+				maxDepth = (std::max)(maxDepth, depthValue);
+			}
+		}
+	}
+
+	inline bool capsuleIntersectsSphere(const Capsule& capsule, XMVECTOR center, float radius)
+	{
+		XMVECTOR ab = XMVectorSubtract(capsule.b, capsule.a);
+		float lengthSq = XMVectorGetX(XMVector3LengthSq(ab));
+		float s = lengthSq > 0.0f ? XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, capsule.a), ab)) / lengthSq : 0.0f;
+		s = (std::max)(0.0f, (std::min)(1.0f, s));
+
+		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMVectorLerp(capsule.a, capsule.b, s))));
+		return distance <= radius + capsule.radius;
+	}
+}
+
+std::shared_ptr<const LazyUnprojectionTable> LazyUnprojectionTable::Build(const XMFLOAT4* pUnitPlane, UINT32 width, UINT32 height)
+{
+	auto pTable = std::make_shared<LazyUnprojectionTable>();
+	pTable->width = width;
+	pTable->height = height;
+	pTable->tileCountX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	pTable->tileCountY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	pTable->unitPlane.assign(pUnitPlane, pUnitPlane + static_cast<size_t>(width) * height);
+	pTable->tileCone.resize(static_cast<size_t>(pTable->tileCountX) * pTable->tileCountY);
+
+	auto direction = [&](UINT32 u, UINT32 v) {
+		const XMFLOAT4& unit = pUnitPlane[static_cast<size_t>(v) * width + u];
+		return XMVector3Normalize(XMVectorSet(unit.x, unit.y, 1.0f, 0.0f));
+	};
+
+	for (UINT32 ty = 0; ty < pTable->tileCountY; ty++)
+	{
+		for (UINT32 tx = 0; tx < pTable->tileCountX; tx++)
+		{
+			const UINT32 u0 = tx * TILE_SIZE, u1 = (std::min)(width, u0 + TILE_SIZE);
+			const UINT32 v0 = ty * TILE_SIZE, v1 = (std::min)(height, v0 + TILE_SIZE);
+
+			XMVECTOR center = direction((u0 + u1) / 2, (v0 + v1) / 2);
+			float cosAngle = 1.0f;
+			for (UINT32 v = v0; v < v1; v++) {
+				for (UINT32 u = u0; u < u1; u++) {
+					cosAngle = (std::min)(cosAngle, XMVectorGetX(XMVector3Dot(center, direction(u, v))));
+				}
+			}
+
+			XMFLOAT4& cone = pTable->tileCone[static_cast<size_t>(ty) * pTable->tileCountX + tx];
+			XMStoreFloat4(&cone, XMVectorSetW(center, (std::max)(-1.0f, cosAngle)));
+		}
+	}
+
+	return pTable;
+}
+
+void LazyDepthImage::assign(std::shared_ptr<const LazyUnprojectionTable> pTable, const UINT16* pDepth, const BYTE* pSigma, UINT16 maxValidDepth)
+{
+	m_pTable = std::move(pTable);
+	if (!m_pTable) { return; }
+
+	const UINT32 width = m_pTable->width;
+	const size_t pixelCount = static_cast<size_t>(width) * m_pTable->height;
+	const size_t tileCount = m_pTable->tileCone.size();
+
+	m_vecDepth.resize(pixelCount);
+	m_vecTileMin.resize(tileCount);
+	m_vecTileMax.resize(tileCount);
+
+	if (!pSigma && maxValidDepth == DEPTH_MAX_VALID_ANY)
+	{
+		// already cleaned (e.g. by FlyingPixelFilter)
+		memcpy(m_vecDepth.data(), pDepth, pixelCount * sizeof(UINT16));
+	}
+	else
+	{
+		for (size_t index = 0; index < pixelCount; index++)
+		{
+			UINT16 depthValue = (pSigma && ((pSigma[index] & DEPTH_SIGMA_INVALID_MASK) > 0)) ? 0 : pDepth[index];
+			m_vecDepth[index] = depthValue <= maxValidDepth ? depthValue : 0;
+		}
+	}
+
+	constexpr UINT32 TILE_SIZE = LazyUnprojectionTable::TILE_SIZE;
+	for (UINT32 ty = 0; ty < m_pTable->tileCountY; ty++)
+	{
+		const UINT32 rows = (std::min)(TILE_SIZE, m_pTable->height - ty * TILE_SIZE);
+		for (UINT32 tx = 0; tx < m_pTable->tileCountX; tx++)
+		{
+			const size_t tile = static_cast<size_t>(ty) * m_pTable->tileCountX + tx;
+			const UINT32 columns = (std::min)(TILE_SIZE, width - tx * TILE_SIZE);
+			tileDepthRange(m_vecDepth.data() + static_cast<size_t>(ty) * TILE_SIZE * width + tx * TILE_SIZE, width, columns, rows, m_vecTileMin[tile], m_vecTileMax[tile]);
+		}
+	}
+}
+
+size_t LazyDepthImage::unprojectAll(std::vector<XMFLOAT3>& points, std::vector<UINT32>* pPixels) const
+{
+	return unprojectTiles(points, pPixels, [](const Capsule&) { return true; });
+}
+
+size_t LazyDepthImage::unprojectCone(std::vector<XMFLOAT3>& points, std::vector<UINT32>* pPixels, XMFLOAT3 origin, XMFLOAT3 direction, float tanHalfAngle) const
+{
+	const XMVECTOR apex = XMLoadFloat3(&origin);
+	const XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&direction));
+	const float cosAngle = 1.0f / std::sqrt(1.0f + tanHalfAngle * tanHalfAngle);
+	const float sinAngle = tanHalfAngle * cosAngle;
+
+	return unprojectTiles(points, pPixels, [&](const Capsule& capsule) {
+		return capsuleIntersectsCone(capsule, apex, axis, cosAngle, sinAngle);
+	});
+}
+
+size_t LazyDepthImage::unprojectSphere(std::vector<XMFLOAT3>& points, std::vector<UINT32>* pPixels, XMFLOAT3 center, float radius) const
+{
+	const XMVECTOR c = XMLoadFloat3(&center);
+	return unprojectTiles(points, pPixels, [&](const Capsule& capsule) {
+		return capsuleIntersectsSphere(capsule, c, radius);
+	});
+}
+
+template <typename TileTest>
+size_t LazyDepthImage::unprojectTiles(std::vector<XMFLOAT3>& points, std::vector<UINT32>* pPixels, TileTest&& test) const
+{
+	points.clear();
+	if (pPixels) { pPixels->clear(); }
+	if (!m_pTable) { return 0; }
+
+	const LazyUnprojectionTable& table = *m_pTable;
+	constexpr UINT32 TILE_SIZE = LazyUnprojectionTable::TILE_SIZE;
+
+	// Reused per thread: a frame is queried by the render thread and the FindSurface worker at the same time
+	thread_local std::vector<bool> selected;
+	selected.resize(table.tileCountX);
+
+	for (UINT32 ty = 0; ty < table.tileCountY; ty++)
+	{
+		bool any = false;
+		for (UINT32 tx = 0; tx < table.tileCountX; tx++)
+		{
+			const size_t tile = static_cast<size_t>(ty) * table.tileCountX + tx;
+			selected[tx] = false;
+			if (m_vecTileMin[tile] > m_vecTileMax[tile]) { continue; } // no valid pixel
+
+			const XMFLOAT4& cone = table.tileCone[tile];
+			const XMVECTOR center = XMLoadFloat4(&cone);
+			const float sinAngle = std::sqrt((std::max)(0.0f, 1.0f - cone.w * cone.w));
+			const float rMin = static_cast<float>(m_vecTileMin[tile]) * DEPTH_MM_TO_METER;
+			const float rMax = static_cast<float>(m_vecTileMax[tile]) * DEPTH_MM_TO_METER;
+
+			Capsule capsule;
+			capsule.a = XMVectorScale(center, rMin * (std::max)(0.0f, cone.w));
+			capsule.b = XMVectorScale(center, rMax);
+			capsule.radius = rMax * sinAngle + BOUND_EPSILON;
+
+			selected[tx] = test(capsule);
+			any = any || selected[tx];
+		}
+		if (!any) { continue; }
+
+		// Unproject runs of selected tiles row by row, so that points keep the order of the full image
+		const UINT32 v1 = (std::min)(table.height, (ty + 1) * TILE_SIZE);
+		for (UINT32 v = ty * TILE_SIZE; v < v1; v++)
+		{
+			for (UINT32 tx = 0; tx < table.tileCountX; )
+			{
+				if (!selected[tx]) { tx++; continue; }
+
+				UINT32 runEnd = tx + 1;
+				while (runEnd < table.tileCountX && selected[runEnd]) { runEnd++; }
+
+				const size_t begin = static_cast<size_t>(v) * table.width + tx * TILE_SIZE;
+				const size_t count = (std::min)(table.width, runEnd * TILE_SIZE) - tx * TILE_SIZE;
+
+				const size_t offset = points.size();
+				points.resize(offset + count);
+				points.resize(offset + UnprojectDepth(points.data() + offset, m_vecDepth.data() + begin, nullptr, table.unitPlane.data() + begin, count));
+
+				if (pPixels)
+				{
+					for (size_t i = 0; i < count; i++) {
+						if (m_vecDepth[begin + i] > 0) { pPixels->push_back(static_cast<UINT32>(begin + i)); }
+					}
+				}
+
+				tx = runEnd;
+			}
+		}
+	}
+
+	return points.size();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#ifndef _LAZY_UNPROJECTION_H_
+#define _LAZY_UNPROJECTION_H_
+
+#include <memory>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Per resolution data of lazy frames, immutable once built and shared by every frame of that resolution.
+	struct LazyUnprojectionTable
+	{
+		static constexpr UINT32 TILE_SIZE = 8;
+
+		UINT32 width = 0;
+		UINT32 height = 0;
+		UINT32 tileCountX = 0;
+		UINT32 tileCountY = 0;
+
+		std::vector<DirectX::XMFLOAT4> unitPlane; // see UnprojectDepth()
+		std::vector<DirectX::XMFLOAT4> tileCone;  // ( unit center direction of the tile pixels, cos of their largest angle to it )
+
+		static std::shared_ptr<const LazyUnprojectionTable> Build(const DirectX::XMFLOAT4* pUnitPlane, UINT32 width, UINT32 height);
+	};
+
+	// Depth image of a frame that is unprojected on demand, one region at a time.
+	// Regions are culled per tile (see LazyUnprojectionTable::TILE_SIZE) with conservative bounds, so a region query
+	// returns every point inside the region (and some around it), in the order UnprojectDepth() would produce them.
+	class LazyDepthImage
+	{
+	private:
+		std::shared_ptr<const LazyUnprojectionTable> m_pTable; // nullptr if empty
+		std::vector<UINT16> m_vecDepth;   // millimeter, invalid pixels are 0
+		std::vector<UINT16> m_vecTileMin; // valid depth range per tile, min > max if the tile has no valid pixel
+		std::vector<UINT16> m_vecTileMax;
+
+	public:
+		// Copies the depth image (dropping invalid pixels, see UnprojectDepth()) and computes the tile depth ranges.
+		// Buffers keep their capacity, assigning a recycled image of the same resolution does not allocate.
+		void assign(std::shared_ptr<const LazyUnprojectionTable> pTable, const UINT16* pDepth, const BYTE* pSigma, UINT16 maxValidDepth);
+		inline void reset() { m_pTable.reset(); }
+		inline bool empty() const { return !m_pTable; }
+
+		// Replaces `points` with the points of every pixel, `pPixels` receives their pixel indices (optional).
+		size_t unprojectAll(std::vector<DirectX::XMFLOAT3>& points, std::vector<UINT32>* pPixels) const;
+		// Points that may lie inside the cone with apex `origin`, unit axis `direction` and tan(half angle) `tanHalfAngle`.
+		size_t unprojectCone(std::vector<DirectX::XMFLOAT3>& points, std::vector<UINT32>* pPixels, DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 direction, float tanHalfAngle) const;
+		// Points that may lie inside the sphere.
+		size_t unprojectSphere(std::vector<DirectX::XMFLOAT3>& points, std::vector<UINT32>* pPixels, DirectX::XMFLOAT3 center, float radius) const;
+
+	private:
+		template <typename TileTest>
+		size_t unprojectTiles(std::vector<DirectX::XMFLOAT3>& points, std::vector<UINT32>* pPixels, TileTest&& test) const;
+	};
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "pch.h"
+#include "PointAccumulator.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+namespace
+{
+	// 21 bits per axis, voxel indices in [-2^20, 2^20)
+	constexpr int   KEY_AXIS_BITS = 21;
+	constexpr INT64 KEY_AXIS_OFFSET = 1ll << (KEY_AXIS_BITS - 1);
+	constexpr INT64 KEY_AXIS_MAX = (1ll << KEY_AXIS_BITS) - 1;
+
+	inline UINT64 axisIndex(float coord, float invVoxelSize)
+	{
+		INT64 index = static_cast<INT64>(floorf(coord * invVoxelSize)) + KEY_AXIS_OFFSET;
+		return static_cast<UINT64>(index < 0 ? 0 : (index > KEY_AXIS_MAX ? KEY_AXIS_MAX : index));
+	}
+
+	inline DirectX::XMFLOAT3 transformPoint(const DirectX::XMFLOAT3& p, const DirectX::XMFLOAT4X4& m)
+	{
+		// Row vector: [x y z 1] * M
+		return DirectX::XMFLOAT3(
+			p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+			p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+			p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43
+		);
+	}
+}
+
+void PointAccumulator::ValidateSettings(const Settings& settings)
+{
+	if (!(settings.voxelSize > 0.0f) || settings.maxVoxels < 1 || settings.maxSamples < 1) {
+		throw std::invalid_argument("PointAccumulator::setSettings(): invalid settings");
+	}
+}
+
+void PointAccumulator::setSettings(const Settings& settings)
+{
+	ValidateSettings(settings);
+	m_settings = settings;
+
+	// Load factor <= 0.5
+	size_t capacity = 16;
+	while (capacity < static_cast<size_t>(settings.maxVoxels) * 2) { capacity <<= 1; }
+
+	m_nHashShift = 64;
+	for (size_t c = capacity; c > 1; c >>= 1) { m_nHashShift--; }
+
+	m_vecSlots.assign(capacity, EMPTY_SLOT);
+	m_vecVoxels.clear();
+	m_vecVoxels.reserve(settings.maxVoxels);
+}
+
+void PointAccumulator::clear()
+{
+	std::fill(m_vecSlots.begin(), m_vecSlots.end(), EMPTY_SLOT);
+	m_vecVoxels.clear();
+}
+
+UINT64 PointAccumulator::voxelKey(const DirectX::XMFLOAT3& pt) const
+{
+	const float invVoxelSize = 1.0f / m_settings.voxelSize;
+	return (axisIndex(pt.x, invVoxelSize) << (2 * KEY_AXIS_BITS)) | (axisIndex(pt.y, invVoxelSize) << KEY_AXIS_BITS) | axisIndex(pt.z, invVoxelSize);
+}
+
+size_t PointAccumulator::homeSlot(UINT64 key) const
+{
+	return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_nHashShift);
+}
+
+UINT32 PointAccumulator::findSlot(UINT64 key) const
+{
+	// Returns the slot holding `key`, or the empty slot where it would be inserted
+	const size_t mask = m_vecSlots.size() - 1;
+	size_t pos = homeSlot(key);
+	while (m_vecSlots[pos] != EMPTY_SLOT && m_vecVoxels[m_vecSlots[pos]].key != key) {
+		pos = (pos + 1) & mask;
+	}
+	return static_cast<UINT32>(pos);
+}
+
+void PointAccumulator::integrate(const DirectX::XMFLOAT3* pPoints, size_t count, const DirectX::XMFLOAT4X4& cameraToWorld, UINT64 hostTicks)
+{
+	const DirectX::XMFLOAT3 sensorPosition(cameraToWorld._41, cameraToWorld._42, cameraToWorld._43);
+
+	// Make room first, so that the new frame is never the one being dropped
+	evict(sensorPosition, hostTicks);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const DirectX::XMFLOAT3 pt = transformPoint(pPoints[i], cameraToWorld);
+		const UINT64 key = voxelKey(pt);
+		const UINT32 slot = findSlot(key);
+
+		if (m_vecSlots[slot] == EMPTY_SLOT)
+		{
+			if (m_vecVoxels.size() >= m_settings.maxVoxels) { continue; } // full until the next eviction
+
+			m_vecSlots[slot] = static_cast<UINT32>(m_vecVoxels.size());
+			m_vecVoxels.push_back(Voxel{ key, pt, 1, hostTicks });
+			continue;
+		}
+
+		// Running average, turning into an exponential moving average after maxSamples
+		Voxel& voxel = m_vecVoxels[m_vecSlots[slot]];
+		if (voxel.samples < m_settings.maxSamples) { voxel.samples++; }
+		const float weight = 1.0f / static_cast<float>(voxel.samples);
+
+		voxel.mean.x += (pt.x - voxel.mean.x) * weight;
+		voxel.mean.y += (pt.y - voxel.mean.y) * weight;
+		voxel.mean.z += (pt.z - voxel.mean.z) * weight;
+		voxel.lastSeen = hostTicks;
+	}
+}
+
+void PointAccumulator::evict(const DirectX::XMFLOAT3& sensorPosition, UINT64 hostTicks)
+{
+	if (m_vecVoxels.empty()) { return; }
+
+	UINT64 ageCutoff = hostTicks > m_settings.maxAgeTicks ? hostTicks - m_settings.maxAgeTicks : 0;
+
+	// Keep a quarter of the budget free for the incoming frame: drop the oldest voxels, that is, the ones last seen before
+	// budgetCutoff and (in index order) as many last seen at budgetCutoff as needed, so that frames of equal age are trimmed too
+	const size_t keepBudget = m_settings.maxVoxels - m_settings.maxVoxels / 4;
+	UINT64 budgetCutoff = 0;
+	size_t budgetTies = 0;
+	if (m_vecVoxels.size() > keepBudget)
+	{
+		const size_t excess = m_vecVoxels.size() - keepBudget;
+
+		m_vecScratch.clear();
+		for (const Voxel& voxel : m_vecVoxels) { m_vecScratch.push_back(voxel.lastSeen); }
+
+		auto last = m_vecScratch.begin() + (excess - 1);
+		std::nth_element(m_vecScratch.begin(), last, m_vecScratch.end());
+		budgetCutoff = *last;
+		budgetTies = excess - std::count_if(m_vecScratch.begin(), last, [budgetCutoff](UINT64 t) { return t < budgetCutoff; });
+	}
+
+	const float maxDistanceSq = m_settings.maxDistance * m_settings.maxDistance;
+
+	// Voxels age out a few at a time, almost every frame: each one is removed in place (the last voxel is examined next
+	// in its index), so the cost follows the evicted voxels instead of rehashing every voxel
+	size_t i = 0;
+	while (i < m_vecVoxels.size())
+	{
+		const Voxel& voxel = m_vecVoxels[i];
+		float dx = voxel.mean.x - sensorPosition.x;
+		float dy = voxel.mean.y - sensorPosition.y;
+		float dz = voxel.mean.z - sensorPosition.z;
+
+		bool isEvicted = voxel.lastSeen < ageCutoff || voxel.lastSeen < budgetCutoff || dx * dx + dy * dy + dz * dz > maxDistanceSq;
+		if (!isEvicted && voxel.lastSeen == budgetCutoff && budgetTies > 0)
+		{
+			budgetTies--;
+			isEvicted = true;
+		}
+
+		if (isEvicted) { removeVoxel(static_cast<UINT32>(i)); }
+		else { i++; }
+	}
+}
+
+void PointAccumulator::removeVoxel(UINT32 index)
+{
+	eraseSlot(findSlot(m_vecVoxels[index].key));
+
+	// The last voxel takes the index
+	const UINT32 last = static_cast<UINT32>(m_vecVoxels.size() - 1);
+	if (index != last)
+	{
+		m_vecVoxels[index] = m_vecVoxels[last];
+		m_vecSlots[findSlot(m_vecVoxels[index].key)] = index;
+	}
+	m_vecVoxels.pop_back();
+}
+
+void PointAccumulator::eraseSlot(size_t slot)
+{
+	// Backward-shift deletion: the following entries of the probe run move into the hole if it lies between
+	// their home slot and their slot, so that every key stays reachable without tombstones
+	const size_t mask = m_vecSlots.size() - 1;
+	size_t hole = slot;
+	for (size_t pos = (slot + 1) & mask; m_vecSlots[pos] != EMPTY_SLOT; pos = (pos + 1) & mask)
+	{
+		const size_t home = homeSlot(m_vecVoxels[m_vecSlots[pos]].key);
+		if (((pos - home) & mask) >= ((pos - hole) & mask))
+		{
+			m_vecSlots[hole] = m_vecSlots[pos];
+			hole = pos;
+		}
+	}
+	m_vecSlots[hole] = EMPTY_SLOT;
+}
+
+size_t PointAccumulator::extract(DirectX::XMFLOAT3* pOut) const
+{
+	for (size_t i = 0; i < m_vecVoxels.size(); i++) {
+		pOut[i] = m_vecVoxels[i].mean;
+	}
+	return m_vecVoxels.size();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef _POINT_ACCUMULATOR_H_
+#define _POINT_ACCUMULATOR_H_
+
+namespace HolographicFindSurfaceDemo
+{
+	// Rolling multi-frame point accumulation in world space.
+	// Frames are transformed into the world (stationary) coordinate system and merged into a spatial hash of voxels,
+	// each voxel keeps the running average of the points that fell into it. Voxels that have not been observed
+	// for a while, or that are far from the sensor, are evicted and the number of voxels is bounded.
+	// Not thread safe.
+	class PointAccumulator
+	{
+	public:
+		struct Settings
+		{
+			float  voxelSize = 0.02f;       // Voxel edge length (meter)
+			UINT32 maxVoxels = 150000;      // Memory bound
+			UINT32 maxSamples = 16;         // Running average window (older samples fade out once reached)
+			float  maxDistance = 4.0f;      // Evict voxels farther than this from the sensor (meter)
+			UINT64 maxAgeTicks = 5 * 10'000'000ull; // Evict voxels not observed for this long (HostTicks, 100 ns)
+		};
+
+	private:
+		struct Voxel
+		{
+			UINT64 key;
+			DirectX::XMFLOAT3 mean;
+			UINT32 samples;
+			UINT64 lastSeen;  // HostTicks
+		};
+
+		static constexpr UINT32 EMPTY_SLOT = 0xFFFFFFFF;
+
+		Settings m_settings;
+		std::vector<Voxel> m_vecVoxels;   // dense, unordered
+		std::vector<UINT32> m_vecSlots;   // open addressing (voxel key -> index into m_vecVoxels)
+		int m_nHashShift = 64;
+		std::vector<UINT64> m_vecScratch; // eviction
+
+	public:
+		PointAccumulator() { setSettings(Settings()); }
+
+		// Clears the accumulated voxels. Throws std::invalid_argument on invalid settings.
+		void setSettings(const Settings& settings);
+		// Throws std::invalid_argument on settings that setSettings() rejects.
+		static void ValidateSettings(const Settings& settings);
+		inline const Settings& settings() const { return m_settings; }
+
+		void clear();
+		inline size_t voxelCount() const { return m_vecVoxels.size(); }
+
+		// Merges camera space points observed at `hostTicks`. `cameraToWorld` follows the DirectXMath (row vector) convention.
+		void integrate(const DirectX::XMFLOAT3* pPoints, size_t count, const DirectX::XMFLOAT4X4& cameraToWorld, UINT64 hostTicks);
+
+		// Writes the voxel means into `pOut` (room for voxelCount() points) and returns their number.
+		size_t extract(_Out_writes_to_(voxelCount(), return) DirectX::XMFLOAT3* pOut) const;
+
+	private:
+		UINT64 voxelKey(const DirectX::XMFLOAT3& pt) const;
+		size_t homeSlot(UINT64 key) const;
+		UINT32 findSlot(UINT64 key) const;
+		void evict(const DirectX::XMFLOAT3& sensorPosition, UINT64 hostTicks);
+		void removeVoxel(UINT32 index); // swaps the last voxel into `index`
+		void eraseSlot(size_t slot);
+	};
+};
+
+#endif
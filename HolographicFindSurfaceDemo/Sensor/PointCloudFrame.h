@@ -0,0 +1,140 @@
+#pragma once
+
+#ifndef _POINT_CLOUD_FRAME_H_
+#define _POINT_CLOUD_FRAME_H_
+
+#include "DepthUnprojection.h"
+#include "ImageSpacePicker.h"
+#include "LazyUnprojection.h"
+#include "PointGridIndex.h"
+#include "PointProbe.h"
+#include "PointQuantization.h"
+
+#include <atomic>
+
+namespace HolographicFindSurfaceDemo
+{
+	class PointCloudFramePool;
+
+	// Allocator that default-initializes (i.e. leaves uninitialized) trivially constructible elements on resize(),
+	// so that a recycled buffer can be resized to the full frame without clearing it.
+	template <typename T>
+	struct DefaultInitAllocator : public std::allocator<T>
+	{
+		template <typename U> struct rebind { typedef DefaultInitAllocator<U> other; };
+
+		DefaultInitAllocator() noexcept = default;
+		template <typename U> DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+		template <typename U> void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) { ::new(static_cast<void*>(p)) U; }
+		template <typename U, typename... Args> void construct(U* p, Args&&... args) { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+	};
+
+	// Unprojected depth frame handed from SensorManager to its consumer.
+	// Frames live in a PointCloudFramePool and are shared through PointCloudFrameRef.
+	struct PointCloudFrame
+	{
+		typedef std::vector< DirectX::XMFLOAT3, DefaultInitAllocator<DirectX::XMFLOAT3> > PointBuffer;
+		typedef std::vector< QuantizedPoint, DefaultInitAllocator<QuantizedPoint> > QuantizedPointBuffer;
+		typedef std::vector< float, DefaultInitAllocator<float> > CoordinateBuffer;
+
+		PointBuffer points;        // Camera space points (meter), empty if the frame is quantized
+		QuantizedPointBuffer quantizedPoints; // Camera space points (millimeter) if isQuantized (see SensorManager::setQuantized())
+		bool isQuantized = false;
+		long long timestamp = 0;   // HostTicks of the depth frame
+		bool isWorldSpace = false; // true if `points` are accumulated in SensorManager's accumulation coordinate system
+		bool hasRigPose = false;   // true if the depth frame carried a recorded rig pose
+		DirectX::XMFLOAT4X4 rigPose; // RigNode to recording coordinate system
+
+		// Organized mode (see SensorManager::setOrganized()), width == 0 otherwise.
+		// `points` stays packed, the pixel grid is kept by the maps below.
+		UINT32 width = 0;
+		UINT32 height = 0;
+		std::vector< BYTE, DefaultInitAllocator<BYTE> > validMask;      // bit (i & 7) of byte (i >> 3) is set if pixel i has a point
+		std::vector< UINT32, DefaultInitAllocator<UINT32> > pixelToIndex; // index into `points` of pixel i, or INVALID_POINT_INDEX
+		std::shared_ptr<const DepthImageProjection> imageProjection; // nullptr if points left the ray of their pixel (motion compensation)
+
+		inline bool isOrganized() const { return width > 0; }
+		inline bool isValid(UINT32 u, UINT32 v) const {
+			const size_t i = static_cast<size_t>(v) * width + u;
+			return (validMask[i >> 3] >> (i & 7)) & 1;
+		}
+		// Index into `points` of pixel (u, v), or INVALID_POINT_INDEX. (u, v) must lie inside the grid.
+		inline UINT32 indexAt(UINT32 u, UINT32 v) const { return pixelToIndex[static_cast<size_t>(v) * width + u]; }
+
+		// Lazy mode (see SensorManager::setLazyUnprojection()), `points` stays empty and regions are unprojected on demand.
+		LazyDepthImage lazyDepth;
+
+		inline bool isLazy() const { return !lazyDepth.empty(); }
+
+		// Spatial index of `points` (see SensorManager::setSpatialIndex()), empty otherwise.
+		PointGridIndex gridIndex;
+
+		// Structure of arrays copy of the (dequantized) points for PickPointSoA() (see SensorManager::setStructureOfArrays()).
+		CoordinateBuffer pointsX;
+		CoordinateBuffer pointsY;
+		CoordinateBuffer pointsZ;
+		bool hasPointsSoA = false;
+
+		inline size_t pointCount() const { return isQuantized ? quantizedPoints.size() : points.size(); }
+		// Point i (meter) of either buffer
+		inline DirectX::XMFLOAT3 pointAt(size_t i) const { return isQuantized ? DequantizePoint(quantizedPoints[i]) : points[i]; }
+
+	private:
+		friend class PointCloudFramePool;
+		friend class PointCloudFrameRef;
+
+		PointCloudFramePool* m_pPool = nullptr;
+		uint32_t m_nSlot = 0;
+		std::atomic<int> m_nRefCount{ 0 };
+	};
+
+	// Reference counted handle of a pooled PointCloudFrame.
+	// The frame returns to its pool when the last reference is released.
+	class PointCloudFrameRef
+	{
+	private:
+		PointCloudFrame* m_pFrame = nullptr;
+
+	public:
+		PointCloudFrameRef() = default;
+		explicit PointCloudFrameRef(PointCloudFrame* pFrame) : m_pFrame(pFrame) { addRef(); } // used by PointCloudFramePool
+		PointCloudFrameRef(const PointCloudFrameRef& other) : m_pFrame(other.m_pFrame) { addRef(); }
+		PointCloudFrameRef(PointCloudFrameRef&& other) noexcept : m_pFrame(other.m_pFrame) { other.m_pFrame = nullptr; }
+		~PointCloudFrameRef() { reset(); }
+
+		PointCloudFrameRef& operator=(const PointCloudFrameRef& other)
+		{
+			if (m_pFrame != other.m_pFrame)
+			{
+				reset();
+				m_pFrame = other.m_pFrame;
+				addRef();
+			}
+			return *this;
+		}
+
+		PointCloudFrameRef& operator=(PointCloudFrameRef&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_pFrame = other.m_pFrame;
+				other.m_pFrame = nullptr;
+			}
+			return *this;
+		}
+
+		void reset();
+
+		inline PointCloudFrame* get() const { return m_pFrame; }
+		inline PointCloudFrame* operator->() const { return m_pFrame; }
+		inline PointCloudFrame& operator*() const { return *m_pFrame; }
+		inline explicit operator bool() const { return m_pFrame != nullptr; }
+
+	private:
+		inline void addRef() { if (m_pFrame) { m_pFrame->m_nRefCount.fetch_add(1, std::memory_order_relaxed); } }
+	};
+};
+
+#endif
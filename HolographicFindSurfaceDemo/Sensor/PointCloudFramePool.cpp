@@ -0,0 +1,97 @@
+#include "pch.h"
+#include "PointCloudFramePool.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+static inline uint32_t _popCount(uint32_t v)
+{
+	uint32_t count = 0;
+	for (; v; v &= v - 1) { count++; }
+	return count;
+}
+
+static inline uint32_t _lowestBitIndex(uint32_t v)
+{
+	uint32_t index = 0;
+	while ((v & 1) == 0) { v >>= 1; index++; }
+	return index;
+}
+
+void PointCloudFrameRef::reset()
+{
+	if (m_pFrame)
+	{
+		if (m_pFrame->m_nRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			m_pFrame->m_pPool->recycle(m_pFrame);
+		}
+		m_pFrame = nullptr;
+	}
+}
+
+PointCloudFramePool::PointCloudFramePool(uint32_t poolSize)
+	: m_pFrames(new PointCloudFrame[poolSize]), m_nPoolSize(poolSize), m_nFreeMask(0)
+{
+	if (poolSize < 1 || poolSize > MAX_POOL_SIZE) {
+		throw std::invalid_argument("PointCloudFramePool: pool size must be in [1, 32]");
+	}
+
+	for (uint32_t i = 0; i < poolSize; i++)
+	{
+		m_pFrames[i].m_pPool = this;
+		m_pFrames[i].m_nSlot = i;
+	}
+	m_nFreeMask.store(poolSize == 32 ? 0xFFFFFFFFu : ((1u << poolSize) - 1), std::memory_order_release);
+}
+
+PointCloudFrameRef PointCloudFramePool::acquire(size_t capacity)
+{
+	uint32_t freeMask = m_nFreeMask.load(std::memory_order_acquire);
+	uint32_t slot;
+	do
+	{
+		if (freeMask == 0)
+		{
+			m_nExhaustedCount.fetch_add(1, std::memory_order_relaxed);
+			return PointCloudFrameRef();
+		}
+		slot = _lowestBitIndex(freeMask);
+	} while (!m_nFreeMask.compare_exchange_weak(freeMask, freeMask & ~(1u << slot), std::memory_order_acq_rel, std::memory_order_acquire));
+
+	m_nAcquireCount.fetch_add(1, std::memory_order_relaxed);
+
+	uint32_t inUse = m_nPoolSize - _popCount(freeMask & ~(1u << slot));
+	uint32_t peak = m_nPeakInUseCount.load(std::memory_order_relaxed);
+	while (inUse > peak && !m_nPeakInUseCount.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {}
+
+	PointCloudFrame* pFrame = &m_pFrames[slot];
+	pFrame->points.reserve(capacity); // no-op once the buffer has grown to frame size
+	pFrame->points.clear();
+	pFrame->quantizedPoints.clear();
+	pFrame->isQuantized = false;
+	pFrame->lazyDepth.reset();
+	pFrame->gridIndex.reset();
+	pFrame->hasPointsSoA = false;
+	pFrame->timestamp = 0;
+	pFrame->hasRigPose = false;
+	pFrame->isWorldSpace = false;
+	pFrame->width = 0;
+	pFrame->height = 0;
+	pFrame->imageProjection.reset();
+
+	return PointCloudFrameRef(pFrame);
+}
+
+void PointCloudFramePool::recycle(PointCloudFrame* pFrame)
+{
+	m_nFreeMask.fetch_or(1u << pFrame->m_nSlot, std::memory_order_acq_rel);
+}
+
+PointCloudFramePool::Statistics PointCloudFramePool::getStatistics() const
+{
+	Statistics stat;
+	stat.acquireCount = m_nAcquireCount.load(std::memory_order_relaxed);
+	stat.exhaustedCount = m_nExhaustedCount.load(std::memory_order_relaxed);
+	stat.inUseCount = m_nPoolSize - _popCount(m_nFreeMask.load(std::memory_order_relaxed));
+	stat.peakInUseCount = m_nPeakInUseCount.load(std::memory_order_relaxed);
+	return stat;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef _POINT_CLOUD_FRAME_POOL_H_
+#define _POINT_CLOUD_FRAME_POOL_H_
+
+#include "PointCloudFrame.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Fixed set of point cloud frames recycled between the sensor thread and its consumers.
+	// acquire() and release are lock-free and never allocate frames; the point buffer of a frame
+	// keeps its capacity across recycling, so it is allocated at most once per frame (and resolution).
+	class PointCloudFramePool
+	{
+	public:
+		static constexpr uint32_t MAX_POOL_SIZE = 32;
+
+		struct Statistics
+		{
+			uint64_t acquireCount;   // successful acquire()
+			uint64_t exhaustedCount; // acquire() failed because every frame was in use
+			uint32_t inUseCount;     // frames currently referenced
+			uint32_t peakInUseCount; // highest inUseCount so far
+		};
+
+	private:
+		std::unique_ptr<PointCloudFrame[]> m_pFrames;
+		uint32_t m_nPoolSize;
+		std::atomic<uint32_t> m_nFreeMask; // bit i set: frame i is free
+
+		std::atomic<uint64_t> m_nAcquireCount{ 0 };
+		std::atomic<uint64_t> m_nExhaustedCount{ 0 };
+		std::atomic<uint32_t> m_nPeakInUseCount{ 0 };
+
+	public:
+		explicit PointCloudFramePool(uint32_t poolSize);
+		PointCloudFramePool(const PointCloudFramePool&) = delete;
+		PointCloudFramePool& operator=(const PointCloudFramePool&) = delete;
+
+		// Returns a free frame whose point buffer can hold at least `capacity` points,
+		// or an empty reference if the pool is exhausted.
+		PointCloudFrameRef acquire(size_t capacity);
+
+		Statistics getStatistics() const;
+		inline uint32_t size() const { return m_nPoolSize; }
+
+	private:
+		friend class PointCloudFrameRef;
+		void recycle(PointCloudFrame* pFrame);
+	};
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "pch.h"
+#include "PointGridIndex.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Probe of pickPoint() (Helper.h), _probe() repeats its arithmetic operation by operation
+static constexpr float PROBE_RADIUS_ON_METER = 0.015f; // 1.5 cm
+static constexpr float PR_SQ_PLUS_ONE = 1.0f + (PROBE_RADIUS_ON_METER * PROBE_RADIUS_ON_METER);
+
+// Slack of every cell bound: float rounding, and points decoded from int16 millimeter (see PointQuantization.h)
+static constexpr float CELL_MARGIN = 0.002f;
+
+struct _PickState
+{
+	float minLen = FLT_MAX;  // inside the probe: squared distance to the ray
+	int pickIdx = -1;
+	float maxCos = -FLT_MAX; // outside the probe: cosine to the ray
+	int pickIdxExt = -1;
+};
+
+static inline XMVECTOR _loadPoint(const XMFLOAT3& point) { return XMLoadFloat3(&point); }
+static inline XMVECTOR _loadPoint(const QuantizedPoint& point) { return LoadQuantizedPoint(point); }
+static inline XMFLOAT3 _pointAt(const XMFLOAT3& point) { return point; }
+static inline XMFLOAT3 _pointAt(const QuantizedPoint& point) { return DequantizePoint(point); }
+
+// Ties go to the lower index, as in the sequential scan of pickPoint()
+template <typename TPoint>
+static inline void _probe(_PickState& state, const TPoint* pPoints, UINT32 index, FXMVECTOR pos, FXMVECTOR dir, bool outside)
+{
+	XMVECTOR v = _loadPoint(pPoints[index]);
+	v = XMVectorSubtract(v, pos);
+
+	float len1 = XMVectorGetX(XMVector3Dot(v, dir));
+	if (len1 < FLT_EPSILON) { return; }
+
+	v = XMVector3LengthSq(v);
+
+	float len1Sq = len1 * len1;
+	float distSq = XMVectorGetX(v);
+	const int i = static_cast<int>(index);
+	if (distSq < (PR_SQ_PLUS_ONE * len1Sq))
+	{
+		float len2Sq = distSq - len1Sq;
+		if (len2Sq < state.minLen || (len2Sq == state.minLen && i < state.pickIdx)) {
+			state.minLen = len2Sq;
+			state.pickIdx = i;
+		}
+	}
+	else if (outside)
+	{
+		v = XMVectorSqrt(v);
+		float c = len1 / XMVectorGetX(v);
+		if (c > state.maxCos || (c == state.maxCos && i < state.pickIdxExt)) {
+			state.maxCos = c;
+			state.pickIdxExt = i;
+		}
+	}
+}
+
+void PointGridIndex::build(const XMFLOAT3* pPoints, size_t count, float cellSize)
+{
+	buildPoints(pPoints, count, cellSize);
+}
+
+void PointGridIndex::build(const QuantizedPoint* pPoints, size_t count, float cellSize)
+{
+	buildPoints(pPoints, count, cellSize);
+}
+
+template <typename TPoint>
+void PointGridIndex::buildPoints(const TPoint* pPoints, size_t count, float cellSize)
+{
+	if (!(cellSize > 0.0f)) {
+		throw std::invalid_argument("PointGridIndex::build(): cellSize must be positive");
+	}
+
+	reset();
+	if (count < 1) { return; }
+
+	XMVECTOR lo = _loadPoint(pPoints[0]);
+	XMVECTOR hi = lo;
+	for (size_t i = 1; i < count; i++)
+	{
+		XMVECTOR v = _loadPoint(pPoints[i]);
+		lo = XMVectorMin(lo, v);
+		hi = XMVectorMax(hi, v);
+	}
+
+	XMFLOAT3 extent;
+	XMStoreFloat3(&m_origin, lo);
+	XMStoreFloat3(&extent, XMVectorSubtract(hi, lo));
+
+	// Grow cells until the grid fits MAX_CELL_COUNT
+	for (;;)
+	{
+		m_nDim[0] = static_cast<UINT32>(extent.x / cellSize) + 1;
+		m_nDim[1] = static_cast<UINT32>(extent.y / cellSize) + 1;
+		m_nDim[2] = static_cast<UINT32>(extent.z / cellSize) + 1;
+		if (static_cast<double>(m_nDim[0]) * m_nDim[1] * m_nDim[2] <= MAX_CELL_COUNT) { break; }
+		cellSize *= 1.25f;
+	}
+	m_fCellSize = cellSize;
+
+	const UINT32 cellCount = m_nDim[0] * m_nDim[1] * m_nDim[2];
+	const float invCellSize = 1.0f / cellSize;
+
+	// Counting sort: m_vecCellStart[c] counts, then ends, then (scattering backwards) begins of cell c
+	m_vecCellOfPoint.resize(count);
+	m_vecCellStart.assign(static_cast<size_t>(cellCount) + 1, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		const XMFLOAT3 p = _pointAt(pPoints[i]);
+		const UINT32 x = (std::min)(m_nDim[0] - 1, static_cast<UINT32>((p.x - m_origin.x) * invCellSize));
+		const UINT32 y = (std::min)(m_nDim[1] - 1, static_cast<UINT32>((p.y - m_origin.y) * invCellSize));
+		const UINT32 z = (std::min)(m_nDim[2] - 1, static_cast<UINT32>((p.z - m_origin.z) * invCellSize));
+		const UINT32 cell = cellIndex(x, y, z);
+
+		m_vecCellOfPoint[i] = cell;
+		m_vecCellStart[cell]++;
+	}
+
+	UINT32 end = 0;
+	for (UINT32 c = 0; c < cellCount; c++)
+	{
+		if (m_vecCellStart[c] > 0) { m_vecOccupied.push_back(c); }
+		end += m_vecCellStart[c];
+		m_vecCellStart[c] = end;
+	}
+	m_vecCellStart[cellCount] = end;
+
+	m_vecIndices.resize(count);
+	for (size_t i = count; i-- > 0;) {
+		m_vecIndices[--m_vecCellStart[m_vecCellOfPoint[i]]] = static_cast<UINT32>(i);
+	}
+
+	m_nPointCount = count;
+}
+
+bool PointGridIndex::pick(const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const XMFLOAT3* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx) const
+{
+	return pickPoints(gazeOrigin, gazeDirection, pPoints, count, pointCloudModel, pickIdx);
+}
+
+bool PointGridIndex::pick(const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const QuantizedPoint* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx) const
+{
+	return pickPoints(gazeOrigin, gazeDirection, pPoints, count, pointCloudModel, pickIdx);
+}
+
+template <typename TPoint>
+bool PointGridIndex::pickPoints(const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const TPoint* pPoints, size_t count, XMMATRIX pointCloudModel, int& pickIdx) const
+{
+	pickIdx = -1;
+	if (m_nPointCount == 0 || count != m_nPointCount) { return false; }
+
+	// Gaze ray in point cloud coordinates, exactly as pickPoint() computes it
+	XMVECTOR det = XMMatrixDeterminant(pointCloudModel);
+	pointCloudModel = XMMatrixInverse(&det, pointCloudModel);
+
+	const XMVECTOR pos = XMVector3TransformCoord(XMLoadFloat3(&gazeOrigin), pointCloudModel);
+	const XMVECTOR dir = XMVector3TransformNormal(XMLoadFloat3(&gazeDirection), pointCloudModel);
+
+	const float dirLength = XMVectorGetX(XMVector3Length(dir));
+	if (!(dirLength > 0.5f && dirLength < 2.0f)) { return false; }
+
+	const float dirLengthSq = dirLength * dirLength;
+	XMFLOAT3 o, a;
+	XMStoreFloat3(&o, pos);
+	XMStoreFloat3(&a, XMVectorScale(dir, 1.0f / dirLength));
+
+	// Along the unit axis (t), pickPoint() accepts the points inside the cone |perpendicular| < coneTan * t
+	// and prefers the least (|perpendicular|^2 + (1 - |dir|^2) t^2).
+	const float coneTanSq = PR_SQ_PLUS_ONE * dirLengthSq - 1.0f;
+	const float coneTan = coneTanSq > 0.0f ? sqrtf(coneTanSq + 1e-5f) + 1e-4f : 0.0f;
+	const float axisError = fabsf(1.0f - dirLengthSq);
+
+	// Range of t covered by the grid
+	float tMin = FLT_MAX;
+	float tMax = -FLT_MAX;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const float x = m_origin.x + ((corner & 1) ? m_nDim[0] * m_fCellSize : 0.0f) - o.x;
+		const float y = m_origin.y + ((corner & 2) ? m_nDim[1] * m_fCellSize : 0.0f) - o.y;
+		const float z = m_origin.z + ((corner & 4) ? m_nDim[2] * m_fCellSize : 0.0f) - o.z;
+		const float t = x * a.x + y * a.y + z * a.z;
+		tMin = (std::min)(tMin, t);
+		tMax = (std::max)(tMax, t);
+	}
+	tMin = (std::max)(0.0f, tMin - CELL_MARGIN);
+	tMax += CELL_MARGIN;
+
+	_PickState state;
+	const float invCellSize = 1.0f / m_fCellSize;
+
+	// 1. March the cells around the probe cone, narrowing it to the distance of the best point so far
+	if (coneTanSq > 0.0f && tMax > tMin)
+	{
+		int prevLo[3] = { 0, 0, 0 };
+		int prevHi[3] = { -1, -1, -1 }; // empty
+
+		for (float ta = tMin; ta < tMax; ta += m_fCellSize)
+		{
+			const float tb = (std::min)(ta + m_fCellSize, tMax);
+
+			float radius = coneTan * tb;
+			if (state.pickIdx >= 0)
+			{
+				const float bound = state.minLen + axisError * tb * tb + 16.0f * FLT_EPSILON * (tb + radius) * (tb + radius);
+				radius = (std::min)(radius, sqrtf((std::max)(bound, 0.0f)));
+			}
+			radius += CELL_MARGIN;
+
+			int lo[3], hi[3];
+			bool outsideGrid = false;
+			const float pa[3] = { o.x + a.x * ta, o.y + a.y * ta, o.z + a.z * ta };
+			const float pb[3] = { o.x + a.x * tb, o.y + a.y * tb, o.z + a.z * tb };
+			const float origin[3] = { m_origin.x, m_origin.y, m_origin.z };
+			for (int k = 0; k < 3; k++)
+			{
+				const float l = ((std::min)(pa[k], pb[k]) - radius - origin[k]) * invCellSize;
+				const float h = ((std::max)(pa[k], pb[k]) + radius - origin[k]) * invCellSize;
+				if (h < 0.0f || l >= static_cast<float>(m_nDim[k])) { outsideGrid = true; break; }
+				lo[k] = (std::max)(0, static_cast<int>(l));
+				hi[k] = static_cast<int>((std::min)(h, static_cast<float>(m_nDim[k] - 1)));
+			}
+			if (outsideGrid) { continue; }
+
+			for (int z = lo[2]; z <= hi[2]; z++)
+			{
+				for (int y = lo[1]; y <= hi[1]; y++)
+				{
+					for (int x = lo[0]; x <= hi[0]; x++)
+					{
+						// Cells of the previous step are done
+						if (x >= prevLo[0] && x <= prevHi[0] && y >= prevLo[1] && y <= prevHi[1] && z >= prevLo[2] && z <= prevHi[2]) { continue; }
+
+						const UINT32 cell = cellIndex(x, y, z);
+						for (UINT32 j = m_vecCellStart[cell]; j < m_vecCellStart[cell + 1]; j++) {
+							_probe(state, pPoints, m_vecIndices[j], pos, dir, false);
+						}
+					}
+				}
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				prevLo[k] = lo[k];
+				prevHi[k] = hi[k];
+			}
+		}
+	}
+
+	// 2. No point inside the probe: smallest angle to the ray, cells in order of their angle bound
+	if (state.pickIdx < 0)
+	{
+		const float cellRadius = m_fCellSize * 0.8660254f + CELL_MARGIN; // half diagonal
+
+		// (upper bound of the cosine, cell), reused by the next picks of the thread (the render thread, every frame)
+		thread_local std::vector<std::pair<float, UINT32>> order;
+		order.clear();
+		order.reserve(m_vecOccupied.size());
+		for (UINT32 cell : m_vecOccupied)
+		{
+			const UINT32 x = cell % m_nDim[0];
+			const UINT32 y = (cell / m_nDim[0]) % m_nDim[1];
+			const UINT32 z = cell / (m_nDim[0] * m_nDim[1]);
+
+			const float wx = m_origin.x + (x + 0.5f) * m_fCellSize - o.x;
+			const float wy = m_origin.y + (y + 0.5f) * m_fCellSize - o.y;
+			const float wz = m_origin.z + (z + 0.5f) * m_fCellSize - o.z;
+			const float length = sqrtf(wx * wx + wy * wy + wz * wz);
+
+			float bound = FLT_MAX;
+			if (length > cellRadius)
+			{
+				const float angle = acosf((std::max)(-1.0f, (std::min)(1.0f, (wx * a.x + wy * a.y + wz * a.z) / length)));
+				const float minAngle = angle - asinf(cellRadius / length);
+				if (minAngle > 0.0f) {
+					bound = dirLength * cosf(minAngle) + 1e-5f;
+				}
+			}
+			order.emplace_back(bound, cell);
+		}
+		std::sort(order.begin(), order.end(), [](const std::pair<float, UINT32>& l, const std::pair<float, UINT32>& r) { return l.first > r.first; });
+
+		for (const auto& entry : order)
+		{
+			if (entry.first < state.maxCos) { break; }
+
+			for (UINT32 j = m_vecCellStart[entry.second]; j < m_vecCellStart[entry.second + 1]; j++) {
+				_probe(state, pPoints, m_vecIndices[j], pos, dir, true);
+			}
+		}
+	}
+
+	pickIdx = state.pickIdx < 0 ? state.pickIdxExt : state.pickIdx;
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef _POINT_GRID_INDEX_H_
+#define _POINT_GRID_INDEX_H_
+
+#include "PointQuantization.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Uniform grid over a point cloud (counting sort of point indices by cell), for picking without scanning every point.
+	// Built on the sensor thread along with the frame (see SensorManager::setSpatialIndex()), read-only afterwards.
+	class PointGridIndex
+	{
+	public:
+		static constexpr float DEFAULT_CELL_SIZE = 0.05f; // 5 cm
+		static constexpr size_t MAX_CELL_COUNT = 1 << 18; // larger clouds get larger cells
+
+	private:
+		size_t m_nPointCount = 0;
+		float m_fCellSize = DEFAULT_CELL_SIZE;
+		DirectX::XMFLOAT3 m_origin = { 0.0f, 0.0f, 0.0f }; // minimum corner
+		UINT32 m_nDim[3] = { 0, 0, 0 };
+
+		std::vector<UINT32> m_vecCellStart; // points of cell c are m_vecIndices[m_vecCellStart[c] .. m_vecCellStart[c + 1])
+		std::vector<UINT32> m_vecIndices;   // point indices ordered by cell, ascending within a cell
+		std::vector<UINT32> m_vecOccupied;  // non-empty cells
+		std::vector<UINT32> m_vecCellOfPoint; // build scratch
+
+	public:
+		// Indexes `count` points, `cellSize` in meter.
+		void build(const DirectX::XMFLOAT3* pPoints, size_t count, float cellSize = DEFAULT_CELL_SIZE);
+		// Indexes quantized points where they decode to (saturated coordinates included), see DequantizePoints().
+		void build(const QuantizedPoint* pPoints, size_t count, float cellSize = DEFAULT_CELL_SIZE);
+		inline void reset() { m_nPointCount = 0; m_vecOccupied.clear(); }
+		inline bool empty() const { return m_nPointCount == 0; }
+		inline size_t pointCount() const { return m_nPointCount; }
+
+		// Same pick as pickPoint() (Helper.h) over the indexed points, visiting the cells along the gaze ray only.
+		// `pPoints` are the indexed points, or a copy within 1 mm of them (e.g. quantized points decoded as DequantizePoints() does).
+		// Returns false if the index does not apply (count mismatch, degenerate ray), the caller scans instead then.
+		bool pick(
+			const DirectX::XMFLOAT3& gazeOrigin,
+			const DirectX::XMFLOAT3& gazeDirection,
+			const DirectX::XMFLOAT3* pPoints,
+			size_t count,
+			DirectX::XMMATRIX pointCloudModel,
+			_Out_ int& pickIdx
+		) const;
+		// Same as pick() over the quantized copy of the indexed points (PointCloudFrame::quantizedPoints).
+		bool pick(
+			const DirectX::XMFLOAT3& gazeOrigin,
+			const DirectX::XMFLOAT3& gazeDirection,
+			const QuantizedPoint* pPoints,
+			size_t count,
+			DirectX::XMMATRIX pointCloudModel,
+			_Out_ int& pickIdx
+		) const;
+
+	private:
+		inline UINT32 cellIndex(UINT32 x, UINT32 y, UINT32 z) const { return (z * m_nDim[1] + y) * m_nDim[0] + x; }
+
+		template <typename TPoint>
+		void buildPoints(const TPoint* pPoints, size_t count, float cellSize);
+		template <typename TPoint>
+		bool pickPoints(const DirectX::XMFLOAT3& gazeOrigin, const DirectX::XMFLOAT3& gazeDirection, const TPoint* pPoints, size_t count, DirectX::XMMATRIX pointCloudModel, int& pickIdx) const;
+	};
+};
+
+#endif
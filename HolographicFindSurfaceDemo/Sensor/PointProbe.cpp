@@ -0,0 +1,316 @@
+#include "pch.h"
+#include "PointProbe.h"
+
+using namespace HolographicFindSurfaceDemo;
+using namespace DirectX;
+
+// Probe of pickPoint() (Helper.h). Every lane follows the operation order of XMVector3Dot() and XMVector3LengthSq(),
+// ((x * x') + (y * y')) + (z * z'), with separate multiplies and adds (no FMA), so that all paths match it exactly.
+static constexpr float PROBE_RADIUS_ON_METER = 0.015f; // 1.5 cm
+static constexpr float PR_SQ_PLUS_ONE = 1.0f + (PROBE_RADIUS_ON_METER * PROBE_RADIUS_ON_METER);
+
+static constexpr size_t PICK_BLOCK_SIZE = 256; // points per block of the ray batch, 3 KB as coordinate arrays
+
+struct _ProbeState
+{
+	float minLen = FLT_MAX;  // inside the probe: squared distance to the ray
+	int pickIdx = -1;
+	float maxCos = -FLT_MAX; // outside the probe: cosine to the ray
+	int pickIdxExt = -1;
+
+	inline int result() const { return pickIdx < 0 ? pickIdxExt : pickIdx; }
+};
+
+// Per lane _ProbeState of the vector kernel, lane k sees the indices 4n + k of a ray
+struct _LaneState
+{
+	alignas(16) float minLen[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+	alignas(16) int pickIdx[4] = { -1, -1, -1, -1 };
+	alignas(16) float maxCos[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	alignas(16) int pickIdxExt[4] = { -1, -1, -1, -1 };
+};
+
+// Points [0, count) of a block starting at index `base`, in index order, continuing `state`
+static inline void _probeScalar(_ProbeState& state, const float* pX, const float* pY, const float* pZ, size_t count, size_t base, const XMFLOAT3& pos, const XMFLOAT3& dir)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float vx = pX[i] - pos.x, vy = pY[i] - pos.y, vz = pZ[i] - pos.z;
+
+		float len1 = ((vx * dir.x) + (vy * dir.y)) + (vz * dir.z);
+		if (len1 < FLT_EPSILON) { continue; }
+
+		float len1Sq = len1 * len1;
+		float distSq = ((vx * vx) + (vy * vy)) + (vz * vz);
+		if (distSq < (PR_SQ_PLUS_ONE * len1Sq))
+		{
+			float len2Sq = distSq - len1Sq;
+			if (len2Sq < state.minLen) {
+				state.minLen = len2Sq;
+				state.pickIdx = static_cast<int>(base + i);
+			}
+		}
+		else
+		{
+			float c = len1 / sqrtf(distSq);
+			if (c > state.maxCos) {
+				state.maxCos = c;
+				state.pickIdxExt = static_cast<int>(base + i);
+			}
+		}
+	}
+}
+
+// Lane results to `state`, the lower index wins ties as in the sequential scan
+static inline void _reduceLanes(_ProbeState& state, const _LaneState& lanes)
+{
+	for (int k = 0; k < 4; k++)
+	{
+		if (lanes.pickIdx[k] >= 0 && (lanes.minLen[k] < state.minLen || (lanes.minLen[k] == state.minLen && lanes.pickIdx[k] < state.pickIdx))) {
+			state.minLen = lanes.minLen[k];
+			state.pickIdx = lanes.pickIdx[k];
+		}
+		if (lanes.pickIdxExt[k] >= 0 && (lanes.maxCos[k] > state.maxCos || (lanes.maxCos[k] == state.maxCos && lanes.pickIdxExt[k] < state.pickIdxExt))) {
+			state.maxCos = lanes.maxCos[k];
+			state.pickIdxExt = lanes.pickIdxExt[k];
+		}
+	}
+}
+
+#if defined(_XM_SSE_INTRINSICS_)
+
+// Leading multiple of 4 points of a block starting at index `base`, returns the number of points probed
+static size_t _probeVector(_LaneState& lanes, const float* pX, const float* pY, const float* pZ, size_t count, size_t base, const XMFLOAT3& pos, const XMFLOAT3& dir)
+{
+	const __m128 posX = _mm_set1_ps(pos.x), posY = _mm_set1_ps(pos.y), posZ = _mm_set1_ps(pos.z);
+	const __m128 dirX = _mm_set1_ps(dir.x), dirY = _mm_set1_ps(dir.y), dirZ = _mm_set1_ps(dir.z);
+	const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+	const __m128 probe = _mm_set1_ps(PR_SQ_PLUS_ONE);
+	const __m128i four = _mm_set1_epi32(4);
+
+	__m128 minLen = _mm_load_ps(lanes.minLen);
+	__m128i pickIdx = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes.pickIdx));
+	__m128 maxCos = _mm_load_ps(lanes.maxCos);
+	__m128i pickIdxExt = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes.pickIdxExt));
+	__m128i index = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(base)), _mm_setr_epi32(0, 1, 2, 3));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, index = _mm_add_epi32(index, four))
+	{
+		const __m128 vx = _mm_sub_ps(_mm_loadu_ps(pX + i), posX);
+		const __m128 vy = _mm_sub_ps(_mm_loadu_ps(pY + i), posY);
+		const __m128 vz = _mm_sub_ps(_mm_loadu_ps(pZ + i), posZ);
+
+		const __m128 len1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dirX), _mm_mul_ps(vy, dirY)), _mm_mul_ps(vz, dirZ));
+		const __m128 len1Sq = _mm_mul_ps(len1, len1);
+		const __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+
+		// !(len1 < FLT_EPSILON) keeps NaN lanes, which then fail every comparison below as in pickPoint()
+		const __m128 front = _mm_cmpnlt_ps(len1, epsilon);
+		const __m128 inside = _mm_cmplt_ps(distSq, _mm_mul_ps(probe, len1Sq));
+
+		// Inside the probe radius: least squared distance to the ray
+		const __m128 len2Sq = _mm_sub_ps(distSq, len1Sq);
+		const __m128 better = _mm_and_ps(_mm_and_ps(front, inside), _mm_cmplt_ps(len2Sq, minLen));
+		minLen = _mm_or_ps(_mm_and_ps(better, len2Sq), _mm_andnot_ps(better, minLen));
+		pickIdx = _mm_or_si128(_mm_and_si128(_mm_castps_si128(better), index), _mm_andnot_si128(_mm_castps_si128(better), pickIdx));
+
+		// Outside: largest cosine to the ray
+		const __m128 c = _mm_div_ps(len1, _mm_sqrt_ps(distSq));
+		const __m128 betterExt = _mm_and_ps(_mm_andnot_ps(inside, front), _mm_cmpgt_ps(c, maxCos));
+		maxCos = _mm_or_ps(_mm_and_ps(betterExt, c), _mm_andnot_ps(betterExt, maxCos));
+		pickIdxExt = _mm_or_si128(_mm_and_si128(_mm_castps_si128(betterExt), index), _mm_andnot_si128(_mm_castps_si128(betterExt), pickIdxExt));
+	}
+
+	_mm_store_ps(lanes.minLen, minLen);
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes.pickIdx), pickIdx);
+	_mm_store_ps(lanes.maxCos, maxCos);
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes.pickIdxExt), pickIdxExt);
+
+	return i;
+}
+
+#elif defined(_XM_ARM_NEON_INTRINSICS_) && (defined(_M_ARM64) || defined(__aarch64__))
+
+// Leading multiple of 4 points of a block starting at index `base`, returns the number of points probed
+static size_t _probeVector(_LaneState& lanes, const float* pX, const float* pY, const float* pZ, size_t count, size_t base, const XMFLOAT3& pos, const XMFLOAT3& dir)
+{
+	static const int32_t LANE_INDEX[4] = { 0, 1, 2, 3 };
+
+	const float32x4_t posX = vdupq_n_f32(pos.x), posY = vdupq_n_f32(pos.y), posZ = vdupq_n_f32(pos.z);
+	const float32x4_t dirX = vdupq_n_f32(dir.x), dirY = vdupq_n_f32(dir.y), dirZ = vdupq_n_f32(dir.z);
+	const float32x4_t epsilon = vdupq_n_f32(FLT_EPSILON);
+	const float32x4_t probe = vdupq_n_f32(PR_SQ_PLUS_ONE);
+	const int32x4_t four = vdupq_n_s32(4);
+
+	float32x4_t minLen = vld1q_f32(lanes.minLen);
+	int32x4_t pickIdx = vld1q_s32(lanes.pickIdx);
+	float32x4_t maxCos = vld1q_f32(lanes.maxCos);
+	int32x4_t pickIdxExt = vld1q_s32(lanes.pickIdxExt);
+	int32x4_t index = vaddq_s32(vdupq_n_s32(static_cast<int32_t>(base)), vld1q_s32(LANE_INDEX));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, index = vaddq_s32(index, four))
+	{
+		const float32x4_t vx = vsubq_f32(vld1q_f32(pX + i), posX);
+		const float32x4_t vy = vsubq_f32(vld1q_f32(pY + i), posY);
+		const float32x4_t vz = vsubq_f32(vld1q_f32(pZ + i), posZ);
+
+		// vmulq + vaddq (not vmlaq / vfmaq), see above
+		const float32x4_t len1 = vaddq_f32(vaddq_f32(vmulq_f32(vx, dirX), vmulq_f32(vy, dirY)), vmulq_f32(vz, dirZ));
+		const float32x4_t len1Sq = vmulq_f32(len1, len1);
+		const float32x4_t distSq = vaddq_f32(vaddq_f32(vmulq_f32(vx, vx), vmulq_f32(vy, vy)), vmulq_f32(vz, vz));
+
+		// !(len1 < FLT_EPSILON) keeps NaN lanes, which then fail every comparison below as in pickPoint()
+		const uint32x4_t front = vmvnq_u32(vcltq_f32(len1, epsilon));
+		const uint32x4_t inside = vcltq_f32(distSq, vmulq_f32(probe, len1Sq));
+
+		// Inside the probe radius: least squared distance to the ray
+		const float32x4_t len2Sq = vsubq_f32(distSq, len1Sq);
+		const uint32x4_t better = vandq_u32(vandq_u32(front, inside), vcltq_f32(len2Sq, minLen));
+		minLen = vbslq_f32(better, len2Sq, minLen);
+		pickIdx = vbslq_s32(better, index, pickIdx);
+
+		// Outside: largest cosine to the ray
+		const float32x4_t c = vdivq_f32(len1, vsqrtq_f32(distSq));
+		const uint32x4_t betterExt = vandq_u32(vbicq_u32(front, inside), vcgtq_f32(c, maxCos));
+		maxCos = vbslq_f32(betterExt, c, maxCos);
+		pickIdxExt = vbslq_s32(betterExt, index, pickIdxExt);
+	}
+
+	vst1q_f32(lanes.minLen, minLen);
+	vst1q_s32(lanes.pickIdx, pickIdx);
+	vst1q_f32(lanes.maxCos, maxCos);
+	vst1q_s32(lanes.pickIdxExt, pickIdxExt);
+
+	return i;
+}
+
+#else // _XM_NO_INTRINSICS_, 32 bit ARM (no vector division)
+
+static size_t _probeVector(_LaneState&, const float*, const float*, const float*, size_t, size_t, const XMFLOAT3&, const XMFLOAT3&)
+{
+	return 0;
+}
+
+#endif
+
+// Gaze rays in point cloud coordinates, exactly as pickPoint() computes them
+static void _raysToPointCloud(XMFLOAT3* pPos, XMFLOAT3* pDir, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount, XMMATRIX pointCloudModel)
+{
+	XMVECTOR det = XMMatrixDeterminant(pointCloudModel);
+	pointCloudModel = XMMatrixInverse(&det, pointCloudModel);
+
+	for (size_t k = 0; k < rayCount; k++)
+	{
+		XMStoreFloat3(&pPos[k], XMVector3TransformCoord(XMLoadFloat3(&pOrigins[k]), pointCloudModel));
+		XMStoreFloat3(&pDir[k], XMVector3TransformNormal(XMLoadFloat3(&pDirections[k]), pointCloudModel));
+	}
+}
+
+// One pass over the points in blocks of PICK_BLOCK_SIZE, every ray probes a block while it is in the L1 cache.
+// `fetch(begin, count, pX, pY, pZ)` returns the coordinate arrays of points [begin, begin + count).
+template <typename FetchBlock>
+static void _pickRays(int* pPickIdx, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount, size_t count, XMMATRIX pointCloudModel, FetchBlock&& fetch)
+{
+	if (rayCount > MAX_PICK_RAY_COUNT) {
+		throw std::invalid_argument("PickPoints(): too many rays");
+	}
+
+	XMFLOAT3 pos[MAX_PICK_RAY_COUNT], dir[MAX_PICK_RAY_COUNT];
+	_raysToPointCloud(pos, dir, pOrigins, pDirections, rayCount, pointCloudModel);
+
+	_LaneState lanes[MAX_PICK_RAY_COUNT];
+	_ProbeState tails[MAX_PICK_RAY_COUNT]; // points after the last multiple of 4, in index order
+
+	for (size_t begin = 0; begin < count; begin += PICK_BLOCK_SIZE)
+	{
+		const size_t blockCount = (std::min)(PICK_BLOCK_SIZE, count - begin);
+
+		const float* pX;
+		const float* pY;
+		const float* pZ;
+		fetch(begin, blockCount, pX, pY, pZ);
+
+		for (size_t k = 0; k < rayCount; k++)
+		{
+			const size_t n = _probeVector(lanes[k], pX, pY, pZ, blockCount, begin, pos[k], dir[k]);
+			_probeScalar(tails[k], pX + n, pY + n, pZ + n, blockCount - n, begin + n, pos[k], dir[k]);
+		}
+	}
+
+	for (size_t k = 0; k < rayCount; k++)
+	{
+		_reduceLanes(tails[k], lanes[k]);
+		pPickIdx[k] = tails[k].result();
+	}
+}
+
+void HolographicFindSurfaceDemo::SplitPoints(float* pX, float* pY, float* pZ, const XMFLOAT3* pIn, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		pX[i] = pIn[i].x;
+		pY[i] = pIn[i].y;
+		pZ[i] = pIn[i].z;
+	}
+}
+
+void HolographicFindSurfaceDemo::SplitPoints(float* pX, float* pY, float* pZ, const QuantizedPoint* pIn, size_t count)
+{
+	// Same conversion as DequantizePoints()
+	for (size_t i = 0; i < count; i++)
+	{
+		pX[i] = static_cast<float>(pIn[i].x) * POINT_DEQUANTIZATION_SCALE;
+		pY[i] = static_cast<float>(pIn[i].y) * POINT_DEQUANTIZATION_SCALE;
+		pZ[i] = static_cast<float>(pIn[i].z) * POINT_DEQUANTIZATION_SCALE;
+	}
+}
+
+int HolographicFindSurfaceDemo::PickPointSoA(const XMFLOAT3& gazeOrigin, const XMFLOAT3& gazeDirection, const float* pX, const float* pY, const float* pZ, size_t count, XMMATRIX pointCloudModel)
+{
+	int pickIdx = -1;
+	PickPointsSoA(&pickIdx, &gazeOrigin, &gazeDirection, 1, pX, pY, pZ, count, pointCloudModel);
+	return pickIdx;
+}
+
+void HolographicFindSurfaceDemo::PickPointsSoA(int* pPickIdx, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount, const float* pX, const float* pY, const float* pZ, size_t count, XMMATRIX pointCloudModel)
+{
+	_pickRays(pPickIdx, pOrigins, pDirections, rayCount, count, pointCloudModel,
+		[&](size_t begin, size_t, const float*& pBlockX, const float*& pBlockY, const float*& pBlockZ) {
+			pBlockX = pX + begin;
+			pBlockY = pY + begin;
+			pBlockZ = pZ + begin;
+		});
+}
+
+void HolographicFindSurfaceDemo::PickPoints(int* pPickIdx, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount, const XMFLOAT3* pPoints, size_t count, XMMATRIX pointCloudModel)
+{
+	// Each block is transposed once and probed by every ray
+	alignas(16) float blockX[PICK_BLOCK_SIZE];
+	alignas(16) float blockY[PICK_BLOCK_SIZE];
+	alignas(16) float blockZ[PICK_BLOCK_SIZE];
+
+	_pickRays(pPickIdx, pOrigins, pDirections, rayCount, count, pointCloudModel,
+		[&](size_t begin, size_t blockCount, const float*& pBlockX, const float*& pBlockY, const float*& pBlockZ) {
+			SplitPoints(blockX, blockY, blockZ, pPoints + begin, blockCount);
+			pBlockX = blockX;
+			pBlockY = blockY;
+			pBlockZ = blockZ;
+		});
+}
+
+void HolographicFindSurfaceDemo::PickPoints(int* pPickIdx, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections, size_t rayCount, const QuantizedPoint* pPoints, size_t count, XMMATRIX pointCloudModel)
+{
+	alignas(16) float blockX[PICK_BLOCK_SIZE];
+	alignas(16) float blockY[PICK_BLOCK_SIZE];
+	alignas(16) float blockZ[PICK_BLOCK_SIZE];
+
+	_pickRays(pPickIdx, pOrigins, pDirections, rayCount, count, pointCloudModel,
+		[&](size_t begin, size_t blockCount, const float*& pBlockX, const float*& pBlockY, const float*& pBlockZ) {
+			SplitPoints(blockX, blockY, blockZ, pPoints + begin, blockCount);
+			pBlockX = blockX;
+			pBlockY = blockY;
+			pBlockZ = blockZ;
+		});
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef _POINT_PROBE_H_
+#define _POINT_PROBE_H_
+
+#include "PointQuantization.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Copies `count` points into separate x, y, z arrays (structure of arrays).
+	void SplitPoints(float* pX, float* pY, float* pZ, const DirectX::XMFLOAT3* pIn, size_t count);
+	// Same as SplitPoints() on the points DequantizePoints() would produce.
+	void SplitPoints(float* pX, float* pY, float* pZ, const QuantizedPoint* pIn, size_t count);
+
+	constexpr size_t MAX_PICK_RAY_COUNT = 8; // rays per PickPoints() batch (e.g. eye gaze, two hands and head)
+
+	// Same pick as pickPoint() (Helper.h) over points in structure of arrays layout, probing 4 points per instruction
+	// (SSE2, ARM64 NEON, scalar otherwise). The best candidates inside and outside the probe radius are kept per lane
+	// and reduced at the end, so the result matches pickPoint() bit for bit, ties included.
+	int PickPointSoA(
+		const DirectX::XMFLOAT3& gazeOrigin,
+		const DirectX::XMFLOAT3& gazeDirection,
+		const float* pX,
+		const float* pY,
+		const float* pZ,
+		size_t count,
+		DirectX::XMMATRIX pointCloudModel
+	);
+
+	// PickPointSoA() for `rayCount` (<= MAX_PICK_RAY_COUNT) gaze rays at once, in one pass over the points:
+	// every ray probes a block of points while it is cached, so the memory traffic does not grow with the ray count.
+	// `pPickIdx[k]` receives the pick of ray (pOrigins[k], pDirections[k]).
+	void PickPointsSoA(
+		_Out_writes_(rayCount) int* pPickIdx,
+		_In_reads_(rayCount) const DirectX::XMFLOAT3* pOrigins,
+		_In_reads_(rayCount) const DirectX::XMFLOAT3* pDirections,
+		size_t rayCount,
+		const float* pX,
+		const float* pY,
+		const float* pZ,
+		size_t count,
+		DirectX::XMMATRIX pointCloudModel
+	);
+
+	// PickPointsSoA() over interleaved points, each block of points is split into coordinate arrays once for all rays.
+	void PickPoints(
+		_Out_writes_(rayCount) int* pPickIdx,
+		_In_reads_(rayCount) const DirectX::XMFLOAT3* pOrigins,
+		_In_reads_(rayCount) const DirectX::XMFLOAT3* pDirections,
+		size_t rayCount,
+		const DirectX::XMFLOAT3* pPoints,
+		size_t count,
+		DirectX::XMMATRIX pointCloudModel
+	);
+	// Same as PickPoints() on the points DequantizePoints() would produce, decoded block by block.
+	void PickPoints(
+		_Out_writes_(rayCount) int* pPickIdx,
+		_In_reads_(rayCount) const DirectX::XMFLOAT3* pOrigins,
+		_In_reads_(rayCount) const DirectX::XMFLOAT3* pDirections,
+		size_t rayCount,
+		const QuantizedPoint* pPoints,
+		size_t count,
+		DirectX::XMMATRIX pointCloudModel
+	);
+};
+
+#endif
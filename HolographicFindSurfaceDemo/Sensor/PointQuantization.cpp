@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "PointQuantization.h"
+
+#include <cmath>
+
+using namespace HolographicFindSurfaceDemo;
+
+static_assert(sizeof(QuantizedPoint) == 3 * sizeof(INT16), "QuantizedPoint must be tightly packed");
+
+// Both layouts are x, y, z interleaved, so the conversion runs over 3 * count scalars.
+namespace
+{
+	inline INT16 quantizeScalar(float value)
+	{
+		float scaled = value * POINT_QUANTIZATION_SCALE;
+		scaled = scaled < -32768.0f ? -32768.0f : (scaled > 32767.0f ? 32767.0f : scaled);
+		return static_cast<INT16>(std::nearbyint(scaled)); // round half to even, as the vector conversions
+	}
+
+	inline void quantizeScalar(INT16* pOut, const float* pIn, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			pOut[i] = quantizeScalar(pIn[i]);
+		}
+	}
+
+	inline void dequantizeScalar(float* pOut, const INT16* pIn, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			pOut[i] = static_cast<float>(pIn[i]) * POINT_DEQUANTIZATION_SCALE;
+		}
+	}
+}
+
+#if defined(_XM_SSE_INTRINSICS_)
+
+void HolographicFindSurfaceDemo::QuantizePoints(QuantizedPoint* pOut, const DirectX::XMFLOAT3* pIn, size_t count)
+{
+	const float* pSrc = reinterpret_cast<const float*>(pIn);
+	INT16* pDst = reinterpret_cast<INT16*>(pOut);
+	const size_t scalarCount = count * 3;
+
+	const __m128 scale = _mm_set1_ps(POINT_QUANTIZATION_SCALE);
+	const __m128 lower = _mm_set1_ps(-32768.0f);
+	const __m128 upper = _mm_set1_ps(32767.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= scalarCount; i += 8)
+	{
+		__m128 lo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(pSrc + i), scale), lower), upper);
+		__m128 hi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(pSrc + i + 4), scale), lower), upper);
+
+		__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packed);
+	}
+
+	quantizeScalar(pDst, pSrc, i, scalarCount);
+}
+
+void HolographicFindSurfaceDemo::DequantizePoints(DirectX::XMFLOAT3* pOut, const QuantizedPoint* pIn, size_t count)
+{
+	const INT16* pSrc = reinterpret_cast<const INT16*>(pIn);
+	float* pDst = reinterpret_cast<float*>(pOut);
+	const size_t scalarCount = count * 3;
+
+	const __m128 scale = _mm_set1_ps(POINT_DEQUANTIZATION_SCALE);
+
+	size_t i = 0;
+	for (; i + 8 <= scalarCount; i += 8)
+	{
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+
+		// sign extension to 32 bit
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+
+		_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+
+	dequantizeScalar(pDst, pSrc, i, scalarCount);
+}
+
+#elif defined(_XM_ARM_NEON_INTRINSICS_)
+
+void HolographicFindSurfaceDemo::QuantizePoints(QuantizedPoint* pOut, const DirectX::XMFLOAT3* pIn, size_t count)
+{
+	const float* pSrc = reinterpret_cast<const float*>(pIn);
+	INT16* pDst = reinterpret_cast<INT16*>(pOut);
+	const size_t scalarCount = count * 3;
+
+	size_t i = 0;
+#if defined(_M_ARM64) || defined(__aarch64__)
+	// vcvtnq_s32_f32() (round to nearest even, as quantizeScalar()) is ARMv8 only, 32 bit ARM converts scalars
+	const float32x4_t lower = vdupq_n_f32(-32768.0f);
+	const float32x4_t upper = vdupq_n_f32(32767.0f);
+
+	for (; i + 8 <= scalarCount; i += 8)
+	{
+		float32x4_t lo = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(pSrc + i), POINT_QUANTIZATION_SCALE), lower), upper);
+		float32x4_t hi = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(pSrc + i + 4), POINT_QUANTIZATION_SCALE), lower), upper);
+
+		int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)), vqmovn_s32(vcvtnq_s32_f32(hi)));
+		vst1q_s16(pDst + i, packed);
+	}
+#endif
+
+	quantizeScalar(pDst, pSrc, i, scalarCount);
+}
+
+void HolographicFindSurfaceDemo::DequantizePoints(DirectX::XMFLOAT3* pOut, const QuantizedPoint* pIn, size_t count)
+{
+	const INT16* pSrc = reinterpret_cast<const INT16*>(pIn);
+	float* pDst = reinterpret_cast<float*>(pOut);
+	const size_t scalarCount = count * 3;
+
+	size_t i = 0;
+	for (; i + 8 <= scalarCount; i += 8)
+	{
+		int16x8_t value = vld1q_s16(pSrc + i);
+
+		vst1q_f32(pDst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))), POINT_DEQUANTIZATION_SCALE));
+		vst1q_f32(pDst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))), POINT_DEQUANTIZATION_SCALE));
+	}
+
+	dequantizeScalar(pDst, pSrc, i, scalarCount);
+}
+
+#else // _XM_NO_INTRINSICS_
+
+void HolographicFindSurfaceDemo::QuantizePoints(QuantizedPoint* pOut, const DirectX::XMFLOAT3* pIn, size_t count)
+{
+	quantizeScalar(reinterpret_cast<INT16*>(pOut), reinterpret_cast<const float*>(pIn), 0, count * 3);
+}
+
+void HolographicFindSurfaceDemo::DequantizePoints(DirectX::XMFLOAT3* pOut, const QuantizedPoint* pIn, size_t count)
+{
+	dequantizeScalar(reinterpret_cast<float*>(pOut), reinterpret_cast<const INT16*>(pIn), 0, count * 3);
+}
+
+#endif
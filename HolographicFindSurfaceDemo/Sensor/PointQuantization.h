@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef _POINT_QUANTIZATION_H_
+#define _POINT_QUANTIZATION_H_
+
+namespace HolographicFindSurfaceDemo
+{
+	// Camera space point in millimeter (+-32.767 meter), half the size of DirectX::XMFLOAT3
+	struct QuantizedPoint
+	{
+		INT16 x;
+		INT16 y;
+		INT16 z;
+	};
+
+	constexpr float POINT_QUANTIZATION_SCALE = 1000.0f;  // meter -> QuantizedPoint
+	constexpr float POINT_DEQUANTIZATION_SCALE = 0.001f; // QuantizedPoint -> meter
+
+	// Rounds `count` points to the nearest millimeter, coordinates out of range saturate.
+	void QuantizePoints(QuantizedPoint* pOut, const DirectX::XMFLOAT3* pIn, size_t count);
+	// Converts `count` quantized points back to meter.
+	void DequantizePoints(DirectX::XMFLOAT3* pOut, const QuantizedPoint* pIn, size_t count);
+
+	// One point of DequantizePoints(), bit for bit (w = 0).
+	inline DirectX::XMVECTOR LoadQuantizedPoint(const QuantizedPoint& point)
+	{
+		const DirectX::XMVECTOR v = DirectX::XMVectorSet(static_cast<float>(point.x), static_cast<float>(point.y), static_cast<float>(point.z), 0.0f);
+		return DirectX::XMVectorScale(v, POINT_DEQUANTIZATION_SCALE);
+	}
+	inline DirectX::XMFLOAT3 DequantizePoint(const QuantizedPoint& point)
+	{
+		DirectX::XMFLOAT3 p;
+		DirectX::XMStoreFloat3(&p, LoadQuantizedPoint(point));
+		return p;
+	}
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "ResearchModeDepthSource.h"
+#include "DepthUnprojection.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+using namespace winrt::Windows::Perception::Spatial;
+using namespace winrt::Windows::Perception::Spatial::Preview;
+
+extern "C" HMODULE LoadLibraryA( LPCSTR lpLibFileName );
+
+static ResearchModeSensorConsent camAccessCheck;
+static HANDLE camConsentGiven = nullptr;
+
+static void _camAccessOnComplete(ResearchModeSensorConsent consent)
+{
+	camAccessCheck = consent;
+	SetEvent(camConsentGiven);
+}
+
+ResearchModeDepthSource::ResearchModeDepthSource(ResearchModeSensorType sensorType)
+	: m_sensorType(sensorType)
+{
+	if (sensorType != DEPTH_LONG_THROW && sensorType != DEPTH_AHAT) {
+		throw std::invalid_argument("ResearchModeDepthSource: not a depth sensor");
+	}
+}
+
+ResearchModeDepthSource::~ResearchModeDepthSource()
+{
+	releaseFrame();
+
+	if (m_pCameraSensor) { m_pCameraSensor->Release(); }
+	if (m_pSensor) { m_pSensor->Release(); }
+	if (m_pSensorDeviceConsent) { m_pSensorDeviceConsent->Release(); }
+	if (m_pSensorDevice) { m_pSensorDevice->Release(); }
+}
+
+void ResearchModeDepthSource::initialize()
+{
+	// The consent is asked once per process, sources created later (e.g. switching sensors) reuse the answer
+	bool requestConsent = camConsentGiven == nullptr;
+	if (requestConsent) {
+		camConsentGiven = CreateEvent(nullptr, true, false, nullptr);
+	}
+
+	HMODULE hrResearchMode = LoadLibraryA("ResearchModeAPI");
+	if (hrResearchMode)
+	{
+		typedef HRESULT(__cdecl* PFN_CREATEPROVIDER) (IResearchModeSensorDevice** ppSensorDevice);
+		PFN_CREATEPROVIDER pfnCreate = reinterpret_cast<PFN_CREATEPROVIDER>(GetProcAddress(hrResearchMode, "CreateResearchModeSensorDevice"));
+		if (pfnCreate)
+		{
+			winrt::check_hresult(pfnCreate(&m_pSensorDevice));
+		}
+		else
+		{
+			winrt::check_hresult(E_INVALIDARG);
+		}
+	}
+
+	winrt::check_hresult(m_pSensorDevice->QueryInterface(IID_PPV_ARGS(&m_pSensorDeviceConsent)));
+	if (requestConsent) {
+		winrt::check_hresult(m_pSensorDeviceConsent->RequestCamAccessAsync(_camAccessOnComplete));
+	}
+
+	// This call makes cameras run at full frame rate. Normaly they are optimized 
+	// for headtracker use. For some applications that may be sufficient 
+	m_pSensorDevice->DisableEyeSelection();
+
+	// Get Depth Sensor
+	winrt::check_hresult(m_pSensorDevice->GetSensor(m_sensorType, &m_pSensor));
+	winrt::check_hresult(m_pSensor->QueryInterface(IID_PPV_ARGS(&m_pCameraSensor)));
+
+	// Spatial Locator
+	IResearchModeSensorDevicePerception* pSensorDevicePerception = nullptr;
+	GUID guid;
+
+	winrt::check_hresult(m_pSensorDevice->QueryInterface(IID_PPV_ARGS(&pSensorDevicePerception)));
+	winrt::check_hresult(pSensorDevicePerception->GetRigNodeId(&guid));
+	m_refSpatialLocator = SpatialGraphInteropPreview::CreateLocatorForNode(guid);
+	pSensorDevicePerception->Release();
+}
+
+bool ResearchModeDepthSource::open()
+{
+	if (camConsentGiven)
+	{
+		HRESULT hr = S_OK;
+		DWORD waitResult = WaitForSingleObject(camConsentGiven, INFINITE);
+
+		if (waitResult == WAIT_OBJECT_0)
+		{
+			switch (camAccessCheck)
+			{
+			case ResearchModeSensorConsent::Allowed:
+				OutputDebugString(L"Access is granted\n");
+				break;
+			case ResearchModeSensorConsent::DeniedBySystem:
+				OutputDebugString(L"Access is denied by the system\n");
+				hr = E_ACCESSDENIED;
+				break;
+			case ResearchModeSensorConsent::DeniedByUser:
+				OutputDebugString(L"Access is denied by the user\n");
+				hr = E_ACCESSDENIED;
+				break;
+			case ResearchModeSensorConsent::NotDeclaredByApp:
+				OutputDebugString(L"Capability is not declared in the app manifest\n");
+				hr = E_ACCESSDENIED;
+				break;
+			case ResearchModeSensorConsent::UserPromptRequired:
+				OutputDebugString(L"Capability user prompt required\n");
+				hr = E_ACCESSDENIED;
+				break;
+			default:
+				OutputDebugString(L"Access is denied by the system\n");
+				hr = E_ACCESSDENIED;
+				break;
+			}
+		}
+		else
+		{
+			hr = E_UNEXPECTED;
+		}
+
+		if (FAILED(hr))
+		{
+			OutputDebugString(L"Failed to Run Thread\n");
+			return false;
+		}
+	}
+
+	// Sensor Check
+	if (!m_pSensor) { return false; }
+
+	// Open Stream
+	winrt::check_hresult(m_pSensor->OpenStream());
+	return true;
+}
+
+void ResearchModeDepthSource::close()
+{
+	releaseFrame();
+	if (m_pSensor) {
+		m_pSensor->CloseStream();
+	}
+}
+
+bool ResearchModeDepthSource::acquireFrame(DepthFrame& frame)
+{
+	ResearchModeSensorResolution resolution;
+	ResearchModeSensorTimestamp  timestamp;
+	size_t outBufferCount;
+
+	releaseFrame();
+
+	m_pSensor->GetNextBuffer(&m_pSensorFrame);
+	if (!m_pSensorFrame) { return false; }
+
+	m_pSensorFrame->GetResolution(&resolution);
+	m_pSensorFrame->GetTimeStamp(&timestamp);
+
+	HRESULT hr = m_pSensorFrame->QueryInterface(IID_PPV_ARGS(&m_pDepthFrame));
+	if (FAILED(hr))
+	{
+		releaseFrame();
+		return false;
+	}
+
+	frame.width = resolution.Width;
+	frame.height = resolution.Height;
+	frame.hostTicks = timestamp.HostTicks;
+	frame.pSigma = nullptr;
+	frame.pDepth = nullptr;
+	frame.maxValidDepth = DEPTH_MAX_VALID_ANY;
+
+	if (m_sensorType == DEPTH_LONG_THROW) {
+		// extract sigma buffer for Long Throw
+		m_pDepthFrame->GetSigmaBuffer(&frame.pSigma, &outBufferCount);
+	}
+	else {
+		// AHAT has no sigma buffer, invalid pixels are encoded in the depth values
+		frame.maxValidDepth = DEPTH_AHAT_MAX_VALID;
+	}
+
+	// extract depth buffer
+	hr = m_pDepthFrame->GetBuffer(&frame.pDepth, &outBufferCount);
+	if (FAILED(hr) || frame.pDepth == nullptr)
+	{
+		releaseFrame();
+		return false;
+	}
+
+	return true;
+}
+
+void ResearchModeDepthSource::releaseFrame()
+{
+	if (m_pDepthFrame) {
+		m_pDepthFrame->Release();
+		m_pDepthFrame = nullptr;
+	}
+	if (m_pSensorFrame) {
+		m_pSensorFrame->Release();
+		m_pSensorFrame = nullptr;
+	}
+}
+
+bool ResearchModeDepthSource::mapImagePointToCameraUnitPlane(const float(&uv)[2], float(&xy)[2])
+{
+	float _uv[2] = { uv[0], uv[1] };
+	return SUCCEEDED(m_pCameraSensor->MapImagePointToCameraUnitPlane(_uv, xy));
+}
+
+void ResearchModeDepthSource::getCameraExtrinsics(DirectX::XMFLOAT4X4* pExtrinsic)
+{
+	m_pCameraSensor->GetCameraExtrinsicsMatrix(pExtrinsic);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef _RESEARCH_MODE_DEPTH_SOURCE_H_
+#define _RESEARCH_MODE_DEPTH_SOURCE_H_
+
+#include "ResearchMode/ResearchModeApi.h"
+#include "DepthFrameSource.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Depth frames of HoloLens 2 Research Mode depth sensor (Long Throw or AHAT).
+	class ResearchModeDepthSource : public DepthFrameSource
+	{
+	private: // Member Variable
+		ResearchModeSensorType m_sensorType;
+
+		IResearchModeSensorDevice* m_pSensorDevice = nullptr;
+		IResearchModeSensorDeviceConsent* m_pSensorDeviceConsent = nullptr; // Privilige
+		IResearchModeSensor* m_pSensor = nullptr;
+		IResearchModeCameraSensor* m_pCameraSensor = nullptr;
+
+		winrt::Windows::Perception::Spatial::SpatialLocator m_refSpatialLocator = nullptr;
+
+		// Frame borrowed by acquireFrame()
+		IResearchModeSensorFrame* m_pSensorFrame = nullptr;
+		IResearchModeSensorDepthFrame* m_pDepthFrame = nullptr;
+
+	public:
+		// `sensorType` must be DEPTH_LONG_THROW or DEPTH_AHAT, throws std::invalid_argument otherwise.
+		explicit ResearchModeDepthSource(ResearchModeSensorType sensorType = DEPTH_LONG_THROW);
+		~ResearchModeDepthSource();
+
+		// Throws winrt::hresult_error on failure.
+		void initialize();
+
+	public: // Getter
+		inline winrt::Windows::Perception::Spatial::SpatialLocator spatialLocator() const { return m_refSpatialLocator; }
+		inline ResearchModeSensorType sensorType() const { return m_sensorType; }
+
+	public: // DepthFrameSource
+		bool open() override;
+		void close() override;
+		bool acquireFrame(_Out_ DepthFrame& frame) override;
+		void releaseFrame() override;
+
+		bool mapImagePointToCameraUnitPlane(const float(&uv)[2], float(&xy)[2]) override;
+		void getCameraExtrinsics(_Out_ DirectX::XMFLOAT4X4* pExtrinsic) override;
+	};
+};
+
+#endif
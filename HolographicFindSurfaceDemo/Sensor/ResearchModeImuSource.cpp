@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "ResearchModeImuSource.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+extern "C" HMODULE LoadLibraryA( LPCSTR lpLibFileName );
+
+static ResearchModeSensorConsent imuAccessCheck;
+static HANDLE imuConsentGiven = nullptr;
+
+static void _imuAccessOnComplete(ResearchModeSensorConsent consent)
+{
+	imuAccessCheck = consent;
+	SetEvent(imuConsentGiven);
+}
+
+// Samples carry the IMU clock (VinylHupTicks, ns), the frame carries the host clock of its latest sample.
+template <typename DataStruct>
+static void _appendSamples(std::vector<ImuSample>& samples, const DataStruct* pData, size_t count, UINT64 frameHostTicks, float (DataStruct::* pValues)[3])
+{
+	if (count < 1) { return; }
+
+	const uint64_t latestTicks = pData[count - 1].VinylHupTicks;
+	for (size_t i = 0; i < count; i++)
+	{
+		const UINT64 age = (latestTicks - pData[i].VinylHupTicks) / 100; // ns -> 100 ns
+		const float* pValue = pData[i].*pValues;
+
+		ImuSample sample;
+		sample.hostTicks = frameHostTicks > age ? frameHostTicks - age : 0;
+		sample.value = DirectX::XMFLOAT3(pValue[0], pValue[1], pValue[2]);
+		samples.push_back(sample);
+	}
+}
+
+ResearchModeImuSource::ResearchModeImuSource(ResearchModeSensorType sensorType)
+	: m_sensorType(sensorType)
+{
+	if (sensorType != IMU_ACCEL && sensorType != IMU_GYRO) {
+		throw std::invalid_argument("ResearchModeImuSource: not an accelerometer or gyroscope");
+	}
+	DirectX::XMStoreFloat4x4(&m_matExtrinsic, DirectX::XMMatrixIdentity());
+}
+
+ResearchModeImuSource::~ResearchModeImuSource()
+{
+	if (m_pSensor) { m_pSensor->Release(); }
+	if (m_pSensorDeviceConsent) { m_pSensorDeviceConsent->Release(); }
+	if (m_pSensorDevice) { m_pSensorDevice->Release(); }
+}
+
+void ResearchModeImuSource::initialize()
+{
+	// The consent is asked once per process (see ResearchModeDepthSource::initialize())
+	bool requestConsent = imuConsentGiven == nullptr;
+	if (requestConsent) {
+		imuConsentGiven = CreateEvent(nullptr, true, false, nullptr);
+	}
+
+	HMODULE hrResearchMode = LoadLibraryA("ResearchModeAPI");
+	if (hrResearchMode)
+	{
+		typedef HRESULT(__cdecl* PFN_CREATEPROVIDER) (IResearchModeSensorDevice** ppSensorDevice);
+		PFN_CREATEPROVIDER pfnCreate = reinterpret_cast<PFN_CREATEPROVIDER>(GetProcAddress(hrResearchMode, "CreateResearchModeSensorDevice"));
+		if (pfnCreate)
+		{
+			winrt::check_hresult(pfnCreate(&m_pSensorDevice));
+		}
+		else
+		{
+			winrt::check_hresult(E_INVALIDARG);
+		}
+	}
+
+	winrt::check_hresult(m_pSensorDevice->QueryInterface(IID_PPV_ARGS(&m_pSensorDeviceConsent)));
+	if (requestConsent) {
+		winrt::check_hresult(m_pSensorDeviceConsent->RequestIMUAccessAsync(_imuAccessOnComplete));
+	}
+
+	// Get IMU Sensor
+	winrt::check_hresult(m_pSensorDevice->GetSensor(m_sensorType, &m_pSensor));
+
+	// Extrinsic (RigNode to IMU)
+	if (m_sensorType == IMU_GYRO)
+	{
+		IResearchModeGyroSensor* pGyroSensor = nullptr;
+		winrt::check_hresult(m_pSensor->QueryInterface(IID_PPV_ARGS(&pGyroSensor)));
+		pGyroSensor->GetExtrinsicsMatrix(&m_matExtrinsic);
+		pGyroSensor->Release();
+	}
+	else
+	{
+		IResearchModeAccelSensor* pAccelSensor = nullptr;
+		winrt::check_hresult(m_pSensor->QueryInterface(IID_PPV_ARGS(&pAccelSensor)));
+		pAccelSensor->GetExtrinsicsMatrix(&m_matExtrinsic);
+		pAccelSensor->Release();
+	}
+}
+
+bool ResearchModeImuSource::open()
+{
+	if (imuConsentGiven)
+	{
+		DWORD waitResult = WaitForSingleObject(imuConsentGiven, INFINITE);
+		if (waitResult != WAIT_OBJECT_0 || imuAccessCheck != ResearchModeSensorConsent::Allowed)
+		{
+			OutputDebugString(L"IMU access is denied\n");
+			return false;
+		}
+	}
+
+	// Sensor Check
+	if (!m_pSensor) { return false; }
+
+	// Open Stream
+	winrt::check_hresult(m_pSensor->OpenStream());
+	return true;
+}
+
+void ResearchModeImuSource::close()
+{
+	if (m_pSensor) {
+		m_pSensor->CloseStream();
+	}
+}
+
+bool ResearchModeImuSource::acquireSamples(std::vector<ImuSample>& samples)
+{
+	IResearchModeSensorFrame* pSensorFrame = nullptr;
+	ResearchModeSensorTimestamp timestamp;
+	size_t count = 0;
+
+	m_pSensor->GetNextBuffer(&pSensorFrame);
+	if (!pSensorFrame) { return false; }
+
+	pSensorFrame->GetTimeStamp(&timestamp);
+
+	HRESULT hr = E_FAIL;
+	if (m_sensorType == IMU_GYRO)
+	{
+		IResearchModeGyroFrame* pGyroFrame = nullptr;
+		hr = pSensorFrame->QueryInterface(IID_PPV_ARGS(&pGyroFrame));
+		if (SUCCEEDED(hr))
+		{
+			const GyroDataStruct* pData = nullptr;
+			hr = pGyroFrame->GetCalibratedGyroSamples(&pData, &count);
+			if (SUCCEEDED(hr)) {
+				_appendSamples(samples, pData, count, timestamp.HostTicks, &GyroDataStruct::GyroValues);
+			}
+			pGyroFrame->Release();
+		}
+	}
+	else
+	{
+		IResearchModeAccelFrame* pAccelFrame = nullptr;
+		hr = pSensorFrame->QueryInterface(IID_PPV_ARGS(&pAccelFrame));
+		if (SUCCEEDED(hr))
+		{
+			const AccelDataStruct* pData = nullptr;
+			hr = pAccelFrame->GetCalibratedAccelarationSamples(&pData, &count);
+			if (SUCCEEDED(hr)) {
+				_appendSamples(samples, pData, count, timestamp.HostTicks, &AccelDataStruct::AccelValues);
+			}
+			pAccelFrame->Release();
+		}
+	}
+
+	pSensorFrame->Release();
+	return SUCCEEDED(hr) && count > 0;
+}
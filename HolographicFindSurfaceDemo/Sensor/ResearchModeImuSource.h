@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef _RESEARCH_MODE_IMU_SOURCE_H_
+#define _RESEARCH_MODE_IMU_SOURCE_H_
+
+#include "ResearchMode/ResearchModeApi.h"
+#include "ImuSampleSource.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Samples of HoloLens 2 Research Mode accelerometer or gyroscope.
+	class ResearchModeImuSource : public ImuSampleSource
+	{
+	private: // Member Variable
+		ResearchModeSensorType m_sensorType;
+
+		IResearchModeSensorDevice* m_pSensorDevice = nullptr;
+		IResearchModeSensorDeviceConsent* m_pSensorDeviceConsent = nullptr; // Privilige
+		IResearchModeSensor* m_pSensor = nullptr;
+
+		DirectX::XMFLOAT4X4 m_matExtrinsic;
+
+	public:
+		// `sensorType` must be IMU_ACCEL or IMU_GYRO, throws std::invalid_argument otherwise.
+		explicit ResearchModeImuSource(ResearchModeSensorType sensorType = IMU_GYRO);
+		~ResearchModeImuSource();
+
+		// Throws winrt::hresult_error on failure.
+		void initialize();
+
+	public: // Getter
+		inline ResearchModeSensorType sensorType() const { return m_sensorType; }
+
+	public: // ImuSampleSource
+		bool open() override;
+		void close() override;
+		bool acquireSamples(std::vector<ImuSample>& samples) override;
+
+		void getExtrinsics(_Out_ DirectX::XMFLOAT4X4* pExtrinsic) override { *pExtrinsic = m_matExtrinsic; }
+	};
+};
+
+#endif
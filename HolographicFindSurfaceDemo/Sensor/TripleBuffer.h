@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef _TRIPLE_BUFFER_H_
+#define _TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Lock-free single producer / single consumer triple buffer.
+	// The producer fills back() and publish()es it, the consumer acquire()s the latest published slot.
+	// Slots are swapped by index, their contents are never copied.
+	template <typename T>
+	class TripleBuffer
+	{
+	private:
+		static constexpr int INDEX_MASK = 0x3;
+		static constexpr int FRESH_BIT = 0x4; // middle slot holds data the consumer has not acquired yet
+
+		T m_slots[3];
+
+		int m_nBack = 0;                  // owned by producer
+		int m_nFront = 1;                 // owned by consumer
+		std::atomic<int> m_nMiddle{ 2 };  // shared (index | FRESH_BIT)
+
+	public: // Producer
+		inline T& back() { return m_slots[m_nBack]; }
+
+		// Publishes back() as the latest slot. Returns false if the previously published slot was never acquired.
+		inline bool publish()
+		{
+			int prev = m_nMiddle.exchange(m_nBack | FRESH_BIT, std::memory_order_acq_rel);
+			m_nBack = prev & INDEX_MASK;
+			return (prev & FRESH_BIT) == 0;
+		}
+
+	public: // Consumer
+		// Returns the latest published slot, or nullptr if nothing was published since the last call.
+		// The returned slot stays valid (and unchanged) until the next successful acquire().
+		inline T* acquire()
+		{
+			if ((m_nMiddle.load(std::memory_order_relaxed) & FRESH_BIT) == 0) { return nullptr; }
+
+			int prev = m_nMiddle.exchange(m_nFront, std::memory_order_acq_rel);
+			m_nFront = prev & INDEX_MASK;
+			return &m_slots[m_nFront];
+		}
+
+		inline bool hasUpdate() const { return (m_nMiddle.load(std::memory_order_relaxed) & FRESH_BIT) != 0; }
+
+		// Drops pending slot (if any) without acquiring it.
+		inline void discard() { m_nMiddle.fetch_and(INDEX_MASK, std::memory_order_acq_rel); }
+	};
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "UnitPlaneCache.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+namespace
+{
+	constexpr UINT32 CACHE_MAGIC = 0x554C5346; // "FSLU"
+	constexpr UINT32 CACHE_VERSION = 1;
+	constexpr UINT32 SAMPLE_GRID = 5;          // SAMPLE_GRID x SAMPLE_GRID validation pixels (corners included)
+
+	struct CacheHeader
+	{
+		UINT32 magic;
+		UINT32 version;
+		UINT32 width;
+		UINT32 height;
+		UINT64 calibrationKey;
+		UINT64 tableHash;
+	};
+
+	// FNV-1a (64 bit)
+	constexpr UINT64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+	constexpr UINT64 FNV_PRIME = 1099511628211ull;
+
+	inline UINT64 fnv1a(UINT64 hash, const void* pData, size_t size)
+	{
+		const BYTE* pBytes = static_cast<const BYTE*>(pData);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	UINT64 calibrationKey(DepthFrameSource& source, const DirectX::XMFLOAT4X4& extrinsic, UINT32 width, UINT32 height)
+	{
+		UINT64 hash = FNV_OFFSET_BASIS;
+		hash = fnv1a(hash, &width, sizeof(width));
+		hash = fnv1a(hash, &height, sizeof(height));
+		hash = fnv1a(hash, &extrinsic, sizeof(extrinsic));
+
+		for (UINT32 j = 0; j < SAMPLE_GRID; j++)
+		{
+			for (UINT32 i = 0; i < SAMPLE_GRID; i++)
+			{
+				UINT32 u = (width - 1) * i / (SAMPLE_GRID - 1);
+				UINT32 v = (height - 1) * j / (SAMPLE_GRID - 1);
+
+				DirectX::XMFLOAT4 unit = UnitPlaneCache::MapPixel(source, u, v);
+				hash = fnv1a(hash, &unit, sizeof(unit));
+			}
+		}
+		return hash;
+	}
+
+	bool readAll(HANDLE hFile, void* pData, size_t size)
+	{
+		BYTE* pBytes = static_cast<BYTE*>(pData);
+		while (size > 0)
+		{
+			DWORD chunk = static_cast<DWORD>((std::min)(size, static_cast<size_t>(0x40000000)));
+			DWORD read = 0;
+			if (!ReadFile(hFile, pBytes, chunk, &read, nullptr) || read == 0) { return false; }
+			pBytes += read;
+			size -= read;
+		}
+		return true;
+	}
+
+	bool writeAll(HANDLE hFile, const void* pData, size_t size)
+	{
+		const BYTE* pBytes = static_cast<const BYTE*>(pData);
+		while (size > 0)
+		{
+			DWORD chunk = static_cast<DWORD>((std::min)(size, static_cast<size_t>(0x40000000)));
+			DWORD written = 0;
+			if (!WriteFile(hFile, pBytes, chunk, &written, nullptr)) { return false; }
+			pBytes += written;
+			size -= written;
+		}
+		return true;
+	}
+}
+
+DirectX::XMFLOAT4 UnitPlaneCache::MapPixel(DepthFrameSource& source, UINT32 u, UINT32 v)
+{
+	float uv[2] = { static_cast<float>(u) + 0.5f, static_cast<float>(v) + 0.5f };
+	float xy[2] = { 0, 0 };
+	source.mapImagePointToCameraUnitPlane(uv, xy);
+
+	float depthAdjust = sqrt(1.0f + xy[0] * xy[0] + xy[1] * xy[1]); // sqrt( x*x + y*y + z*z ) where z = 1
+
+	return DirectX::XMFLOAT4(xy[0], xy[1], depthAdjust, 1.0f / depthAdjust);
+}
+
+void UnitPlaneCache::Build(DepthFrameSource& source, UINT32 width, UINT32 height, std::vector<DirectX::XMFLOAT4>& unitXYPlane)
+{
+	unitXYPlane.clear();
+	unitXYPlane.reserve(static_cast<size_t>(width) * height);
+
+	for (UINT32 v = 0; v < height; v++)
+	{
+		for (UINT32 u = 0; u < width; u++)
+		{
+			unitXYPlane.emplace_back(MapPixel(source, u, v));
+		}
+	}
+}
+
+bool UnitPlaneCache::Load(const std::wstring& path, DepthFrameSource& source, const DirectX::XMFLOAT4X4& extrinsic,
+	DirectX::XMUINT2& resolution, std::vector<DirectX::XMFLOAT4>& unitXYPlane)
+{
+	winrt::file_handle hFile{ CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr) };
+	if (!hFile) { return false; }
+
+	CacheHeader header;
+	if (!readAll(hFile.get(), &header, sizeof(header))) { return false; }
+	if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) { return false; }
+	if (header.width < 2 || header.height < 2 || header.width > 4096 || header.height > 4096) { return false; }
+
+	// Validate against the live calibration before reading the table
+	if (header.calibrationKey != calibrationKey(source, extrinsic, header.width, header.height)) { return false; }
+
+	std::vector<DirectX::XMFLOAT4> table(static_cast<size_t>(header.width) * header.height);
+	if (!readAll(hFile.get(), table.data(), table.size() * sizeof(DirectX::XMFLOAT4))) { return false; }
+	if (header.tableHash != fnv1a(FNV_OFFSET_BASIS, table.data(), table.size() * sizeof(DirectX::XMFLOAT4))) { return false; }
+
+	resolution = { header.width, header.height };
+	unitXYPlane = std::move(table);
+
+	return true;
+}
+
+bool UnitPlaneCache::Save(const std::wstring& path, DepthFrameSource& source, const DirectX::XMFLOAT4X4& extrinsic,
+	const DirectX::XMUINT2& resolution, const std::vector<DirectX::XMFLOAT4>& unitXYPlane)
+{
+	if (resolution.x < 2 || resolution.y < 2 || unitXYPlane.size() != static_cast<size_t>(resolution.x) * resolution.y) { return false; }
+
+	CacheHeader header;
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.width = resolution.x;
+	header.height = resolution.y;
+	header.calibrationKey = calibrationKey(source, extrinsic, resolution.x, resolution.y);
+	header.tableHash = fnv1a(FNV_OFFSET_BASIS, unitXYPlane.data(), unitXYPlane.size() * sizeof(DirectX::XMFLOAT4));
+
+	winrt::file_handle hFile{ CreateFile2(path.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr) };
+	if (!hFile) { return false; }
+
+	return writeAll(hFile.get(), &header, sizeof(header))
+		&& writeAll(hFile.get(), unitXYPlane.data(), unitXYPlane.size() * sizeof(DirectX::XMFLOAT4));
+}
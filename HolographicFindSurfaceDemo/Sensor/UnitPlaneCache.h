@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef _UNIT_PLANE_CACHE_H_
+#define _UNIT_PLANE_CACHE_H_
+
+#include "DepthFrameSource.h"
+
+namespace HolographicFindSurfaceDemo
+{
+	// Persistent cache of the pre-calculated Unit XY Plane (x, y, depthAdjust, 1 / depthAdjust per pixel).
+	//
+	// The cache is keyed by a hash of the resolution, the extrinsic matrix and the unit plane mapping of
+	// a grid of sampled pixels, so that loading it costs a handful of mapImagePointToCameraUnitPlane() calls
+	// instead of one per pixel. A device with another calibration produces another key and misses the cache.
+	class UnitPlaneCache
+	{
+	public:
+		// Computes the unit plane entry of the pixel center (u + 0.5, v + 0.5).
+		static DirectX::XMFLOAT4 MapPixel(DepthFrameSource& source, UINT32 u, UINT32 v);
+
+		// Builds the whole table, one mapping call per pixel.
+		static void Build(DepthFrameSource& source, UINT32 width, UINT32 height, _Out_ std::vector<DirectX::XMFLOAT4>& unitXYPlane);
+
+		// Loads the table stored in `path` if its key matches the calibration reported by `source`.
+		// Returns false (leaving the outputs untouched) if there is no valid cache.
+		static bool Load(const std::wstring& path, DepthFrameSource& source, const DirectX::XMFLOAT4X4& extrinsic,
+			_Out_ DirectX::XMUINT2& resolution, _Out_ std::vector<DirectX::XMFLOAT4>& unitXYPlane);
+
+		// Stores the table built for `source`. Returns false if the file can not be written.
+		static bool Save(const std::wstring& path, DepthFrameSource& source, const DirectX::XMFLOAT4X4& extrinsic,
+			const DirectX::XMUINT2& resolution, const std::vector<DirectX::XMFLOAT4>& unitXYPlane);
+	};
+};
+
+#endif
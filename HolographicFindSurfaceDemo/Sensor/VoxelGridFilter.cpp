@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "VoxelGridFilter.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+namespace
+{
+	// 21 bits per axis, voxel indices in [-2^20, 2^20)
+	constexpr int   KEY_AXIS_BITS = 21;
+	constexpr INT64 KEY_AXIS_OFFSET = 1ll << (KEY_AXIS_BITS - 1);
+	constexpr INT64 KEY_AXIS_MAX = (1ll << KEY_AXIS_BITS) - 1;
+
+	inline INT64 voxelIndex(float coord, float invVoxelSize)
+	{
+		INT64 index = static_cast<INT64>(floorf(coord * invVoxelSize)) + KEY_AXIS_OFFSET;
+		return index < 0 ? 0 : (index > KEY_AXIS_MAX ? KEY_AXIS_MAX : index);
+	}
+
+	// Squared distance from `pt` to the center of voxel (ix, iy, iz)
+	inline float centerDistanceSq(const DirectX::XMFLOAT3& pt, INT64 ix, INT64 iy, INT64 iz, float voxelSize)
+	{
+		float dx = pt.x - (static_cast<float>(ix - KEY_AXIS_OFFSET) + 0.5f) * voxelSize;
+		float dy = pt.y - (static_cast<float>(iy - KEY_AXIS_OFFSET) + 0.5f) * voxelSize;
+		float dz = pt.z - (static_cast<float>(iz - KEY_AXIS_OFFSET) + 0.5f) * voxelSize;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	inline UINT64 hashKey(UINT64 key)
+	{
+		// Fibonacci hashing, high bits are taken by the caller
+		return key * 0x9E3779B97F4A7C15ull;
+	}
+}
+
+void VoxelGridFilter::setVoxelSize(float voxelSize)
+{
+	if (!(voxelSize > 0.0f)) {
+		throw std::invalid_argument("VoxelGridFilter::setVoxelSize(): voxel size must be positive");
+	}
+	m_fVoxelSize = voxelSize;
+}
+
+void VoxelGridFilter::prepareTable(size_t count)
+{
+	// Load factor <= 0.5
+	size_t capacity = 16;
+	while (capacity < count * 2) { capacity <<= 1; }
+
+	if (m_vecSlots.size() < capacity)
+	{
+		m_vecSlots.assign(capacity, Slot{ 0, 0 });
+		m_nGeneration = 0;
+	}
+
+	if (++m_nGeneration == 0)
+	{
+		// Generation counter wrapped around, invalidate every slot once
+		std::fill(m_vecSlots.begin(), m_vecSlots.end(), Slot{ 0, 0 });
+		m_nGeneration = 1;
+	}
+
+	m_vecCells.clear();
+	m_vecCells.reserve(count);
+}
+
+size_t VoxelGridFilter::apply(DirectX::XMFLOAT3* pOut, const DirectX::XMFLOAT3* pIn, size_t count)
+{
+	if (count < 1) { return 0; }
+
+	prepareTable(count);
+
+	const float invVoxelSize = 1.0f / m_fVoxelSize;
+	const UINT64 mask = m_vecSlots.size() - 1;
+	int shift = 64;
+	for (size_t capacity = m_vecSlots.size(); capacity > 1; capacity >>= 1) { shift--; }
+
+	// Pass 1: bin points (reads pIn only)
+	for (size_t i = 0; i < count; i++)
+	{
+		const DirectX::XMFLOAT3& pt = pIn[i];
+
+		INT64 ix = voxelIndex(pt.x, invVoxelSize);
+		INT64 iy = voxelIndex(pt.y, invVoxelSize);
+		INT64 iz = voxelIndex(pt.z, invVoxelSize);
+		UINT64 key = (static_cast<UINT64>(ix) << (2 * KEY_AXIS_BITS)) | (static_cast<UINT64>(iy) << KEY_AXIS_BITS) | static_cast<UINT64>(iz);
+
+		UINT64 pos = hashKey(key) >> shift;
+		while (true)
+		{
+			Slot& slot = m_vecSlots[pos];
+			if (slot.generation != m_nGeneration)
+			{
+				// New voxel
+				slot.generation = m_nGeneration;
+				slot.cell = static_cast<UINT32>(m_vecCells.size());
+
+				Cell cell;
+				cell.key = key;
+				cell.sum = pt;
+				cell.count = 1;
+				cell.distSq = m_mode == MODE_NEAREST_TO_CENTER ? centerDistanceSq(pt, ix, iy, iz, m_fVoxelSize) : 0.0f;
+				m_vecCells.push_back(cell);
+				break;
+			}
+
+			Cell& cell = m_vecCells[slot.cell];
+			if (cell.key == key)
+			{
+				if (m_mode == MODE_CENTROID)
+				{
+					cell.sum.x += pt.x;
+					cell.sum.y += pt.y;
+					cell.sum.z += pt.z;
+				}
+				else
+				{
+					float distSq = centerDistanceSq(pt, ix, iy, iz, m_fVoxelSize);
+					if (distSq < cell.distSq)
+					{
+						cell.sum = pt;
+						cell.distSq = distSq;
+					}
+				}
+				cell.count++;
+				break;
+			}
+
+			pos = (pos + 1) & mask; // linear probing
+		}
+	}
+
+	// Pass 2: emit one point per voxel (writes pOut only, in-place safe since cells <= count)
+	const size_t cellCount = m_vecCells.size();
+	for (size_t c = 0; c < cellCount; c++)
+	{
+		const Cell& cell = m_vecCells[c];
+		if (m_mode == MODE_CENTROID)
+		{
+			const float inv = 1.0f / static_cast<float>(cell.count);
+			pOut[c] = DirectX::XMFLOAT3(cell.sum.x * inv, cell.sum.y * inv, cell.sum.z * inv);
+		}
+		else
+		{
+			pOut[c] = cell.sum;
+		}
+	}
+
+	return cellCount;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef _VOXEL_GRID_FILTER_H_
+#define _VOXEL_GRID_FILTER_H_
+
+namespace HolographicFindSurfaceDemo
+{
+	// Voxel grid downsampling in linear time.
+	// Points are binned into cubic voxels through a hashed voxel key; each occupied voxel yields one point.
+	// Output order follows the first point of each voxel, so the result is deterministic.
+	// Working memory is kept between calls, a filter instance must be used by one thread at a time.
+	class VoxelGridFilter
+	{
+	public:
+		enum Mode
+		{
+			MODE_CENTROID,          // Mean of the points in the voxel
+			MODE_NEAREST_TO_CENTER  // Input point closest to the voxel center (keeps measured points)
+		};
+
+	private:
+		struct Cell
+		{
+			UINT64 key;
+			DirectX::XMFLOAT3 sum;     // MODE_CENTROID: sum of points, MODE_NEAREST_TO_CENTER: nearest point
+			float distSq;              // MODE_NEAREST_TO_CENTER: squared distance of the nearest point to the center
+			UINT32 count;
+		};
+
+		struct Slot
+		{
+			UINT32 generation;
+			UINT32 cell;
+		};
+
+		float m_fVoxelSize;
+		Mode m_mode;
+
+		// Open addressing hash table (voxel key -> cell). Slots of older generations count as empty,
+		// so the table never needs to be cleared.
+		std::vector<Slot> m_vecSlots;
+		UINT32 m_nGeneration = 0;
+		std::vector<Cell> m_vecCells;
+
+	public:
+		explicit VoxelGridFilter(float voxelSize = 0.01f, Mode mode = MODE_CENTROID) : m_fVoxelSize(voxelSize), m_mode(mode) {}
+
+		// Edge length of voxels in meter. Throws std::invalid_argument if it is not positive.
+		void setVoxelSize(float voxelSize);
+		inline float voxelSize() const { return m_fVoxelSize; }
+
+		inline void setMode(Mode mode) { m_mode = mode; }
+		inline Mode mode() const { return m_mode; }
+
+		// Downsamples `count` points of `pIn` into `pOut` and returns the number of output points.
+		// `pOut` needs room for `count` points and may be the same buffer as `pIn`.
+		size_t apply(_Out_writes_to_(count, return) DirectX::XMFLOAT3* pOut, _In_reads_(count) const DirectX::XMFLOAT3* pIn, size_t count);
+
+	private:
+		void prepareTable(size_t count);
+	};
+};
+
+#endif
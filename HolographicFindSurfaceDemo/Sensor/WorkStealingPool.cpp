@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "WorkStealingPool.h"
+
+using namespace HolographicFindSurfaceDemo;
+
+WorkStealingPool::WorkStealingPool(uint32_t workerCount)
+{
+	for (uint32_t i = 0; i <= workerCount; i++) {
+		m_vecQueues.emplace_back(std::make_unique<TaskQueue>());
+	}
+	for (uint32_t i = 1; i <= workerCount; i++) {
+		m_vecWorkers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard lock(m_hMutex);
+		m_fExit = true;
+	}
+	m_cvWork.notify_all();
+
+	for (auto& worker : m_vecWorkers) {
+		worker.join();
+	}
+}
+
+void WorkStealingPool::parallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& job)
+{
+	if (taskCount < 1) { return; }
+
+	m_pJob = &job;
+	m_nRemaining.store(taskCount, std::memory_order_relaxed);
+
+	// Distribute contiguous runs of tasks, so that neighbouring tasks run on the same thread unless stolen.
+	const uint32_t queueCount = concurrency();
+	for (uint32_t q = 0; q < queueCount; q++)
+	{
+		uint32_t begin = static_cast<uint32_t>((static_cast<uint64_t>(taskCount) * q) / queueCount);
+		uint32_t end = static_cast<uint32_t>((static_cast<uint64_t>(taskCount) * (q + 1)) / queueCount);
+
+		std::lock_guard lock(m_vecQueues[q]->mutex);
+		// Owner pops from the back, so push in reverse to run its run in ascending order.
+		for (uint32_t i = end; i > begin; i--) {
+			m_vecQueues[q]->tasks.push_back(i - 1);
+		}
+	}
+
+	{
+		std::lock_guard lock(m_hMutex);
+		m_nGeneration++;
+	}
+	m_cvWork.notify_all();
+
+	while (runOne(0)) {}
+
+	std::unique_lock lock(m_hMutex);
+	m_cvDone.wait(lock, [this] { return m_nRemaining.load(std::memory_order_acquire) == 0; });
+	m_pJob = nullptr;
+}
+
+bool WorkStealingPool::runOne(uint32_t self)
+{
+	uint32_t task = 0;
+	bool found = false;
+
+	// Own queue first (back), then steal (front) from the others
+	{
+		TaskQueue& own = *m_vecQueues[self];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = own.tasks.back();
+			own.tasks.pop_back();
+			found = true;
+		}
+	}
+
+	const uint32_t queueCount = concurrency();
+	for (uint32_t k = 1; !found && k < queueCount; k++)
+	{
+		TaskQueue& victim = *m_vecQueues[(self + k) % queueCount];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found) { return false; }
+
+	(*m_pJob)(task);
+
+	if (m_nRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		std::lock_guard lock(m_hMutex);
+		m_cvDone.notify_all();
+	}
+	return true;
+}
+
+void WorkStealingPool::workerLoop(uint32_t self)
+{
+	uint64_t seenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock lock(m_hMutex);
+			m_cvWork.wait(lock, [&] { return m_fExit || m_nGeneration != seenGeneration; });
+			if (m_fExit) { return; }
+			seenGeneration = m_nGeneration;
+		}
+
+		while (runOne(self)) {}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef _WORK_STEALING_POOL_H_
+#define _WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace HolographicFindSurfaceDemo
+{
+	// Small fork-join thread pool. Each participant owns a task queue, takes work from its back
+	// and steals from the front of the others' queues when its own queue runs dry.
+	class WorkStealingPool
+	{
+	private:
+		struct TaskQueue
+		{
+			std::mutex mutex;
+			std::deque<uint32_t> tasks;
+		};
+
+		std::vector< std::unique_ptr<TaskQueue> > m_vecQueues; // [0] is the calling thread
+		std::vector< std::thread > m_vecWorkers;
+
+		const std::function<void(uint32_t)>* m_pJob = nullptr;
+		std::atomic<uint32_t> m_nRemaining{ 0 };
+
+		std::mutex m_hMutex;
+		std::condition_variable m_cvWork;
+		std::condition_variable m_cvDone;
+		uint64_t m_nGeneration = 0;
+		bool m_fExit = false;
+
+	public:
+		// Spawns `workerCount` threads; the thread calling parallelFor() works as well.
+		explicit WorkStealingPool(uint32_t workerCount);
+		~WorkStealingPool();
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		inline uint32_t concurrency() const { return static_cast<uint32_t>(m_vecQueues.size()); }
+
+		// Runs job(i) for every i in [0, taskCount) and returns when all of them are done.
+		// Not reentrant: must be called from one thread at a time.
+		void parallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& job);
+
+	private:
+		bool runOne(uint32_t self);
+		void workerLoop(uint32_t self);
+	};
+};
+
+#endif
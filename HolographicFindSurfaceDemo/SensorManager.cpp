@@ -1,148 +1,92 @@
 #include "pch.h"
 #include "SensorManager.h"
+#include "Sensor/DepthUnprojection.h"
+#include "Sensor/LazyUnprojection.h"
+#include "Sensor/ResearchModeDepthSource.h"
+#include "Sensor/UnitPlaneCache.h"
 
 #include <sstream>
 
 using namespace HolographicFindSurfaceDemo;
 
-using namespace winrt::Windows::Perception::Spatial;
-using namespace winrt::Windows::Perception::Spatial::Preview;
-
-extern "C" HMODULE LoadLibraryA( LPCSTR lpLibFileName );
-
-static ResearchModeSensorConsent camAccessCheck;
-static HANDLE camConsentGiven = nullptr;
-
-static void _camAccessOnComplete(ResearchModeSensorConsent consent)
-{
-	camAccessCheck = consent;
-	SetEvent(camConsentGiven);
-}
-
 // Thread
 void SensorManager::SensorLoopThread(SensorManager* pOwner)
 {
-	if (camConsentGiven)
-	{
-		HRESULT hr = S_OK;
-		DWORD waitResult = WaitForSingleObject(camConsentGiven, INFINITE);
+	DepthFrameSource* pSource = pOwner->m_pSource.get();
 
-		if (waitResult == WAIT_OBJECT_0)
+	// Source Check
+	if (pSource && pSource->open())
+	{
+		while (!pOwner->m_fExit)
 		{
-			switch (camAccessCheck)
-			{
-			case ResearchModeSensorConsent::Allowed:
-				OutputDebugString(L"Access is granted\n");
-				break;
-			case ResearchModeSensorConsent::DeniedBySystem:
-				OutputDebugString(L"Access is denied by the system\n");
-				hr = E_ACCESSDENIED;
-				break;
-			case ResearchModeSensorConsent::DeniedByUser:
-				OutputDebugString(L"Access is denied by the user\n");
-				hr = E_ACCESSDENIED;
-				break;
-			case ResearchModeSensorConsent::NotDeclaredByApp:
-				OutputDebugString(L"Capability is not declared in the app manifest\n");
-				hr = E_ACCESSDENIED;
-				break;
-			case ResearchModeSensorConsent::UserPromptRequired:
-				OutputDebugString(L"Capability user prompt required\n");
-				hr = E_ACCESSDENIED;
-				break;
-			default:
-				OutputDebugString(L"Access is denied by the system\n");
-				hr = E_ACCESSDENIED;
+			DepthFrame frame;
+
+			if (pSource->acquireFrame(frame)) {
+				if (pOwner->waitForConsumer(frame)) {
+					pOwner->onProcessFrame(frame);
+				}
+				pSource->releaseFrame();
+			}
+			else if (pSource->isEndOfStream()) {
 				break;
 			}
 		}
-		else
-		{
-			hr = E_UNEXPECTED;
-		}
 
-		if (FAILED(hr))
-		{
-			OutputDebugString(L"Failed to Run Thread\n");
-			return;
-		}
+		pSource->close();
 	}
+}
 
-	// Sensor Check
-	if (pOwner->m_pSensor)
-	{
-		// Open Stream
-		winrt::check_hresult(pOwner->m_pSensor->OpenStream());
+void SensorManager::initializeSensor(ResearchModeSensorType sensorType)
+{
+	auto pSource = std::make_unique<ResearchModeDepthSource>(sensorType);
+	pSource->initialize();
 
-		while (!pOwner->m_fExit)
-		{
-			IResearchModeSensorFrame* pSensorFrame = nullptr;
+	auto locator = pSource->spatialLocator();
+	setFrameSource(std::move(pSource));
 
-			pOwner->m_pSensor->GetNextBuffer(&pSensorFrame);
+	m_refSpatialLocator = locator;
 
-			if (pSensorFrame) {
-				pOwner->onProcessFrame(pSensorFrame);
-				pSensorFrame->Release();
-			}
-		}
+	// Load the Unit XY Plane of the previous session, so that the first frame does not rebuild it
+	auto localFolder = winrt::Windows::Storage::ApplicationData::Current().LocalFolder();
+	m_strUnitPlaneCachePath = std::wstring(localFolder.Path()) + (sensorType == DEPTH_AHAT ? L"\\DepthUnitXYPlane_AHAT.bin" : L"\\DepthUnitXYPlane_LongThrow.bin");
 
-		if (pOwner->m_pSensor) {
-			pOwner->m_pSensor->CloseStream();
-		}
+	if (UnitPlaneCache::Load(m_strUnitPlaneCachePath, *m_pSource, m_matExtrinsic, m_nPrevFrameRes, m_vecUnitXYPlane))
+	{
+#ifdef _DEBUG
+		OutputDebugString(L"Unit XY Plane loaded from cache\n");
+#endif
 	}
 }
 
-void SensorManager::initializeSensor()
+void SensorManager::setFrameSource(std::unique_ptr<DepthFrameSource> pSource)
 {
-	camConsentGiven = CreateEvent(nullptr, true, false, nullptr);
-
-	HMODULE hrResearchMode = LoadLibraryA("ResearchModeAPI");
-	if (hrResearchMode)
-	{
-		typedef HRESULT(__cdecl* PFN_CREATEPROVIDER) (IResearchModeSensorDevice** ppSensorDevice);
-		PFN_CREATEPROVIDER pfnCreate = reinterpret_cast<PFN_CREATEPROVIDER>(GetProcAddress(hrResearchMode, "CreateResearchModeSensorDevice"));
-		if (pfnCreate)
-		{
-			winrt::check_hresult(pfnCreate(&m_pSensorDevice));
-		}
-		else
-		{
-			winrt::check_hresult(E_INVALIDARG);
-		}
-	}
+	stopSensor();
 
-	winrt::check_hresult(m_pSensorDevice->QueryInterface(IID_PPV_ARGS(&m_pSensorDeviceConsent)));
-	winrt::check_hresult(m_pSensorDeviceConsent->RequestCamAccessAsync(_camAccessOnComplete));
+	m_pSource = std::move(pSource);
+	m_refSpatialLocator = nullptr;
 
-	// This call makes cameras run at full frame rate. Normaly they are optimized 
-	// for headtracker use. For some applications that may be sufficient 
-	m_pSensorDevice->DisableEyeSelection();
+	// Force to rebuild Unit XY Plane on the first frame
+	m_nPrevFrameRes = { 0, 0 };
+	m_nPrevFrameTicks = 0;
+	m_vecUnitXYPlane.clear();
+	m_strUnitPlaneCachePath.clear();
+	m_pLazyTable.reset();
+	m_pImageProjection.reset();
 
-	// Get Depth Sensor
-	winrt::check_hresult(m_pSensorDevice->GetSensor(DEPTH_LONG_THROW, &m_pSensor));
-	winrt::check_hresult(m_pSensor->QueryInterface(IID_PPV_ARGS(&m_pCameraSensor)));
+	if (!m_pSource) { return; }
 
 	// Get Extrinsic
 	DirectX::XMMATRIX rigPoseToCameraNode;
 	DirectX::XMMATRIX cameraNodeToRigPose;
 	DirectX::XMVECTOR det;
 
-	m_pCameraSensor->GetCameraExtrinsicsMatrix(&m_matExtrinsic);
+	m_pSource->getCameraExtrinsics(&m_matExtrinsic);
 
 	rigPoseToCameraNode = DirectX::XMLoadFloat4x4(&m_matExtrinsic);
 	det = DirectX::XMMatrixDeterminant(rigPoseToCameraNode);
 	cameraNodeToRigPose = DirectX::XMMatrixInverse(&det, rigPoseToCameraNode);
 
 	DirectX::XMStoreFloat4x4(&m_matInvExtrinsic, cameraNodeToRigPose);
-
-	// Spatial Locator
-	IResearchModeSensorDevicePerception* pSensorDevicePerception = nullptr;
-	GUID guid;
-
-	winrt::check_hresult(m_pSensorDevice->QueryInterface(IID_PPV_ARGS(&pSensorDevicePerception)));
-	winrt::check_hresult(pSensorDevicePerception->GetRigNodeId(&guid));
-	m_refSpatialLocator = SpatialGraphInteropPreview::CreateLocatorForNode(guid);
-	pSensorDevicePerception->Release();
 }
 
 void SensorManager::startSensor()
@@ -164,131 +108,493 @@ void SensorManager::stopSensor()
 	if (m_pSensorThread)
 	{
 		if (m_pSensorThread->joinable()) {
-			m_fExit = true;
+			{
+				std::lock_guard lock(m_hConsumeMutex);
+				m_fExit = true;
+			}
+			m_cvConsumed.notify_all();
+			if (m_pSource) { m_pSource->interrupt(); }
 			m_pSensorThread->join();
 		}
-		m_fDataUpdated = false;
+		m_tbPointCloud.discard();
 		// Cleanup thread context
 		delete m_pSensorThread;
 		m_pSensorThread = nullptr;
 	}
 }
 
-bool SensorManager::getUpdatedData(_Out_ std::vector<DirectX::XMFLOAT3>& buffer, _Out_ long long& timestamp)
+PointCloudFrameRef SensorManager::acquireLatestFrame()
 {
-	std::lock_guard lock(m_hDataMutex);
-	if (!m_fDataUpdated) { return false; }
+	PointCloudFrameRef* pFrame = m_tbPointCloud.acquire();
+	if (!pFrame) { return PointCloudFrameRef(); }
 
-	// Copy Point Cloud
-	buffer.clear();
-	buffer.assign(m_vecPointCloud.begin(), m_vecPointCloud.end());
+	// Wake a deferred depth frame (the lock orders this with the sensor thread's predicate check)
+	{
+		std::lock_guard lock(m_hConsumeMutex);
+	}
+	m_cvConsumed.notify_one();
 
-	// Copy Timestamp
-	timestamp = m_nPrevTimestamp;
-	m_fDataUpdated = false;
+	return *pFrame;
+}
 
-	return true;
+SensorManager::FrameStatistics SensorManager::getFrameStatistics() const
+{
+	FrameStatistics stat;
+	stat.processedCount = m_nProcessedCount.load(std::memory_order_relaxed);
+	stat.wastedCount = m_nWastedCount.load(std::memory_order_relaxed);
+	stat.skippedCount = m_nSkippedCount.load(std::memory_order_relaxed);
+	stat.deferredCount = m_nDeferredCount.load(std::memory_order_relaxed);
+	return stat;
 }
 
-void SensorManager::onProcessFrame(IResearchModeSensorFrame* pSensorFrame)
+void SensorManager::setUnprojectionThreadCount(uint32_t threadCount)
 {
-	ResearchModeSensorResolution resolution;
-	ResearchModeSensorTimestamp  timestamp;
+	if (threadCount < 1) {
+		threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+	m_nUnprojectionThreads = threadCount;
+}
 
-	IResearchModeSensorDepthFrame* pDepthFrame = nullptr;
-	const UINT16* pAbImage = nullptr;
-	const UINT16* pDepth = nullptr;
+void SensorManager::setFlyingPixelFilter(bool enabled, UINT16 minJump, float relativeJump)
+{
+	if (relativeJump < 0.0f) {
+		throw std::invalid_argument("SensorManager::setFlyingPixelFilter(): relative jump must not be negative");
+	}
+	m_nFlyingPixelMinJump = minJump;
+	m_fFlyingPixelRelativeJump = relativeJump;
+	m_fFlyingPixelFilter = enabled;
+}
+
+void SensorManager::setVoxelSize(float voxelSize)
+{
+	if (voxelSize < 0.0f) {
+		throw std::invalid_argument("SensorManager::setVoxelSize(): voxel size must not be negative");
+	}
+	m_fVoxelSize = voxelSize;
+}
+
+void SensorManager::setMotionCompensation(std::shared_ptr<const ImuStream> pImu, UINT64 readoutTicks)
+{
+	std::lock_guard lock(m_hImuMutex);
+	m_pImuStream = std::move(pImu);
+	m_nReadoutTicks = readoutTicks;
+}
+
+void SensorManager::startRecording(const std::wstring& path, winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem)
+{
+	std::lock_guard lock(m_hRecordMutex);
+	m_pRecorder.reset();
+	m_strPendingRecordPath = path;
+	m_refRecordCoordinateSystem = coordinateSystem;
+}
+
+size_t SensorManager::stopRecording()
+{
+	std::unique_ptr<DepthRecordingWriter> pRecorder;
+	{
+		std::lock_guard lock(m_hRecordMutex);
+		pRecorder = std::move(m_pRecorder);
+		m_strPendingRecordPath.clear();
+		m_refRecordCoordinateSystem = nullptr;
+	}
+	if (!pRecorder) { return 0; }
 
-	// sigma buffer needed only for Long Throw
-	const BYTE* pSigma = nullptr;
+	pRecorder->finish();
+	return pRecorder->frameCount();
+}
 
-	// invalidation mask for Long Throw
-	constexpr USHORT mask = 0x80;
+void SensorManager::startAccumulation(winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem, const PointAccumulator::Settings& settings)
+{
+	// Throws here, the sensor thread applies validated settings only
+	PointAccumulator::ValidateSettings(settings);
 
-	// assert( m_pSensor->GetSensorType() == DEPTH_LONG_THROW );
+	std::lock_guard lock(m_hAccumMutex);
+	m_refAccumCoordinateSystem = coordinateSystem;
+	m_accumSettings = settings;
+	m_fAccumReset = true;
+}
 
-	HRESULT hr = S_OK;
-	size_t outBufferCount;
+void SensorManager::stopAccumulation()
+{
+	std::lock_guard lock(m_hAccumMutex);
+	m_refAccumCoordinateSystem = nullptr;
+	m_fAccumReset = true;
+}
+
+bool SensorManager::waitForConsumer(const DepthFrame& frame)
+{
+	// Frame period of the stream, bounds how long a depth frame is held back
+	const long long frameTicks = static_cast<long long>(frame.hostTicks);
+	const long long periodTicks = m_nPrevFrameTicks > 0 ? frameTicks - m_nPrevFrameTicks : 0;
+	m_nPrevFrameTicks = frameTicks;
 
-	pSensorFrame->GetResolution(&resolution);
-	pSensorFrame->GetTimeStamp(&timestamp);
+	const BackPressurePolicy policy = m_backPressurePolicy;
+	if (policy == BACK_PRESSURE_NONE || !m_tbPointCloud.hasUpdate()) { return true; }
 
-	hr = pSensorFrame->QueryInterface(IID_PPV_ARGS(&pDepthFrame));
-	if (SUCCEEDED(hr))
+	if (policy == BACK_PRESSURE_DEFER)
 	{
-		// extract sigma buffer for Long Throw
-		hr = pDepthFrame->GetSigmaBuffer(&pSigma, &outBufferCount);
+		m_nDeferredCount.fetch_add(1, std::memory_order_relaxed);
 
-		// extract depth buffer
-		hr = pDepthFrame->GetBuffer(&pDepth, &outBufferCount);
+		constexpr long long MIN_DEFER_TICKS = 10'000;    // 1 ms
+		constexpr long long MAX_DEFER_TICKS = 2'500'000; // 250 ms
+		const HundredsOfNanoseconds timeout((std::min)((std::max)(periodTicks, MIN_DEFER_TICKS), MAX_DEFER_TICKS));
+
+		std::unique_lock lock(m_hConsumeMutex);
+		if (m_cvConsumed.wait_for(lock, timeout, [this] { return m_fExit || !m_tbPointCloud.hasUpdate(); }) && !m_fExit) {
+			return true;
+		}
+		// The consumer did not catch up within a frame period, a newer depth frame is due
+	}
 
-		// outBufferCount == (resolution.Width * resolution.Height)
-		if (resolution.Width != m_nPrevFrameRes.x || resolution.Height != m_nPrevFrameRes.y)
+	m_nSkippedCount.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void SensorManager::onProcessFrame(const DepthFrame& frame)
+{
+	const long long frameTicks = static_cast<long long>(frame.hostTicks);
+	if (m_pLatencyTracer) { m_pLatencyTracer->stamp(frameTicks, LATENCY_STAGE_ACQUIRED); }
+
+	// outBufferCount == (frame.width * frame.height)
+	if (frame.width != m_nPrevFrameRes.x || frame.height != m_nPrevFrameRes.y)
+	{
+		m_nPrevFrameRes.x = frame.width;
+		m_nPrevFrameRes.y = frame.height;
+
+#ifdef _DEBUG
 		{
-			m_nPrevFrameRes.x = resolution.Width;
-			m_nPrevFrameRes.y = resolution.Height;
+			std::wostringstream wss;
+			wss << "Res: " << frame.width << ", " << frame.height << std::endl;
 
+			OutputDebugString(wss.str().c_str());
+		}
+#endif
+		UnitPlaneCache::Build(*m_pSource, frame.width, frame.height, m_vecUnitXYPlane);
+		m_pLazyTable.reset();
+		m_pImageProjection.reset();
 #ifdef _DEBUG
-			{
-				std::wostringstream wss;
-				wss << "Res: " << resolution.Width << ", " << resolution.Height << std::endl;
-				wss << "BufCnt: " << outBufferCount << std::endl;
+		m_fVerifyUnprojection = true;
+#endif
 
-				OutputDebugString(wss.str().c_str());
-			}
+		if (!m_strUnitPlaneCachePath.empty() && !UnitPlaneCache::Save(m_strUnitPlaneCachePath, *m_pSource, m_matExtrinsic, m_nPrevFrameRes, m_vecUnitXYPlane))
+		{
+#ifdef _DEBUG
+			OutputDebugString(L"Failed to save Unit XY Plane cache\n");
 #endif
-			m_vecUnitXYPlane.clear();
-			m_vecUnitXYPlane.reserve(resolution.Width * resolution.Height);
-			
-			for (UINT v = 0; v < resolution.Height; v++)
-			{
-				for (UINT u = 0; u < resolution.Width; u++)
-				{
-					float uv[2] = { static_cast<float>(u) + 0.5f, static_cast<float>(v) + 0.5f };
-					float xy[2] = { 0, 0 };
-					m_pCameraSensor->MapImagePointToCameraUnitPlane(uv, xy);
+		}
+	}
 
-					float depthAdjust = sqrt(1.0f + xy[0] * xy[0] + xy[1] * xy[1]); // sqrt( x*x + y*y + z*z ) where z = 1
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
 
-					m_vecUnitXYPlane.emplace_back(DirectX::XMFLOAT4(xy[0], xy[1], depthAdjust, 1.0f / depthAdjust));
-				}
-			}
+	recordFrame(frame);
+
+	// Filtered depth has sigma mask and depth limit applied, invalid pixels are 0
+	DepthFrame source = frame;
+	if (m_fFlyingPixelFilter)
+	{
+		m_flyingPixelFilter.setThreshold(m_nFlyingPixelMinJump, m_fFlyingPixelRelativeJump);
+		source.pDepth = m_flyingPixelFilter.apply(frame);
+		source.pSigma = nullptr;
+		source.maxValidDepth = DEPTH_MAX_VALID_ANY;
+	}
+
+	// Release the stale frame left in the back slot, so that the pool can recycle it right away.
+	m_tbPointCloud.back().reset();
+
+	PointCloudFrameRef target = m_framePool.acquire(pixelCount);
+	if (!target)
+	{
+		// Every frame is still held by consumers, drop this one.
+#ifdef _DEBUG
+		OutputDebugString(L"Point cloud frame pool exhausted, frame dropped\n");
+#endif
+		return;
+	}
+
+	if (m_fLazy && !isAccumulating())
+	{
+		if (!m_pLazyTable) {
+			m_pLazyTable = LazyUnprojectionTable::Build(m_vecUnitXYPlane.data(), frame.width, frame.height);
+		}
+		target->lazyDepth.assign(m_pLazyTable, source.pDepth, source.pSigma, source.maxValidDepth);
+	}
+	else
+	{
+		unprojectFrame(frame, source, *target);
+	}
+
+	// assert(frame.hostTicks <= LLONG_MAX);
+	target->timestamp = frameTicks;
+	target->hasRigPose = frame.pRigPose != nullptr;
+	if (frame.pRigPose) { target->rigPose = *frame.pRigPose; }
+
+	if (m_pLatencyTracer) { m_pLatencyTracer->stamp(frameTicks, LATENCY_STAGE_UNPROJECTED); }
+
+	// Stamped before the frame is visible, the render thread may stamp CONSUMED as soon as it is published
+	if (m_pLatencyTracer) { m_pLatencyTracer->stamp(frameTicks, LATENCY_STAGE_PUBLISHED); }
+
+	// Update Here!!
+	m_tbPointCloud.back() = std::move(target);
+	if (!m_tbPointCloud.publish()) {
+		m_nWastedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_nProcessedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SensorManager::unprojectFrame(const DepthFrame& frame, const DepthFrame& source, PointCloudFrame& target)
+{
+	const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+
+	// Resizing a recycled buffer neither allocates nor clears memory
+	target.points.resize(pixelCount);
+
+	// Vectorized unprojection with stream compaction of valid pixels
+	size_t pointCount = 0;
+	const uint32_t threadCount = m_nUnprojectionThreads;
+	if (threadCount > 1) {
+		pointCount = unprojectParallel(target.points.data(), source, threadCount);
+	}
+	else {
+		m_pUnprojectionPool.reset();
+		pointCount = UnprojectDepth(target.points.data(), source.pDepth, source.pSigma, m_vecUnitXYPlane.data(), pixelCount, source.maxValidDepth);
+	}
+
+#ifdef _DEBUG
+	// Once per resolution: the vectorized (and banded) unprojection must match the scalar reference bit for bit
+	if (m_fVerifyUnprojection)
+	{
+		m_fVerifyUnprojection = false;
+		std::vector<DirectX::XMFLOAT3> reference(pixelCount);
+		const size_t referenceCount = UnprojectDepthReference(reference.data(), source.pDepth, source.pSigma, m_vecUnitXYPlane.data(), pixelCount, source.maxValidDepth);
+		if (referenceCount != pointCount || memcmp(reference.data(), target.points.data(), pointCount * sizeof(DirectX::XMFLOAT3)) != 0) {
+			OutputDebugString(L"UnprojectDepth() does not match UnprojectDepthReference()\n");
+		}
+	}
+#endif
+
+	// Optional readout motion compensation, points are still in pixel order here
+	const bool compensated = compensateMotion(source, target.points.data(), pointCount);
+
+	const bool organized = m_fOrganized;
+	if (organized)
+	{
+		target.width = frame.width;
+		target.height = frame.height;
+		target.validMask.resize((pixelCount + 7) / 8);
+		target.pixelToIndex.resize(pixelCount);
+		BuildPixelIndexMap(target.validMask.data(), target.pixelToIndex.data(), source.pDepth, source.pSigma, pixelCount, source.maxValidDepth);
+
+		// Also rebuilt if the unit plane was loaded from the cache of another resolution
+		if (!m_pImageProjection || m_pImageProjection->width != frame.width || m_pImageProjection->height != frame.height) {
+			m_pImageProjection = DepthImageProjection::Build(m_vecUnitXYPlane.data(), frame.width, frame.height);
+		}
+		// Rotated points are no longer on the ray of their pixel
+		target.imageProjection = compensated ? nullptr : m_pImageProjection;
+	}
+
+	// Optional downsampling, in place
+	const float voxelSize = m_fVoxelSize;
+	if (voxelSize > 0.0f && !organized)
+	{
+		m_voxelFilter.setVoxelSize(voxelSize);
+		m_voxelFilter.setMode(m_voxelMode);
+		pointCount = m_voxelFilter.apply(target.points.data(), target.points.data(), pointCount);
+	}
+	target.points.resize(pointCount);
+
+	const bool accumulated = accumulateFrame(frame, target);
+	if (accumulated)
+	{
+		target.width = 0; // pixel grid does not apply to accumulated points
+		target.height = 0;
+		target.imageProjection.reset();
+	}
+
+	if (!accumulated && m_fQuantized)
+	{
+		// The float buffer keeps its capacity as unprojection scratch, consumers read the quantized points
+		target.quantizedPoints.resize(target.points.size());
+		QuantizePoints(target.quantizedPoints.data(), target.points.data(), target.points.size());
+		target.points.clear();
+		target.isQuantized = true;
+	}
+
+	// Indexed where consumers see the points, quantization saturates points beyond 32.767 m
+	if (m_fSpatialIndex)
+	{
+		if (target.isQuantized) {
+			target.gridIndex.build(target.quantizedPoints.data(), target.quantizedPoints.size());
 		}
+		else {
+			target.gridIndex.build(target.points.data(), target.points.size());
+		}
+	}
 
-		std::vector< DirectX::XMFLOAT3 > pointBuffer;
-		pointBuffer.reserve(resolution.Width * resolution.Height);
+	// Copied from what consumers see, i.e. the decoded points of quantized frames
+	if (m_fStructureOfArrays)
+	{
+		const size_t count = target.pointCount();
+		target.pointsX.resize(count);
+		target.pointsY.resize(count);
+		target.pointsZ.resize(count);
+		if (target.isQuantized) {
+			SplitPoints(target.pointsX.data(), target.pointsY.data(), target.pointsZ.data(), target.quantizedPoints.data(), count);
+		}
+		else {
+			SplitPoints(target.pointsX.data(), target.pointsY.data(), target.pointsZ.data(), target.points.data(), count);
+		}
+		target.hasPointsSoA = true;
+	}
+}
 
-		for (UINT v = 0; v < resolution.Height; v++) 
+bool SensorManager::compensateMotion(const DepthFrame& source, DirectX::XMFLOAT3* pPoints, size_t pointCount)
+{
+	std::shared_ptr<const ImuStream> pImu;
+	UINT64 readoutTicks = 0;
+	{
+		std::lock_guard lock(m_hImuMutex);
+		pImu = m_pImuStream;
+		readoutTicks = m_nReadoutTicks;
+	}
+	if (!pImu || readoutTicks == 0 || source.height < 2) { return false; }
+
+	// Gyroscope to CameraNode rotation
+	DirectX::XMMATRIX rigToGyro = DirectX::XMLoadFloat4x4(pImu->getGyroExtrinsicPtr());
+	DirectX::XMVECTOR det = DirectX::XMMatrixDeterminant(rigToGyro);
+	DirectX::XMFLOAT4X4 gyroToCamera;
+	DirectX::XMStoreFloat4x4(&gyroToCamera, DirectX::XMMatrixMultiply(DirectX::XMMatrixInverse(&det, rigToGyro), DirectX::XMLoadFloat4x4(&m_matExtrinsic)));
+	m_imuInterpolator.setTargetFrame(gyroToCamera);
+
+	const UINT64 rowTicks = readoutTicks / (source.height - 1);
+	const UINT64 firstRowTicks = source.hostTicks - rowTicks * (source.height - 1) / 2;
+	m_vecRowRotations.resize(source.height);
+	if (!m_imuInterpolator.getRotations(pImu->gyro(), source.hostTicks, firstRowTicks, rowTicks, source.height, m_vecRowRotations.data())) {
+		return false;
+	}
+
+	size_t n = 0;
+	for (UINT32 v = 0; v < source.height && n < pointCount; v++)
+	{
+		const DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&m_vecRowRotations[v]));
+		const size_t rowBegin = static_cast<size_t>(v) * source.width;
+		for (size_t index = rowBegin; index < rowBegin + source.width; index++)
 		{
-			for (UINT u = 0; u < resolution.Width; u++)
+			// Same predicate as UnprojectDepth()
+			const UINT16 depth = source.pDepth[index];
+			if (depth > 0 && depth <= source.maxValidDepth && !(source.pSigma && ((source.pSigma[index] & DEPTH_SIGMA_INVALID_MASK) > 0)))
 			{
-				UINT index = resolution.Width * v + u;
-				UINT16 depthValue = (pSigma && ((pSigma[index] & mask) > 0)) ? 0 : pDepth[index];
-				if (depthValue > 0) {
-					constexpr float mm2m = 0.001f;
+				DirectX::XMStoreFloat3(&pPoints[n], DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&pPoints[n]), rotation));
+				n++;
+			}
+		}
+	}
+	return true;
+}
 
-					float z = static_cast<float>(depthValue) * m_vecUnitXYPlane[index].w * mm2m;
-					// or static_cast<float>(depthValue) / m_vecUnitXYPlane[index].z;
+size_t SensorManager::unprojectParallel(DirectX::XMFLOAT3* pOut, const DepthFrame& frame, uint32_t threadCount)
+{
+	if (!m_pUnprojectionPool || m_pUnprojectionPool->concurrency() != threadCount) {
+		m_pUnprojectionPool = std::make_unique<WorkStealingPool>(threadCount - 1);
+	}
 
-					// Do not need Flip YZ in here
-					pointBuffer.emplace_back(DirectX::XMFLOAT3( m_vecUnitXYPlane[index].x * z, (m_vecUnitXYPlane[index].y * z), z ));
-				}
-			}
+	return UnprojectDepthParallel(*m_pUnprojectionPool, pOut, frame, m_vecUnitXYPlane.data(), threadCount * BANDS_PER_THREAD, m_vecBandPointCount);
+}
+
+void SensorManager::recordFrame(const DepthFrame& frame)
+{
+	std::lock_guard lock(m_hRecordMutex);
+
+	if (!m_strPendingRecordPath.empty())
+	{
+		std::vector<DirectX::XMFLOAT2> unitPlane;
+		unitPlane.reserve(m_vecUnitXYPlane.size());
+		for (const DirectX::XMFLOAT4& unit : m_vecUnitXYPlane) {
+			unitPlane.emplace_back(unit.x, unit.y);
 		}
 
+		try {
+			m_pRecorder = std::make_unique<DepthRecordingWriter>(m_strPendingRecordPath, frame.width, frame.height, frame.pSigma != nullptr, frame.maxValidDepth, m_matExtrinsic, unitPlane.data());
+		}
+		catch (const winrt::hresult_error&) {
+#ifdef _DEBUG
+			OutputDebugString(L"Failed to create depth recording\n");
+#endif
+		}
+		m_strPendingRecordPath.clear();
+	}
+
+	if (!m_pRecorder) { return; }
+
+	// Replayed frames keep their recorded pose, live frames are located now
+	const DirectX::XMFLOAT4X4* pRigPose = frame.pRigPose;
+	DirectX::XMFLOAT4X4 rigPose;
+	if (!pRigPose && m_refRecordCoordinateSystem && locateRigPose(frame, m_refRecordCoordinateSystem, rigPose)) {
+		pRigPose = &rigPose;
+	}
 
-		// Update Here!!
+	try {
+		m_pRecorder->writeFrame(frame, pRigPose);
+	}
+	catch (...) {
+		// Disk full, resolution change, ... keep what has been written so far
+#ifdef _DEBUG
+		OutputDebugString(L"Depth recording stopped\n");
+#endif
+		m_pRecorder.reset();
+	}
+}
+
+bool SensorManager::locateRigPose(const DepthFrame& frame, winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem, DirectX::XMFLOAT4X4& rigPose) const
+{
+	if (!m_refSpatialLocator) { return false; }
+
+	using namespace winrt::Windows::Foundation::Numerics;
+
+	auto pts = winrt::Windows::Perception::PerceptionTimestampHelper::FromSystemRelativeTargetTime(HundredsOfNanoseconds(frame.hostTicks));
+	auto location = m_refSpatialLocator.TryLocateAtTimestamp(pts, coordinateSystem);
+	if (!location) { return false; }
+
+	float4x4 rigNodeToCoordinateSystem = make_float4x4_from_quaternion(location.Orientation()) * make_float4x4_translation(location.Position());
+	DirectX::XMStoreFloat4x4(&rigPose, DirectX::XMLoadFloat4x4(&rigNodeToCoordinateSystem));
+
+	return true;
+}
+
+bool SensorManager::isAccumulating()
+{
+	std::lock_guard lock(m_hAccumMutex);
+	return m_refAccumCoordinateSystem != nullptr;
+}
+
+bool SensorManager::accumulateFrame(const DepthFrame& frame, PointCloudFrame& target)
+{
+	winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem = nullptr;
+	{
+		std::lock_guard lock(m_hAccumMutex);
+		if (m_fAccumReset)
 		{
-			std::lock_guard lock(m_hDataMutex);
-			m_vecPointCloud.swap(pointBuffer);
-			m_fDataUpdated = true;
-			// assert(timestamp.HostTicks <= LLONG_MAX);
-			m_nPrevTimestamp = static_cast<long long>(timestamp.HostTicks);
+			m_fAccumReset = false;
+			if (m_refAccumCoordinateSystem) { m_accumulator.setSettings(m_accumSettings); }
+			else { m_accumulator.clear(); }
 		}
+		coordinateSystem = m_refAccumCoordinateSystem;
 	}
+	if (!coordinateSystem) { return false; }
 
-	if (pDepthFrame) {
-		pDepthFrame->Release();
-	}
+	// Live frames are located in the accumulation coordinate system, replayed frames use their recorded pose
+	DirectX::XMFLOAT4X4 rigPose;
+	if (frame.pRigPose) { rigPose = *frame.pRigPose; }
+	else if (!locateRigPose(frame, coordinateSystem, rigPose)) { return false; } // publish the single frame
+
+	DirectX::XMFLOAT4X4 cameraToWorld;
+	DirectX::XMStoreFloat4x4(&cameraToWorld, DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&m_matInvExtrinsic), DirectX::XMLoadFloat4x4(&rigPose)));
+
+	m_accumulator.integrate(target.points.data(), target.points.size(), cameraToWorld, frame.hostTicks);
 
-}
\ No newline at end of file
+	// Resizing a recycled buffer neither allocates nor clears memory (unless the accumulation outgrows it)
+	target.points.resize(m_accumulator.voxelCount());
+	target.points.resize(m_accumulator.extract(target.points.data()));
+	target.isWorldSpace = true;
+
+	return true;
+}
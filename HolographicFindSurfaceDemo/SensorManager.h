@@ -4,50 +4,218 @@
 #define _SENSOR_MANAGER_H_
 
 #include "ResearchMode/ResearchModeApi.h"
+#include "LatencyTracer.h"
+#include "Sensor/DepthFrameSource.h"
+#include "Sensor/DepthRecordingFile.h"
+#include "Sensor/FlyingPixelFilter.h"
+#include "Sensor/ImuPoseInterpolator.h"
+#include "Sensor/ImuStream.h"
+#include "Sensor/PointAccumulator.h"
+#include "Sensor/PointCloudFramePool.h"
+#include "Sensor/TripleBuffer.h"
+#include "Sensor/VoxelGridFilter.h"
+#include "Sensor/WorkStealingPool.h"
 
 #include <chrono>
+#include <condition_variable>
 typedef std::chrono::duration<int64_t, std::ratio<1, 10'000'000>> HundredsOfNanoseconds;
 
 namespace HolographicFindSurfaceDemo
 {
 	class SensorManager
 	{
+	public:
+		// What the sensor thread does with a new depth frame while the last published point cloud is not acquired yet
+		enum BackPressurePolicy
+		{
+			BACK_PRESSURE_NONE,  // unproject every frame, replacing the unconsumed one (default, the consumer always gets the newest frame)
+			BACK_PRESSURE_SKIP,  // drop the depth frame and keep the unconsumed one.
+			                     // Saves the unprojection, but a slow consumer gets a frame up to one of its periods older than NONE would give.
+			BACK_PRESSURE_DEFER, // hold the depth frame until the consumer acquires (at most one frame period), then unproject it.
+			                     // The published frame is then up to a frame period older than the newest one.
+		};
+
+		struct FrameStatistics
+		{
+			uint64_t processedCount; // depth frames unprojected and published
+			uint64_t wastedCount;    // published point clouds replaced before they were acquired
+			uint64_t skippedCount;   // depth frames dropped without unprojection
+			uint64_t deferredCount;  // depth frames held back for the consumer (skipped or processed later)
+		};
+
 	private: // Member Variable
 
-		// Research Mode API related...
-		IResearchModeSensorDevice* m_pSensorDevice = nullptr;
-		IResearchModeSensorDeviceConsent* m_pSensorDeviceConsent = nullptr; // Privilige
-		IResearchModeSensor* m_pSensor = nullptr;
-		IResearchModeCameraSensor* m_pCameraSensor = nullptr;
+		// Depth Frame Source (Research Mode sensor, Replay, ...)
+		std::unique_ptr<DepthFrameSource> m_pSource;
 
-		winrt::Windows::Perception::Spatial::SpatialLocator m_refSpatialLocator = nullptr;
+		winrt::Windows::Perception::Spatial::SpatialLocator m_refSpatialLocator = nullptr; // nullptr if the source is not a live sensor
 
 		// Worker Thread
 		std::thread* m_pSensorThread = nullptr;
 		bool m_fExit = false; // Thread Exit Flag
 
-		// PointCloud Data
-		std::mutex m_hDataMutex;
-		std::vector< DirectX::XMFLOAT3 > m_vecPointCloud; // Point Cloud Buffer
-		DirectX::XMUINT2 m_nPrevFrameRes;
-		long long m_nPrevTimestamp = 0;
-		
+		// PointCloud Data (sensor thread -> render thread)
+		// Pool frames: back / middle / front slot, one held by the FindSurface worker, one in its mailbox and a spare.
+		static constexpr uint32_t FRAME_POOL_SIZE = 6;
+		PointCloudFramePool m_framePool{ FRAME_POOL_SIZE };
+		TripleBuffer< PointCloudFrameRef > m_tbPointCloud;
+		DirectX::XMUINT2 m_nPrevFrameRes = { 0, 0 };
+#ifdef _DEBUG
+		bool m_fVerifyUnprojection = false; // compare the next frame with UnprojectDepthReference()
+#endif
+
+		// Back-pressure (consumer -> sensor thread)
+		std::atomic<BackPressurePolicy> m_backPressurePolicy{ BACK_PRESSURE_NONE };
+		std::mutex m_hConsumeMutex;
+		std::condition_variable m_cvConsumed; // signaled by acquireLatestFrame()
+		long long m_nPrevFrameTicks = 0;      // owned by the sensor thread
+		std::atomic<uint64_t> m_nProcessedCount{ 0 };
+		std::atomic<uint64_t> m_nWastedCount{ 0 };
+		std::atomic<uint64_t> m_nSkippedCount{ 0 };
+		std::atomic<uint64_t> m_nDeferredCount{ 0 };
+
+		// Parallel Unprojection (row bands, 1 = run on the sensor thread only)
+		static constexpr uint32_t BANDS_PER_THREAD = 4;
+		std::atomic<uint32_t> m_nUnprojectionThreads{ 1 };
+		std::unique_ptr<WorkStealingPool> m_pUnprojectionPool; // owned by the sensor thread
+		std::vector<size_t> m_vecBandPointCount;
+
+		// Flying pixel removal on the raw depth image
+		std::atomic<bool> m_fFlyingPixelFilter{ true };
+		std::atomic<UINT16> m_nFlyingPixelMinJump{ 25 };       // millimeter
+		std::atomic<float> m_fFlyingPixelRelativeJump{ 0.02f }; // fraction of depth
+		FlyingPixelFilter m_flyingPixelFilter; // owned by the sensor thread
+
+		// Downsampling (voxel size 0 = disabled)
+		std::atomic<float> m_fVoxelSize{ 0.0f };
+		std::atomic<VoxelGridFilter::Mode> m_voxelMode{ VoxelGridFilter::MODE_CENTROID };
+		VoxelGridFilter m_voxelFilter; // owned by the sensor thread
+
+		LatencyTracer* m_pLatencyTracer = nullptr; // optional, not owned
+
+		// Readout motion compensation (guarded by m_hImuMutex)
+		std::mutex m_hImuMutex;
+		std::shared_ptr<const ImuStream> m_pImuStream; // nullptr if disabled
+		UINT64 m_nReadoutTicks = 0;                    // first to last row of the depth image
+		ImuPoseInterpolator m_imuInterpolator;         // owned by the sensor thread
+		std::vector<DirectX::XMFLOAT4> m_vecRowRotations;
+
+		// Quantized mode (int16 millimeter points in PointCloudFrame)
+		std::atomic<bool> m_fQuantized{ false };
+
+		// Lazy mode (depth image in PointCloudFrame, unprojected on demand)
+		std::atomic<bool> m_fLazy{ false };
+		std::shared_ptr<const LazyUnprojectionTable> m_pLazyTable; // built on the first lazy frame of a resolution
+
+		// Spatial index mode (uniform grid in PointCloudFrame)
+		std::atomic<bool> m_fSpatialIndex{ false };
+
+		// Structure of arrays mode (x[], y[], z[] copy in PointCloudFrame)
+		std::atomic<bool> m_fStructureOfArrays{ false };
 
-		bool m_fDataUpdated = false; // Data Updated Flag
+		// Organized mode (pixel grid maps in PointCloudFrame)
+		std::atomic<bool> m_fOrganized{ false };
+		std::shared_ptr<const DepthImageProjection> m_pImageProjection; // built on the first organized frame of a resolution
+
+		// World space accumulation (guarded by m_hAccumMutex)
+		std::mutex m_hAccumMutex;
+		winrt::Windows::Perception::Spatial::SpatialCoordinateSystem m_refAccumCoordinateSystem = nullptr; // nullptr if disabled
+		PointAccumulator::Settings m_accumSettings;
+		bool m_fAccumReset = false;        // settings or coordinate system changed
+		PointAccumulator m_accumulator;    // owned by the sensor thread
+
+		// Recording (raw depth frames to file)
+		std::mutex m_hRecordMutex;
+		std::unique_ptr<DepthRecordingWriter> m_pRecorder;
+		std::wstring m_strPendingRecordPath; // the writer is created on the next frame, once the resolution is known
+		winrt::Windows::Perception::Spatial::SpatialCoordinateSystem m_refRecordCoordinateSystem = nullptr;
 
 		// lazy constant
 		DirectX::XMFLOAT4X4 m_matExtrinsic;    // Extrinsic Matrix (CameraNode to RigPose)
 		DirectX::XMFLOAT4X4 m_matInvExtrinsic; // Inverse Extrnisic Matrix	(CameraNode to RigPose Inverted)
 		
 		std::vector< DirectX::XMFLOAT4 > m_vecUnitXYPlane; // Pre-calculated Unit XY Plane (with Intrinsic Parameter)
+		std::wstring m_strUnitPlaneCachePath; // Persistent Unit XY Plane (empty if not cached)
 
 	public:
-		void initializeSensor();
+		~SensorManager() { stopSensor(); }
+
+		// Use Research Mode depth sensor (DEPTH_LONG_THROW or DEPTH_AHAT) as frame source.
+		// Can be called again to switch sensors, the sensor thread is stopped then.
+		void initializeSensor(ResearchModeSensorType sensorType = DEPTH_LONG_THROW);
+		// Replace frame source (e.g. DepthReplaySource). Stops the sensor thread if it is running.
+		void setFrameSource(std::unique_ptr<DepthFrameSource> pSource);
 
 	public:
 		void startSensor();
 		void stopSensor();
 
+		inline void setBackPressurePolicy(BackPressurePolicy policy) { m_backPressurePolicy = policy; }
+		inline BackPressurePolicy backPressurePolicy() const { return m_backPressurePolicy; }
+
+		// Number of threads unprojecting a frame (including the sensor thread), applied from the next frame.
+		// 0 selects std::thread::hardware_concurrency().
+		void setUnprojectionThreadCount(uint32_t threadCount);
+
+		// Removes pixels whose depth jumps by more than `minJump` (millimeter) + `relativeJump` * depth
+		// to a 4-neighbour, before unprojection. Recordings keep the raw depth. Applied from the next frame.
+		void setFlyingPixelFilter(bool enabled, UINT16 minJump = 25, float relativeJump = 0.02f);
+		inline bool isFlyingPixelFilterEnabled() const { return m_fFlyingPixelFilter; }
+
+		// Voxel grid downsampling of published point clouds, applied from the next frame.
+		// `voxelSize` is the voxel edge length in meter, 0 disables downsampling.
+		void setVoxelSize(float voxelSize);
+		inline float voxelSize() const { return m_fVoxelSize; }
+		inline void setVoxelMode(VoxelGridFilter::Mode mode) { m_voxelMode = mode; }
+
+		// Stamps LATENCY_STAGE_ACQUIRED .. LATENCY_STAGE_PUBLISHED of each frame. Set while the sensor is stopped.
+		inline void setLatencyTracer(LatencyTracer* pTracer) { m_pLatencyTracer = pTracer; }
+
+		// Publishes the pixel grid structure (validity bitmap, pixel -> point index) with each frame.
+		// Downsampling is bypassed while organized, since it breaks the pixel to point correspondence.
+		// Organized frames also carry the inverse unit plane table for image space picking (see ImageSpacePicker).
+		inline void setOrganized(bool organized) { m_fOrganized = organized; }
+		inline bool isOrganized() const { return m_fOrganized; }
+
+		// Publishes a uniform grid over the points with each frame (PointCloudFrame::gridIndex), built on the sensor thread,
+		// so that picking visits the cells along the gaze ray instead of every point. Applied from the next frame.
+		inline void setSpatialIndex(bool enabled) { m_fSpatialIndex = enabled; }
+		inline bool isSpatialIndexEnabled() const { return m_fSpatialIndex; }
+
+		// Publishes a copy of the points as separate x, y, z arrays with each frame, for the vectorized scan of
+		// PickPointSoA(). Costs 12 bytes per point on the sensor thread. Applied from the next frame.
+		inline void setStructureOfArrays(bool enabled) { m_fStructureOfArrays = enabled; }
+		inline bool isStructureOfArraysEnabled() const { return m_fStructureOfArrays; }
+
+		// Publishes the depth image (PointCloudFrame::lazyDepth) instead of points, for consumers that only need
+		// regions around the gaze and the seed point. Frames are unprojected as usual while accumulating.
+		inline void setLazyUnprojection(bool lazy) { m_fLazy = lazy; }
+		inline bool isLazyUnprojection() const { return m_fLazy; }
+
+		// Rotates the points of each depth image row into the camera orientation at the frame timestamp, integrated from
+		// the gyroscope of `pImu`, so that head motion during the readout does not smear the point cloud.
+		// Rows are read out top to bottom over `readoutTicks` (100 ns), centered on the frame timestamp.
+		// Frames the gyroscope does not cover are published uncorrected, lazy frames are never corrected.
+		// nullptr or 0 disables, applied from the next frame.
+		void setMotionCompensation(std::shared_ptr<const ImuStream> pImu, UINT64 readoutTicks);
+
+		// Publishes points as int16 millimeter (PointCloudFrame::quantizedPoints), half the size of float points.
+		// Consumers read them as they are (rendering, picking) or decode what they need. Accumulated (world space) frames stay float.
+		inline void setQuantized(bool quantized) { m_fQuantized = quantized; }
+		inline bool isQuantized() const { return m_fQuantized; }
+
+		// Records raw depth frames to `path` (see DepthRecordingFormat). Rig poses are located in `coordinateSystem`
+		// for live sensors, replayed frames keep their recorded pose. Replaces a recording in progress.
+		void startRecording(const std::wstring& path, winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem);
+		// Finishes the recording and returns the number of frames written.
+		size_t stopRecording();
+
+		// Publishes the rolling accumulation of recent frames in `coordinateSystem` instead of single frames.
+		// Accumulated frames are flagged PointCloudFrame::isWorldSpace. Restarts from scratch if already running.
+		// Throws std::invalid_argument on invalid settings (see PointAccumulator::setSettings()).
+		void startAccumulation(winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem, const PointAccumulator::Settings& settings = PointAccumulator::Settings());
+		void stopAccumulation();
+
 #ifdef _DEBUG
 	public:
 		inline void printThreadDebug() const {
@@ -62,7 +230,12 @@ namespace HolographicFindSurfaceDemo
 
 	public: // Getter
 		inline winrt::Windows::Perception::Spatial::SpatialLocator spatialLocator() const { return m_refSpatialLocator; }
-		bool getUpdatedData(_Out_ std::vector<DirectX::XMFLOAT3>& buffer, _Out_ long long& timestamp);
+		// Returns the latest point cloud frame, or an empty reference if there is no new frame since the last call.
+		// The frame is recycled once every reference to it is released.
+		// Must be called from a single (render) thread.
+		PointCloudFrameRef acquireLatestFrame();
+		inline PointCloudFramePool::Statistics getFramePoolStatistics() const { return m_framePool.getStatistics(); }
+		FrameStatistics getFrameStatistics() const;
 
 		const inline const DirectX::XMFLOAT4X4* getExtrinsicPtr() const { return &m_matExtrinsic; }
 		const inline const DirectX::XMFLOAT4X4* getInvExtrinsicPtr() const { return &m_matInvExtrinsic; }
@@ -70,7 +243,15 @@ namespace HolographicFindSurfaceDemo
 		const inline const DirectX::XMFLOAT4X4* getCameraNodeToRigNode() const { return getInvExtrinsicPtr(); }
 
 	private:
-		void onProcessFrame(IResearchModeSensorFrame* pSensorFrame);
+		bool waitForConsumer(const DepthFrame& frame);
+		void onProcessFrame(const DepthFrame& frame);
+		void recordFrame(const DepthFrame& frame);
+		void unprojectFrame(const DepthFrame& frame, const DepthFrame& source, PointCloudFrame& target);
+		bool compensateMotion(const DepthFrame& source, DirectX::XMFLOAT3* pPoints, size_t pointCount);
+		bool isAccumulating();
+		bool accumulateFrame(const DepthFrame& frame, PointCloudFrame& target);
+		bool locateRigPose(const DepthFrame& frame, winrt::Windows::Perception::Spatial::SpatialCoordinateSystem coordinateSystem, _Out_ DirectX::XMFLOAT4X4& rigPose) const;
+		size_t unprojectParallel(DirectX::XMFLOAT3* pOut, const DepthFrame& frame, uint32_t threadCount);
 
 	private: // Thread Function
 		static void SensorLoopThread(SensorManager* pOwner);